@@ -152,11 +152,15 @@
 //***********************************************FILTER SETTINGS********************************************************
 
 // Gyro Filters
+// FILTER_LP_BIQUAD, FILTER_NOTCH and FILTER_BANDPASS use the q, FILTER_LEAD_LAG places its pole at freq * q
+// FILTER_KALMAN adapts to the gyro noise, it acts like a PT1 at freq when the noise std deviation is 0.05 * q / 0.707 rad/s
 #define GYRO_PASS1_TYPE FILTER_LP_PT3
 #define GYRO_PASS1_FREQ 100
+#define GYRO_PASS1_Q 0.707
 
 #define GYRO_PASS2_TYPE FILTER_NONE
 #define GYRO_PASS2_FREQ 0
+#define GYRO_PASS2_Q 0.707
 
 // Dynamic D term filter
 // a pt1 filter that moves up in cut hz with a parabolic relationship to applied throttle.  The theory here is
@@ -176,9 +180,14 @@
 // Fixed D-Term Filters
 #define DTERM_PASS1_TYPE FILTER_LP_PT1
 #define DTERM_PASS1_FREQ 260
+#define DTERM_PASS1_Q 0.707
 
 #define DTERM_PASS2_TYPE FILTER_NONE
 #define DTERM_PASS2_FREQ 150
+#define DTERM_PASS2_Q 0.707
+
+// RX smoothing, the cutoff follows the measured frame rate
+#define RX_SMOOTHING_TYPE FILTER_LP_PT2
 
 //**********************************************************************************************************************
 //***********************************************MOTOR OUTPUT SETTINGS**************************************************
@@ -197,6 +206,14 @@
 // *************throttle boost - can intensify small throttle imbalances visible in FPV if factor is set too high on brushed or actually rob performance on brushless due to thrust imbalances
 // #define THROTTLE_BOOST 7.0
 
+// *************thrust linearization - props make thrust with roughly the square of rpm, so the same pid output moves the quad
+// *************much less at low throttle than near full throttle.  0 leaves the output linear, 100 fully undoes a square curve.
+// #define THRUST_LINEARIZATION 40.0
+
+// *************vbat sag compensation - raises motor outputs as the battery voltage drops so the quad feels the same from a full
+// *************to an empty pack.  0 disables it, 100 fully compensates relative to a fully charged cell.
+// #define VBAT_SAG_COMPENSATION 100.0
+
 // *************torque boost is a highly eperimental feature and can smoke brushless motors fast.  it is a lpf D term on motor outputs that will accelerate the response
 // *************of the motors when the command to the motors is changing by increasing or decreasing the voltage thats sent.  It differs
 // *************from throttle transient compensation in that it acts on all motor commands - not just throttle changes.  this feature
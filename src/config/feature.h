@@ -1,6 +1,7 @@
 #pragma once
 
 #define USE_GYRO
+// #define USE_GYRO_FIFO
 #define USE_SDCARD
 #define USE_DATA_FLASH
 #define USE_BLACKBOX
@@ -10,6 +11,8 @@
 #define USE_MOTOR_DSHOT
 #define USE_MOTOR_PWM
 
+#define USE_RGB_LED
+
 #ifndef AT32F4
 #define USE_RX_SPI_FRSKY
 #define USE_RX_SPI_FLYSKY
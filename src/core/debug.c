@@ -83,6 +83,11 @@ cbor_result_t cbor_encode_perf_counters(cbor_value_t *enc) {
     CBOR_CHECK_ERROR(res = cbor_encode_str(enc, "current"));
     ENCODE_CYCLES(perf_counters[i].current)
 
+    // the us values above depend on the (over)clock, report it alongside
+    CBOR_CHECK_ERROR(res = cbor_encode_str(enc, "clock_mhz"));
+    const uint32_t clock_mhz = SYS_CLOCK_FREQ_HZ / 1000000;
+    CBOR_CHECK_ERROR(res = cbor_encode_uint32_t(enc, &clock_mhz));
+
     CBOR_CHECK_ERROR(res = cbor_encode_end_indefinite(enc));
   }
 
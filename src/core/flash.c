@@ -68,6 +68,7 @@ void flash_save() {
     const uint32_t size = FLASH_STORAGE_SIZE;
 
     uint8_t buffer[size];
+    memset(buffer, 0, size);
     flash_write_magic(buffer, FMC_MAGIC | FLASH_STORAGE_OFFSET);
     memcpy(buffer + FMC_MAGIC_SIZE, (uint8_t *)&flash_storage, sizeof(flash_storage_t));
     fmc_write_buf(offset, buffer, size);
@@ -196,6 +197,7 @@ void flash_load() {
       failloop(FAILLOOP_FAULT);
     }
   }
+  profile_generation++;
 
   if (flash_compare_magic(VTX_STORAGE_OFFSET, (FMC_MAGIC | VTX_STORAGE_OFFSET))) {
     const uint32_t offset = VTX_STORAGE_OFFSET + FMC_MAGIC_SIZE;
@@ -15,8 +15,15 @@
 #define FLASH_STORAGE_OFFSET (TARGET_STORAGE_OFFSET + TARGET_STORAGE_SIZE)
 #define FLASH_STORAGE_SIZE FLASH_ALIGN(32)
 
+#define FLASH_GYROCAL_VALID 0x6763
+
 typedef struct {
   float accelcal[3];
+
+  // gyro bias of the last full calibration, reused on boot at a similar temperature
+  float gyrocal[3];
+  int16_t gyrocal_temp; // in 0.1 degC
+  uint16_t gyrocal_valid;
 } flash_storage_t;
 
 extern flash_storage_t flash_storage;
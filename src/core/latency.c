@@ -0,0 +1,127 @@
+#include "core/latency.h"
+
+#include "core/project.h"
+#include "driver/time.h"
+#include "util/cbor_helper.h"
+
+latency_counter_t latency_counters[LATENCY_STAGE_MAX];
+
+static const char *latency_stage_names[LATENCY_STAGE_MAX] = {
+    "LATENCY_STAGE_ARRIVAL",
+    "LATENCY_STAGE_DECODE",
+    "LATENCY_STAGE_SMOOTHING",
+    "LATENCY_STAGE_SETPOINT",
+    "LATENCY_STAGE_PID",
+    "LATENCY_STAGE_MOTOR",
+};
+
+static volatile uint32_t arrival_cycles = 0;
+
+// stamps of the frame currently in flight, only the first stamp per stage counts
+static uint32_t frame_cycles[LATENCY_STAGE_MAX];
+static uint32_t frame_stages = 0;
+
+void latency_init() {
+  for (uint32_t i = 0; i < LATENCY_STAGE_MAX; i++) {
+    latency_counters[i].min = UINT32_MAX;
+    latency_counters[i].max = 0;
+    latency_counters[i].current = 0;
+
+    for (uint32_t j = 0; j < LATENCY_BUCKET_MAX; j++) {
+      latency_counters[i].histogram[j] = 0;
+    }
+  }
+  frame_stages = 0;
+}
+
+static void latency_frame_finish() {
+  for (uint32_t i = LATENCY_STAGE_DECODE; i < LATENCY_STAGE_MAX; i++) {
+    if (!(frame_stages & (1 << i))) {
+      continue;
+    }
+
+    latency_counter_t *counter = &latency_counters[i];
+
+    const uint32_t delta = CYCLES_TO_US(frame_cycles[i] - frame_cycles[LATENCY_STAGE_ARRIVAL]);
+    if (delta > counter->max) {
+      counter->max = delta;
+    }
+    if (delta < counter->min) {
+      counter->min = delta;
+    }
+    counter->current = delta;
+
+    const uint32_t bucket = min(delta / LATENCY_BUCKET_US, LATENCY_BUCKET_MAX - 1);
+    counter->histogram[bucket]++;
+  }
+}
+
+void latency_stamp_at(latency_stage_t stage, uint32_t cycles) {
+  switch (stage) {
+  case LATENCY_STAGE_ARRIVAL:
+    // may be called from isr, just remember the time until the frame is decoded
+    arrival_cycles = cycles;
+    break;
+
+  case LATENCY_STAGE_DECODE:
+    // a new frame replaces whatever was still in flight
+    frame_cycles[LATENCY_STAGE_ARRIVAL] = arrival_cycles;
+    frame_cycles[LATENCY_STAGE_DECODE] = cycles;
+    frame_stages = (1 << LATENCY_STAGE_ARRIVAL) | (1 << LATENCY_STAGE_DECODE);
+    break;
+
+  default:
+    if (frame_stages == 0 || (frame_stages & (1 << stage))) {
+      break;
+    }
+
+    frame_cycles[stage] = cycles;
+    frame_stages |= (1 << stage);
+
+    if (stage == LATENCY_STAGE_MOTOR) {
+      latency_frame_finish();
+      frame_stages = 0;
+    }
+    break;
+  }
+}
+
+void latency_stamp(latency_stage_t stage) {
+  latency_stamp_at(stage, time_cycles());
+}
+
+cbor_result_t cbor_encode_latency_counters(cbor_value_t *enc) {
+  CBOR_CHECK_ERROR(cbor_result_t res = cbor_encode_array_indefinite(enc));
+
+  for (uint32_t i = LATENCY_STAGE_DECODE; i < LATENCY_STAGE_MAX; i++) {
+    CBOR_CHECK_ERROR(res = cbor_encode_map_indefinite(enc));
+
+    CBOR_CHECK_ERROR(res = cbor_encode_str(enc, "name"));
+    CBOR_CHECK_ERROR(res = cbor_encode_str(enc, latency_stage_names[i]));
+
+    CBOR_CHECK_ERROR(res = cbor_encode_str(enc, "min"));
+    CBOR_CHECK_ERROR(res = cbor_encode_uint32_t(enc, &latency_counters[i].min));
+
+    CBOR_CHECK_ERROR(res = cbor_encode_str(enc, "max"));
+    CBOR_CHECK_ERROR(res = cbor_encode_uint32_t(enc, &latency_counters[i].max));
+
+    CBOR_CHECK_ERROR(res = cbor_encode_str(enc, "current"));
+    CBOR_CHECK_ERROR(res = cbor_encode_uint32_t(enc, &latency_counters[i].current));
+
+    const uint32_t bucket_us = LATENCY_BUCKET_US;
+    CBOR_CHECK_ERROR(res = cbor_encode_str(enc, "bucket_us"));
+    CBOR_CHECK_ERROR(res = cbor_encode_uint32_t(enc, &bucket_us));
+
+    CBOR_CHECK_ERROR(res = cbor_encode_str(enc, "histogram"));
+    CBOR_CHECK_ERROR(res = cbor_encode_array(enc, LATENCY_BUCKET_MAX));
+    for (uint32_t j = 0; j < LATENCY_BUCKET_MAX; j++) {
+      CBOR_CHECK_ERROR(res = cbor_encode_uint32_t(enc, &latency_counters[i].histogram[j]));
+    }
+
+    CBOR_CHECK_ERROR(res = cbor_encode_end_indefinite(enc));
+  }
+
+  CBOR_CHECK_ERROR(res = cbor_encode_end_indefinite(enc));
+
+  return res;
+}
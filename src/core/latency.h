@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cbor.h>
+#include <stdint.h>
+
+#define LATENCY_BUCKET_US 100
+#define LATENCY_BUCKET_MAX 20
+
+// stages a rx frame passes through on its way to the motors, in order
+typedef enum {
+  LATENCY_STAGE_ARRIVAL,   // last byte on uart or packet on spi
+  LATENCY_STAGE_DECODE,    // channels decoded in rx_update
+  LATENCY_STAGE_SMOOTHING, // rx_apply_smoothing
+  LATENCY_STAGE_SETPOINT,  // control_flight_mode
+  LATENCY_STAGE_PID,       // pid_calc
+  LATENCY_STAGE_MOTOR,     // motor dma started
+
+  LATENCY_STAGE_MAX
+} __attribute__((__packed__)) latency_stage_t;
+
+typedef struct {
+  uint32_t min;
+  uint32_t max;
+  uint32_t current;
+  uint32_t histogram[LATENCY_BUCKET_MAX];
+} latency_counter_t;
+
+// all values in us, relative to LATENCY_STAGE_ARRIVAL
+extern latency_counter_t latency_counters[LATENCY_STAGE_MAX];
+
+void latency_init();
+
+void latency_stamp(latency_stage_t stage);
+void latency_stamp_at(latency_stage_t stage, uint32_t cycles);
+
+cbor_result_t cbor_encode_latency_counters(cbor_value_t *enc);
@@ -4,20 +4,70 @@
 #include "driver/time.h"
 #include "flight/control.h"
 
+// gyro samples per pid loop, the gyro filters run at the full rate
+#ifndef GYRO_PID_DENOM
+#define GYRO_PID_DENOM 1
+#endif
+
 uint8_t looptime_warning = 0;
 
+// gyro samples sit on a fixed grid, they are only this far behind their slot before it is skipped
+#define GYRO_SLOT_TOLERANCE_DIV 4
+
 static uint32_t last_loop_cycles;
+static uint32_t pid_cycle_start;
+static uint32_t busy_cycles;
+
+static uint32_t gyro_slot_cycles; // time of the next gyro slot
+static uint8_t gyro_slots;        // gyro slots passed since the last pid loop
+
+static uint32_t gyro_rate_start;
+static uint32_t gyro_rate_samples;
+
+// splits the pid loop into gyro samples, never sampling faster than 8k
+static void looptime_update_denom() {
+  uint8_t denom = GYRO_PID_DENOM;
+  while (denom > 1 && (state.looptime_autodetect % denom != 0 || state.looptime_autodetect / denom < LOOPTIME_8K)) {
+    denom--;
+  }
+
+  state.pid_denom = denom;
+  state.gyro_looptime_autodetect = state.looptime_autodetect / denom;
+}
 
 void looptime_init() {
   // attempt 8k looptime for f405 or 4k looptime for f411
   state.looptime = LOOPTIME * 1e-6;
   state.looptime_autodetect = LOOPTIME;
+  looptime_update_denom();
 
   looptime_reset();
 }
 
 void looptime_reset() {
   last_loop_cycles = time_cycles();
+  pid_cycle_start = last_loop_cycles;
+  busy_cycles = 0;
+
+  gyro_slot_cycles = last_loop_cycles;
+  // next update starts a new pid loop
+  gyro_slots = state.pid_denom;
+
+  gyro_rate_start = last_loop_cycles;
+  gyro_rate_samples = 0;
+}
+
+static void looptime_update_gyro_rate() {
+  gyro_rate_samples++;
+
+  const uint32_t elapsed = last_loop_cycles - gyro_rate_start;
+  if (elapsed < US_TO_CYCLES(1000000)) {
+    return;
+  }
+
+  state.gyro_rate_hz = (uint64_t)gyro_rate_samples * 1000000 / CYCLES_TO_US(elapsed);
+  gyro_rate_start = last_loop_cycles;
+  gyro_rate_samples = 0;
 }
 
 static void looptime_auto_detect() {
@@ -45,6 +95,7 @@ static void looptime_auto_detect() {
     } else {
       state.looptime_autodetect = LOOPTIME_2K;
     }
+    looptime_update_denom();
 
     loop_counter++;
   }
@@ -65,20 +116,46 @@ static void looptime_auto_detect() {
   }
 }
 
-void looptime_update() {
-  state.cpu_load = CYCLES_TO_US(time_cycles() - last_loop_cycles);
-
-  const uint32_t delay = US_TO_CYCLES(state.looptime_autodetect);
-  while ((time_cycles() - last_loop_cycles) < delay)
+// paces the main loop to the gyro rate, returns true once every pid_denom slots
+// when the rest of the loop (pid, mixer, motors, rx ...) should run
+bool looptime_update() {
+  busy_cycles += time_cycles() - last_loop_cycles;
+
+  const uint32_t period = US_TO_CYCLES(state.gyro_looptime_autodetect);
+  if (state.pid_denom > 1) {
+    // gyro only samples are taken on a fixed grid so the gyro filters see the period they were
+    // designed for. a slot missed by a long pid iteration is skipped, not made up for.
+    while ((int32_t)(time_cycles() - gyro_slot_cycles) > (int32_t)(period / GYRO_SLOT_TOLERANCE_DIV)) {
+      gyro_slot_cycles += period;
+      gyro_slots++;
+    }
+  } else {
+    // gyro and pid run together, a long iteration only pushes the next one back
+    gyro_slot_cycles = last_loop_cycles + period;
+  }
+  while ((int32_t)(time_cycles() - gyro_slot_cycles) < 0)
     __NOP();
 
-  state.looptime_us = CYCLES_TO_US(time_cycles() - last_loop_cycles);
+  last_loop_cycles = time_cycles();
+  gyro_slot_cycles += period;
+  looptime_update_gyro_rate();
+
+  if (gyro_slots < state.pid_denom) {
+    gyro_slots++;
+    return false;
+  }
+  gyro_slots = 1;
+
+  state.cpu_load = CYCLES_TO_US(busy_cycles);
+  busy_cycles = 0;
+
+  state.looptime_us = CYCLES_TO_US(last_loop_cycles - pid_cycle_start);
   state.looptime = state.looptime_us * 1e-6f;
   // 0.0032f is there for legacy purposes, should be 0.001f = looptime
   state.timefactor = 0.0032f / state.looptime;
   state.loop_counter++;
 
-  last_loop_cycles = time_cycles();
+  pid_cycle_start = last_loop_cycles;
 
   // max loop 20ms
   if (state.looptime_us > 20000) {
@@ -91,4 +168,6 @@ void looptime_update() {
   if (flags.arm_state) {
     state.armtime += state.looptime;
   }
-}
\ No newline at end of file
+
+  return true;
+}
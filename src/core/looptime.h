@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 
 typedef enum {
@@ -10,4 +11,4 @@ typedef enum {
 
 void looptime_init();
 void looptime_reset();
-void looptime_update();
+bool looptime_update();
@@ -6,13 +6,16 @@
 #include "core/debug.h"
 #include "core/failloop.h"
 #include "core/flash.h"
+#include "core/latency.h"
 #include "core/looptime.h"
+#include "core/memory.h"
 #include "core/profile.h"
 #include "core/project.h"
 #include "driver/adc.h"
 #include "driver/fmc.h"
 #include "driver/gpio.h"
 #include "driver/motor.h"
+#include "driver/rcc.h"
 #include "driver/reset.h"
 #include "driver/rgb_led.h"
 #include "driver/serial.h"
@@ -43,6 +46,16 @@ __attribute__((__used__)) void memory_section_init() {
   extern uint8_t _fast_ram_data;
   memcpy(&_fast_ram_start, &_fast_ram_data, (size_t)(&_fast_ram_end - &_fast_ram_start));
 #endif
+#ifdef USE_FAST_CODE
+  extern uint8_t _fast_code_start;
+  extern uint8_t _fast_code_end;
+  extern uint8_t _fast_code_data;
+  memcpy(&_fast_code_start, &_fast_code_data, (size_t)(&_fast_code_end - &_fast_code_start));
+
+  // make sure the copied code is visible to instruction fetches
+  __DSB();
+  __ISB();
+#endif
 #ifdef USE_DMA_RAM
   extern uint8_t _dma_ram_start;
   extern uint8_t _dma_ram_end;
@@ -72,7 +85,16 @@ __attribute__((__used__)) void memory_section_init() {
 #endif
 }
 
+// waits until ms have passed since start, work done in the meantime counts towards it
+static void boot_wait(uint32_t start, uint32_t ms) {
+  while ((time_millis() - start) < ms)
+    ;
+}
+
 __attribute__((__used__)) int main() {
+  // fill unused stack so the high-water mark can be found later
+  memory_stack_paint();
+
   // init timer so we can use delays etc
   time_init();
   looptime_init();
@@ -80,6 +102,12 @@ __attribute__((__used__)) int main() {
   // load settings from flash
   flash_load();
 
+  // reclock before any peripheral derives its dividers from the core clock
+  if (rcc_set_clock(target.overclock)) {
+    time_init();
+  }
+  const uint32_t boot_start = time_millis();
+
   // wait for flash to stabilze
   time_delay_us(100);
 
@@ -106,46 +134,56 @@ __attribute__((__used__)) int main() {
   // init motors
   motor_init();
 
+  // the adc is internal, read the battery while external devices wake up
+  adc_init();
+  vbat_init();
+
   // wait for devices to wake up
-  time_delay_ms(300);
+  boot_wait(boot_start, 300);
 
   if (!sixaxis_init()) {
     // gyro not found
     failloop(FAILLOOP_GYRO);
   }
+  const uint32_t gyro_start = time_millis();
 
-  // give the gyro some time to settle
-  time_delay_ms(100);
-
-  // display bootlogo while calibrating
+  // display bootlogo while the gyro settles and calibrates
   osd_init();
-  sixaxis_gyro_cal();
 
-  // wait for adc and vtx to wake up
-  time_delay_ms(100);
+  // give the gyro some time to settle
+  boot_wait(gyro_start, 100);
+
+  sixaxis_gyro_cal_boot();
 
   // send first value to esc
   motor_set_all(MOTOR_OFF);
   motor_update();
 
-  adc_init();
-  vbat_init();
+  // claim the led timer before rx and soft serial grab a free one
+  rgb_init();
 
   rx_init();
+
+  // vtx detection holds off on its own until the vtx is up
   vtx_init();
-  rgb_init();
 
   blackbox_init();
   imu_init();
 
   osd_clear();
   perf_counter_init();
+  latency_init();
+  memory_init();
 
   looptime_reset();
 
   while (1) {
     // updates looptime counters & runs auto detect
-    looptime_update();
+    if (!looptime_update()) {
+      // gyro only iteration, keeps the gyro filters running at the full sample rate
+      sixaxis_read();
+      continue;
+    }
 
     perf_counter_start(PERF_COUNTER_TOTAL);
 
@@ -175,16 +213,15 @@ __attribute__((__used__)) int main() {
     // handle led commands
     led_update();
 
-#if (RGB_LED_NUMBER > 0)
+#ifdef USE_RGB_LED
     // RGB led control
     rgb_led_lvc();
-#ifdef RGB_LED_DMA
     rgb_dma_start();
-#endif
 #endif
 
     buzzer_update();
     vtx_update();
+    memory_update();
 
     perf_counter_end(PERF_COUNTER_MISC);
 
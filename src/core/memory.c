@@ -0,0 +1,149 @@
+#include "core/memory.h"
+
+#include "core/project.h"
+#include "driver/dma.h"
+#include "driver/serial.h"
+#include "driver/usb.h"
+#include "io/blackbox_device.h"
+#include "util/cbor_helper.h"
+
+// words of the stack region checked per memory_update call
+#define MEMORY_SCAN_WORDS 64
+// keep the frames of the caller intact while painting
+#define MEMORY_STACK_MARGIN 64
+
+extern uint8_t _sdata;
+extern uint8_t _edata;
+extern uint8_t _sbss;
+extern uint8_t _ebss;
+extern uint32_t _stack_bottom;
+extern uint32_t _estack;
+
+memory_stats_t memory_stats;
+
+static uint32_t *stack_mark = &_estack;
+static uint32_t *stack_scan = &_stack_bottom;
+
+// the stack grows down from _estack towards _stack_bottom, both come from the linker script
+// as the stack does not sit above static memory on every target (ccm on f405).
+void memory_stack_paint() {
+  const uint32_t sp = __get_MSP() - MEMORY_STACK_MARGIN;
+  for (volatile uint32_t *ptr = &_stack_bottom; (uint32_t)ptr < sp; ptr++) {
+    *ptr = MEMORY_STACK_PATTERN;
+  }
+}
+
+static void memory_update_dma() {
+  dma_mem_stats_t stats;
+  dma_mem_stats(&stats);
+
+  memory_stats.dma_pool_size = stats.size;
+  memory_stats.dma_pool_used = stats.used;
+  memory_stats.dma_pool_peak = stats.peak;
+  memory_stats.dma_pool_free = stats.free;
+}
+
+void memory_init() {
+  memory_stats.data_size = &_edata - &_sdata;
+  memory_stats.bss_size = &_ebss - &_sbss;
+
+#ifdef USE_FAST_RAM
+  extern uint8_t _fast_ram_start;
+  extern uint8_t _fast_ram_end;
+  memory_stats.fast_ram_size = &_fast_ram_end - &_fast_ram_start;
+#endif
+#ifdef USE_DMA_RAM
+  extern uint8_t _dma_ram_start;
+  extern uint8_t _dma_ram_end;
+  memory_stats.dma_ram_size = &_dma_ram_end - &_dma_ram_start;
+#endif
+#ifdef USE_FAST_CODE
+  extern uint8_t _fast_code_start;
+  extern uint8_t _fast_code_end;
+  memory_stats.fast_code_size = &_fast_code_end - &_fast_code_start;
+#endif
+
+  memory_stats.stack_size = (uint32_t)&_estack - (uint32_t)&_stack_bottom;
+
+  stack_mark = &_estack;
+  stack_scan = &_stack_bottom;
+  memory_update_dma();
+}
+
+// walks the painted region from the bottom in small chunks, the first touched word is the high-water mark.
+// only the part below the last mark has to be checked as the peak can not shrink.
+void memory_update() {
+  for (uint32_t i = 0; i < MEMORY_SCAN_WORDS; i++) {
+    if (stack_scan >= stack_mark) {
+      stack_scan = &_stack_bottom;
+      memory_update_dma();
+      return;
+    }
+
+    if (*stack_scan != MEMORY_STACK_PATTERN) {
+      stack_mark = stack_scan;
+      memory_stats.stack_peak = (uint32_t)&_estack - (uint32_t)stack_mark;
+
+      stack_scan = &_stack_bottom;
+      memory_update_dma();
+      return;
+    }
+
+    stack_scan++;
+  }
+}
+
+#define MEMBER CBOR_ENCODE_MEMBER
+
+CBOR_START_STRUCT_ENCODER(memory_stats_t)
+MEMORY_STATS_MEMBERS
+CBOR_END_STRUCT_ENCODER()
+
+#undef MEMBER
+
+static cbor_result_t cbor_encode_ring_buffer_usage(cbor_value_t *enc, const char *name, ring_buffer_t *buffer) {
+  cbor_result_t res = CBOR_OK;
+  if (buffer == NULL) {
+    // port was never initialized
+    return res;
+  }
+
+  CBOR_CHECK_ERROR(res = cbor_encode_str(enc, name));
+  CBOR_CHECK_ERROR(res = cbor_encode_map_indefinite(enc));
+
+  CBOR_CHECK_ERROR(res = cbor_encode_str(enc, "size"));
+  CBOR_CHECK_ERROR(res = cbor_encode_uint32_t(enc, &buffer->size));
+
+  CBOR_CHECK_ERROR(res = cbor_encode_str(enc, "peak"));
+  CBOR_CHECK_ERROR(res = cbor_encode_uint32_t(enc, &buffer->peak));
+
+  return cbor_encode_end_indefinite(enc);
+}
+
+cbor_result_t cbor_encode_memory_stats(cbor_value_t *enc) {
+  cbor_result_t res = CBOR_OK;
+
+  CBOR_CHECK_ERROR(res = cbor_encode_map_indefinite(enc));
+
+  CBOR_CHECK_ERROR(res = cbor_encode_str(enc, "stats"));
+  CBOR_CHECK_ERROR(res = cbor_encode_memory_stats_t(enc, &memory_stats));
+
+  CBOR_CHECK_ERROR(res = cbor_encode_str(enc, "ring_buffers"));
+  CBOR_CHECK_ERROR(res = cbor_encode_map_indefinite(enc));
+
+  CBOR_CHECK_ERROR(res = cbor_encode_ring_buffer_usage(enc, "serial_rx_rx", serial_rx.rx_buffer));
+  CBOR_CHECK_ERROR(res = cbor_encode_ring_buffer_usage(enc, "serial_rx_tx", serial_rx.tx_buffer));
+  CBOR_CHECK_ERROR(res = cbor_encode_ring_buffer_usage(enc, "serial_vtx_rx", serial_vtx.rx_buffer));
+  CBOR_CHECK_ERROR(res = cbor_encode_ring_buffer_usage(enc, "serial_vtx_tx", serial_vtx.tx_buffer));
+  CBOR_CHECK_ERROR(res = cbor_encode_ring_buffer_usage(enc, "serial_hdzero_rx", serial_hdzero.rx_buffer));
+  CBOR_CHECK_ERROR(res = cbor_encode_ring_buffer_usage(enc, "serial_hdzero_tx", serial_hdzero.tx_buffer));
+  CBOR_CHECK_ERROR(res = cbor_encode_ring_buffer_usage(enc, "usb_rx", &usb_rx_buffer));
+  CBOR_CHECK_ERROR(res = cbor_encode_ring_buffer_usage(enc, "usb_tx", &usb_tx_buffer));
+#ifdef USE_BLACKBOX
+  CBOR_CHECK_ERROR(res = cbor_encode_ring_buffer_usage(enc, "blackbox_encode", &blackbox_encode_buffer));
+#endif
+
+  CBOR_CHECK_ERROR(res = cbor_encode_end_indefinite(enc));
+
+  return cbor_encode_end_indefinite(enc);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cbor.h>
+#include <stdint.h>
+
+#define MEMORY_STACK_PATTERN 0xA5A5A5A5
+
+typedef struct {
+  uint32_t data_size;
+  uint32_t bss_size;
+  uint32_t fast_ram_size;
+  uint32_t dma_ram_size;
+  uint32_t fast_code_size;
+
+  uint32_t stack_size; // bytes between the linker provided stack bottom and the top of the stack
+  uint32_t stack_peak; // stack high-water mark in bytes
+
+  uint32_t dma_pool_size;
+  uint32_t dma_pool_used;
+  uint32_t dma_pool_peak;
+  uint32_t dma_pool_free; // bytes held by freed blocks that are not yet returned to the pool
+} memory_stats_t;
+
+#define MEMORY_STATS_MEMBERS       \
+  MEMBER(data_size, uint32_t)      \
+  MEMBER(bss_size, uint32_t)       \
+  MEMBER(fast_ram_size, uint32_t)  \
+  MEMBER(dma_ram_size, uint32_t)   \
+  MEMBER(fast_code_size, uint32_t) \
+  MEMBER(stack_size, uint32_t)     \
+  MEMBER(stack_peak, uint32_t)     \
+  MEMBER(dma_pool_size, uint32_t)  \
+  MEMBER(dma_pool_used, uint32_t)  \
+  MEMBER(dma_pool_peak, uint32_t)  \
+  MEMBER(dma_pool_free, uint32_t)
+
+extern memory_stats_t memory_stats;
+
+void memory_stack_paint();
+void memory_init();
+void memory_update();
+
+cbor_result_t cbor_encode_memory_stats(cbor_value_t *enc);
@@ -126,6 +126,78 @@ const pid_rate_preset_t pid_rate_presets[] = {
 };
 
 const uint32_t pid_rate_presets_count = sizeof(pid_rate_presets) / sizeof(pid_rate_preset_t);
+
+// rows are {roll, pitch, yaw, throttle}, the first four motors follow motor_position_t (BL, FL, BR, FR)
+#define MOTOR_MIXER_QUAD_X              \
+  {+1.0f, +1.0f, +1.0f, 1.0f}, /* BL */ \
+  {+1.0f, -1.0f, -1.0f, 1.0f}, /* FL */ \
+  {-1.0f, +1.0f, -1.0f, 1.0f}, /* BR */ \
+  {-1.0f, -1.0f, +1.0f, 1.0f}, /* FR */
+
+#define MOTOR_MIXER_QUAD_PLUS              \
+  {+0.0f, +1.0f, +1.0f, 1.0f}, /* BACK */  \
+  {+1.0f, +0.0f, -1.0f, 1.0f}, /* LEFT */  \
+  {-1.0f, +0.0f, -1.0f, 1.0f}, /* RIGHT */ \
+  {+0.0f, -1.0f, +1.0f, 1.0f}, /* FRONT */
+
+const motor_mixer_preset_t motor_mixer_presets[] = {
+    {
+        .index = 0,
+        .name = "Quad X",
+        .motor_count = 4,
+        .mixer = {MOTOR_MIXER_QUAD_X},
+    },
+    {
+        .index = 1,
+        .name = "Quad +",
+        .motor_count = 4,
+        .mixer = {MOTOR_MIXER_QUAD_PLUS},
+    },
+    {
+        .index = 2,
+        .name = "Hex X",
+        .motor_count = 6,
+        .mixer = {
+            {+0.5f, +0.866025f, -1.0f, 1.0f}, // BL
+            {+0.5f, -0.866025f, -1.0f, 1.0f}, // FL
+            {-0.5f, +0.866025f, +1.0f, 1.0f}, // BR
+            {-0.5f, -0.866025f, +1.0f, 1.0f}, // FR
+            {-1.0f, +0.0f, -1.0f, 1.0f},      // RIGHT
+            {+1.0f, +0.0f, +1.0f, 1.0f},      // LEFT
+        },
+    },
+    {
+        .index = 3,
+        .name = "Octo Flat X",
+        .motor_count = 8,
+        .mixer = {
+            {+0.414214f, +1.0f, +1.0f, 1.0f}, // BL
+            {+0.414214f, -1.0f, -1.0f, 1.0f}, // FL
+            {-0.414214f, +1.0f, -1.0f, 1.0f}, // BR
+            {-0.414214f, -1.0f, +1.0f, 1.0f}, // FR
+            {-1.0f, -0.414214f, -1.0f, 1.0f}, // RIGHT FRONT
+            {+1.0f, -0.414214f, +1.0f, 1.0f}, // LEFT FRONT
+            {-1.0f, +0.414214f, +1.0f, 1.0f}, // RIGHT BACK
+            {+1.0f, +0.414214f, -1.0f, 1.0f}, // LEFT BACK
+        },
+    },
+    {
+        .index = 4,
+        .name = "Octo X8",
+        .motor_count = 8,
+        .mixer = {
+            // top props
+            MOTOR_MIXER_QUAD_X
+            // bottom props, spinning the other way
+            {+1.0f, +1.0f, -1.0f, 1.0f}, // BL
+            {+1.0f, -1.0f, +1.0f, 1.0f}, // FL
+            {-1.0f, +1.0f, +1.0f, 1.0f}, // BR
+            {-1.0f, -1.0f, -1.0f, 1.0f}, // FR
+        },
+    },
+};
+
+const uint32_t motor_mixer_presets_count = sizeof(motor_mixer_presets) / sizeof(motor_mixer_preset_t);
 const profile_t default_profile = {
     .meta = {
         .name = "default",
@@ -151,6 +223,16 @@ const profile_t default_profile = {
         .throttle_boost = THROTTLE_BOOST,
 #else
         .throttle_boost = 0.0,
+#endif
+#ifdef THRUST_LINEARIZATION
+        .thrust_linearization = THRUST_LINEARIZATION,
+#else
+        .thrust_linearization = 0.0,
+#endif
+#ifdef VBAT_SAG_COMPENSATION
+        .vbat_sag_compensation = VBAT_SAG_COMPENSATION,
+#else
+        .vbat_sag_compensation = 0.0,
 #endif
         .gyro_orientation = GYRO_ROTATE_NONE,
         .motor_pins = {
@@ -158,8 +240,18 @@ const profile_t default_profile = {
             MOTOR_PIN1,
             MOTOR_PIN2,
             MOTOR_PIN3,
+            MOTOR_PIN4,
+            MOTOR_PIN5,
+            MOTOR_PIN6,
+            MOTOR_PIN7,
         },
         .turtle_throttle_percent = 10.0f,
+        .motor_count = 4,
+#ifdef MOTOR_PLUS_CONFIGURATION
+        .mixer = {MOTOR_MIXER_QUAD_PLUS},
+#else
+        .mixer = {MOTOR_MIXER_QUAD_X},
+#endif
     },
 
     .serial = {
@@ -185,10 +277,12 @@ const profile_t default_profile = {
             {
                 .type = GYRO_PASS1_TYPE,
                 .cutoff_freq = GYRO_PASS1_FREQ,
+                .q = GYRO_PASS1_Q,
             },
             {
                 .type = GYRO_PASS2_TYPE,
                 .cutoff_freq = GYRO_PASS2_FREQ,
+                .q = GYRO_PASS2_Q,
             },
         },
 
@@ -196,10 +290,12 @@ const profile_t default_profile = {
             {
                 .type = DTERM_PASS1_TYPE,
                 .cutoff_freq = DTERM_PASS1_FREQ,
+                .q = DTERM_PASS1_Q,
             },
             {
                 .type = DTERM_PASS2_TYPE,
                 .cutoff_freq = DTERM_PASS2_FREQ,
+                .q = DTERM_PASS2_Q,
             },
         },
 
@@ -334,15 +430,20 @@ const profile_t default_profile = {
             // and stick acceleration will remain constant regardless of stick position.  Positive values up to 1 will represent a transition where stick acceleration at it's maximum at full
             // stick deflection and is reduced by whatever percentage you enter here at stick center.  For example accelerator at 1 and transition at .3 means that there will be 30% reduction
             // of acceleration at stick center, and acceleration strength of 1 at full stick.
+            //
+            // stickFeedforward adds the rate of change of the interpolated setpoint straight to the pid output, scaled like the D gain.
+            // It reacts to stick movement without waiting for an error to build up.  Start around 20 and raise it until stick snaps overshoot.
             {
                 // pid profile A	Roll  PITCH  YAW
                 .accelerator = {0.0, 0.0, 0.0}, // keep values between 0 and 2.5
                 .transition = {0.0, 0.0, 0.0},  // keep values between -1 and 1
+                .feedforward = {0.0, 0.0, 0.0}, // keep values between 0 and 100
             },
             {
                 // pid profile B	Roll  PITCH  YAW
                 .accelerator = {1.5, 1.5, 1.0}, // keep values between 0 and 2.5
                 .transition = {0.3, 0.3, 0.0},  // keep values between -1 and 1
+                .feedforward = {0.0, 0.0, 0.0}, // keep values between 0 and 100
             },
         },
         //**************************** ANGLE PIDS - used in level mode to set leveling strength
@@ -446,6 +547,7 @@ const profile_t default_profile = {
             ENCODE_OSD_ELEMENT(1, 0, 1, 13),  // OSD_THROTTLE
             ENCODE_OSD_ELEMENT(0, 0, 1, 1),   // OSD_VTX_CHANNEL
             ENCODE_OSD_ELEMENT(1, 0, 1, 14),  // OSD_CURRENT_DRAW
+            ENCODE_OSD_ELEMENT(0, 0, 1, 2),   // OSD_MEMORY
         },
         .elements_hd = {
             ENCODE_OSD_ELEMENT(1, 1, 19, 0),  // OSD_CALLSIGN
@@ -460,6 +562,7 @@ const profile_t default_profile = {
             ENCODE_OSD_ELEMENT(1, 0, 0, 16),  // OSD_THROTTLE
             ENCODE_OSD_ELEMENT(0, 0, 0, 0),   // OSD_VTX_CHANNEL
             ENCODE_OSD_ELEMENT(1, 0, 0, 17),  // OSD_CURRENT_DRAW
+            ENCODE_OSD_ELEMENT(0, 0, 0, 1),   // OSD_MEMORY
         },
     },
     .blackbox = {
@@ -471,6 +574,7 @@ const profile_t default_profile = {
 
 // the actual profile
 FAST_RAM profile_t profile;
+uint32_t profile_generation = 0;
 
 void profile_set_defaults() {
   memcpy(&profile, &default_profile, sizeof(profile_t));
@@ -535,6 +639,7 @@ VOLTAGE_MEMBERS
 PID_RATE_MEMBERS
 ANGLE_PID_RATE_MEMBERS
 PID_RATE_PRESET_MEMBERS
+MOTOR_MIXER_PRESET_MEMBERS
 STICK_RATE_MEMBERS
 DTERM_ATTENUATION_MEMBERS
 PID_MEMBERS
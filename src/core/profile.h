@@ -118,12 +118,14 @@ typedef enum {
 typedef struct {
   vec3_t accelerator;
   vec3_t transition;
+  vec3_t feedforward;
 } stick_rate_t;
 
 #define STICK_RATE_MEMBERS    \
   START_STRUCT(stick_rate_t)  \
   MEMBER(accelerator, vec3_t) \
   MEMBER(transition, vec3_t)  \
+  MEMBER(feedforward, vec3_t) \
   END_STRUCT()
 
 typedef enum {
@@ -186,6 +188,7 @@ typedef enum {
   DSHOT_TIME_150 = 150,
   DSHOT_TIME_300 = 300,
   DSHOT_TIME_600 = 600,
+  DSHOT_TIME_1200 = 1200,
 } __attribute__((__packed__)) dshot_time_t;
 
 typedef struct {
@@ -196,8 +199,12 @@ typedef struct {
   uint8_t gyro_orientation;
   float torque_boost;
   float throttle_boost;
+  float thrust_linearization;  // percent of the quadratic prop thrust curve to undo
+  float vbat_sag_compensation; // percent of the battery sag to make up for
   motor_pin_t motor_pins[MOTOR_PIN_MAX];
   float turtle_throttle_percent;
+  uint8_t motor_count;
+  vec4_t mixer[MOTOR_PIN_MAX]; // per motor roll, pitch, yaw and throttle weights
 } profile_motor_t;
 
 #define MOTOR_MEMBERS                              \
@@ -209,8 +216,27 @@ typedef struct {
   MEMBER(gyro_orientation, uint8_t)                \
   MEMBER(torque_boost, float)                      \
   MEMBER(throttle_boost, float)                    \
+  MEMBER(thrust_linearization, float)              \
+  MEMBER(vbat_sag_compensation, float)             \
   ARRAY_MEMBER(motor_pins, MOTOR_PIN_MAX, uint8_t) \
   MEMBER(turtle_throttle_percent, float)           \
+  MEMBER(motor_count, uint8_t)                     \
+  ARRAY_MEMBER(mixer, MOTOR_PIN_MAX, vec4_t)       \
+  END_STRUCT()
+
+typedef struct {
+  uint32_t index;
+  const char *name;
+  uint8_t motor_count;
+  vec4_t mixer[MOTOR_PIN_MAX];
+} motor_mixer_preset_t;
+
+#define MOTOR_MIXER_PRESET_MEMBERS           \
+  START_STRUCT(motor_mixer_preset_t)         \
+  MEMBER(index, uint32_t)                    \
+  STR_MEMBER(name)                           \
+  MEMBER(motor_count, uint8_t)               \
+  ARRAY_MEMBER(mixer, MOTOR_PIN_MAX, vec4_t) \
   END_STRUCT()
 
 typedef enum {
@@ -298,12 +324,14 @@ typedef struct {
 typedef struct {
   filter_type_t type;
   float cutoff_freq;
+  float q; // biquad q or lead-lag pole ratio, unused by the pt filters
 } profile_filter_parameter_t;
 
 #define FILTER_PARAMETER_MEMBERS           \
   START_STRUCT(profile_filter_parameter_t) \
   MEMBER(type, uint8_t)                    \
   MEMBER(cutoff_freq, float)               \
+  MEMBER(q, float)                         \
   END_STRUCT()
 
 typedef struct {
@@ -383,6 +411,8 @@ typedef struct {
   END_STRUCT()
 
 extern profile_t profile;
+// bumped by every writer of the profile, lets users of it cache derived values
+extern uint32_t profile_generation;
 extern const profile_t default_profile;
 
 extern const pid_rate_preset_t pid_rate_presets[];
@@ -391,6 +421,9 @@ extern const uint32_t pid_rate_presets_count;
 extern const blackbox_preset_t blackbox_presets[];
 extern const uint32_t blackbox_presets_count;
 
+extern const motor_mixer_preset_t motor_mixer_presets[];
+extern const uint32_t motor_mixer_presets_count;
+
 void blackbox_preset_apply(const blackbox_preset_t *preset, profile_blackbox_t *profile);
 uint8_t blackbox_preset_equals(const blackbox_preset_t *preset, profile_blackbox_t *profile);
 
@@ -405,3 +438,4 @@ cbor_result_t cbor_encode_blackbox_preset_t(cbor_value_t *enc, const blackbox_pr
 cbor_result_t cbor_decode_blackbox_preset_t(cbor_value_t *dec, blackbox_preset_t *p);
 
 cbor_result_t cbor_encode_pid_rate_preset_t(cbor_value_t *enc, const pid_rate_preset_t *p);
+cbor_result_t cbor_encode_motor_mixer_preset_t(cbor_value_t *enc, const motor_mixer_preset_t *p);
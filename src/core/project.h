@@ -19,6 +19,12 @@
 #define FAST_RAM
 #endif
 
+#ifdef USE_FAST_CODE
+#define FAST_CODE __attribute__((section(".fast_code"), noinline))
+#else
+#define FAST_CODE
+#endif
+
 #ifdef USE_DMA_RAM
 #define DMA_RAM __attribute__((section(".dma_ram"), aligned(32)))
 #else
@@ -29,6 +29,7 @@ target_info_t target_info = {
     },
 
     .gyro_id = 0x0,
+    .gyro2_id = 0x0,
 };
 
 #define START_STRUCT CBOR_START_STRUCT_ENCODER
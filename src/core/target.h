@@ -22,6 +22,10 @@ typedef enum {
   MOTOR_PIN1,
   MOTOR_PIN2,
   MOTOR_PIN3,
+  MOTOR_PIN4,
+  MOTOR_PIN5,
+  MOTOR_PIN6,
+  MOTOR_PIN7,
   MOTOR_PIN_MAX
 } __attribute__((__packed__)) motor_pin_t;
 
@@ -125,6 +129,8 @@ typedef struct {
   MEMBER(nss, gpio_pins_t)          \
   END_STRUCT()
 
+#define GYRO_MAX 2
+
 typedef struct {
   spi_ports_t port;
   gpio_pins_t nss;
@@ -167,6 +173,7 @@ typedef struct {
   uint8_t name[32];
 
   bool brushless;
+  uint8_t overclock; // rcc_clock_t, applied at boot
 
   target_led_t leds[LED_MAX];
   target_serial_port_t serial_ports[SERIAL_PORT_MAX];
@@ -175,6 +182,8 @@ typedef struct {
 
   target_gyro_spi_device_t gyro;
   uint8_t gyro_orientation;
+  target_gyro_spi_device_t gyro2;
+  uint8_t gyro2_orientation; // relative to the first gyro
   target_spi_device_t osd;
   target_spi_device_t flash;
   target_spi_device_t sdcard;
@@ -187,6 +196,7 @@ typedef struct {
 
   target_invert_pin_t sdcard_detect;
   target_invert_pin_t buzzer;
+  gpio_pins_t rgb_led;
   gpio_pins_t motor_pins[MOTOR_PIN_MAX];
 
   uint16_t vbat_scale;
@@ -197,12 +207,15 @@ typedef struct {
   START_STRUCT(target_t)                                                         \
   TSTR_MEMBER(name, 32)                                                          \
   MEMBER(brushless, bool)                                                        \
+  MEMBER(overclock, uint8_t)                                                     \
   ARRAY_MEMBER(leds, LED_MAX, target_led_t)                                      \
   INDEX_ARRAY_MEMBER(serial_ports, SERIAL_PORT_MAX, target_serial_port_t)        \
   INDEX_ARRAY_MEMBER(serial_soft_ports, SERIAL_SOFT_COUNT, target_serial_port_t) \
   INDEX_ARRAY_MEMBER(spi_ports, SPI_PORT_MAX, target_spi_port_t)                 \
   MEMBER(gyro, target_gyro_spi_device_t)                                         \
   MEMBER(gyro_orientation, uint8_t)                                              \
+  MEMBER(gyro2, target_gyro_spi_device_t)                                        \
+  MEMBER(gyro2_orientation, uint8_t)                                             \
   MEMBER(osd, target_spi_device_t)                                               \
   MEMBER(flash, target_spi_device_t)                                             \
   MEMBER(sdcard, target_spi_device_t)                                            \
@@ -213,6 +226,7 @@ typedef struct {
   MEMBER(ibat, gpio_pins_t)                                                      \
   MEMBER(sdcard_detect, target_invert_pin_t)                                     \
   MEMBER(buzzer, target_invert_pin_t)                                            \
+  MEMBER(rgb_led, gpio_pins_t)                                                   \
   ARRAY_MEMBER(motor_pins, MOTOR_PIN_MAX, gpio_pins_t)                           \
   MEMBER(vbat_scale, uint16_t)                                                   \
   MEMBER(ibat_scale, uint16_t)                                                   \
@@ -234,6 +248,7 @@ typedef struct {
   rx_protocol_t rx_protocols[RX_PROTOCOL_MAX];
 
   uint8_t gyro_id;
+  uint8_t gyro2_id;
 } target_info_t;
 
 #define TARGET_INFO_MEMBERS                            \
@@ -244,6 +259,7 @@ typedef struct {
   MEMBER(features, uint32_t)                           \
   ARRAY_MEMBER(rx_protocols, RX_PROTOCOL_MAX, uint8_t) \
   MEMBER(gyro_id, uint8_t)                             \
+  MEMBER(gyro2_id, uint8_t)                            \
   END_STRUCT()
 
 extern target_t target;
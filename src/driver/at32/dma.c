@@ -11,6 +11,9 @@
 #define DMAMUX_DMAREQ_ID_TIM1_CH2 DMAMUX_DMAREQ_ID_TMR1_CH2
 #define DMAMUX_DMAREQ_ID_TIM1_CH3 DMAMUX_DMAREQ_ID_TMR1_CH3
 #define DMAMUX_DMAREQ_ID_TIM1_CH4 DMAMUX_DMAREQ_ID_TMR1_CH3
+#define DMAMUX_DMAREQ_ID_TIM8_CH4 DMAMUX_DMAREQ_ID_TMR8_CH4
+#define DMAMUX_DMAREQ_ID_TIM2_UP DMAMUX_DMAREQ_ID_TMR2_OVERFLOW
+#define DMAMUX_DMAREQ_ID_TIM3_UP DMAMUX_DMAREQ_ID_TMR3_OVERFLOW
 
 #define DMA_STREAMS          \
   DMA_STREAM(1, 1, SPI1_RX)  \
@@ -23,7 +26,10 @@
   DMA_STREAM(2, 2, SPI4_TX)  \
   DMA_STREAM(2, 3, TIM1_CH1) \
   DMA_STREAM(2, 4, TIM1_CH3) \
-  DMA_STREAM(2, 5, TIM1_CH4)
+  DMA_STREAM(2, 5, TIM1_CH4) \
+  DMA_STREAM(2, 6, TIM8_CH4) \
+  DMA_STREAM(1, 7, TIM2_UP)  \
+  DMA_STREAM(2, 7, TIM3_UP)
 
 #define DMA_STREAM(_port, _chan, _dev)           \
   [DMA_DEVICE_##_dev] = {                        \
@@ -47,6 +53,18 @@ void dma_prepare_tx_memory(void *addr, uint32_t size) {
 void dma_prepare_rx_memory(void *addr, uint32_t size) {
 }
 
+void dma_finish_rx_memory(void *addr, uint32_t size) {
+}
+
+// no data cache, but the spi drivers keep using the pool here
+bool dma_can_use_tx_memory(const void *addr, uint32_t size) {
+  return false;
+}
+
+bool dma_can_use_rx_memory(void *addr, uint32_t size) {
+  return false;
+}
+
 void dma_enable_rcc(dma_device_t dev) {
   const dma_stream_def_t *dma = &dma_stream_defs[dev];
   switch (dma->port_index) {
@@ -83,6 +101,7 @@ void dma_clear_flag_tc(dma_device_t dev) {
 
 extern void dshot_dma_isr(dma_device_t dev);
 extern void spi_dma_isr(dma_device_t dev);
+extern void rgb_dma_isr(dma_device_t dev);
 
 static void handle_dma_stream_isr(dma_device_t dev) {
   switch (dev) {
@@ -99,8 +118,16 @@ static void handle_dma_stream_isr(dma_device_t dev) {
   case DMA_DEVICE_TIM1_CH1:
   case DMA_DEVICE_TIM1_CH3:
   case DMA_DEVICE_TIM1_CH4:
+  case DMA_DEVICE_TIM8_CH4:
 #ifdef USE_MOTOR_DSHOT
     dshot_dma_isr(dev);
+#endif
+    break;
+  case DMA_DEVICE_TIM2_UP:
+  case DMA_DEVICE_TIM3_UP:
+  case DMA_DEVICE_TIM4_UP:
+#ifdef USE_RGB_LED
+    rgb_dma_isr(dev);
 #endif
     break;
   case DMA_DEVICE_MAX:
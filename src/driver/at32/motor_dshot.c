@@ -2,20 +2,24 @@
 
 #include <stdint.h>
 
+#include "core/failloop.h"
 #include "core/profile.h"
 #include "core/project.h"
 #include "driver/dma.h"
 #include "driver/gpio.h"
 #include "driver/interrupt.h"
 #include "driver/rcc.h"
+#include "driver/rgb_led.h"
 #include "driver/spi.h"
+#include "driver/timer.h"
 
 #ifdef USE_MOTOR_DSHOT
 
 #define DSHOT_TIME profile.motor.dshot_time
 #define DSHOT_SYMBOL_TIME (PWM_CLOCK_FREQ_HZ / (3 * DSHOT_TIME * 1000) - 1)
 
-#define DSHOT_MAX_PORT_COUNT 3
+// tmr8 paces the fourth gpio port
+#define DSHOT_MAX_PORT_COUNT 4
 #define DSHOT_DMA_BUFFER_SIZE (3 * (16 + 2))
 
 typedef struct {
@@ -31,6 +35,7 @@ typedef struct {
   uint32_t port_low;  // motor pins for BSRRL, for setting pins low
   uint32_t port_high; // motor pins for BSRRH, for setting pins high
 
+  timer_index_t timer;
   uint32_t timer_channel;
   dma_device_t dma_device;
 } dshot_gpio_port_t;
@@ -43,22 +48,37 @@ volatile uint32_t dshot_dma_phase = 0; // 0: idle, 1 - (gpio_port_count + 1): ha
 static uint8_t gpio_port_count = 0;
 static dshot_gpio_port_t gpio_ports[DSHOT_MAX_PORT_COUNT] = {
     {
+        .timer = TIMER1,
         .timer_channel = TMR_SELECT_CHANNEL_1,
         .dma_device = DMA_DEVICE_TIM1_CH1,
     },
     {
+        .timer = TIMER1,
         .timer_channel = TMR_SELECT_CHANNEL_3,
         .dma_device = DMA_DEVICE_TIM1_CH3,
     },
     {
+        .timer = TIMER1,
         .timer_channel = TMR_SELECT_CHANNEL_4,
         .dma_device = DMA_DEVICE_TIM1_CH4,
     },
+    {
+        .timer = TIMER8,
+        .timer_channel = TMR_SELECT_CHANNEL_4,
+        .dma_device = DMA_DEVICE_TIM8_CH4,
+    },
 };
 static volatile DMA_RAM uint32_t port_dma_buffer[DSHOT_MAX_PORT_COUNT][DSHOT_DMA_BUFFER_SIZE];
 static dshot_pin_t dshot_pins[MOTOR_PIN_MAX];
 
 static void dshot_init_motor_pin(uint32_t index) {
+  if (target.motor_pins[index] == PIN_NONE) {
+    dshot_pins[index].port = NULL;
+    dshot_pins[index].pin = 0;
+    dshot_pins[index].dshot_port = 0;
+    return;
+  }
+
   dshot_pins[index].port = gpio_pin_defs[target.motor_pins[index]].port;
   dshot_pins[index].pin = gpio_pin_defs[target.motor_pins[index]].pin;
   dshot_pins[index].dshot_port = 0;
@@ -100,8 +120,9 @@ static void dshot_init_gpio_port(dshot_gpio_port_t *port) {
   tim_oc_init.oc_idle_state = TRUE;
   tim_oc_init.oc_polarity = TMR_OUTPUT_ACTIVE_LOW;
   tim_oc_init.oc_output_state = TRUE;
-  tmr_output_channel_config(TMR1, port->timer_channel, &tim_oc_init);
-  tmr_output_channel_buffer_enable(TMR1, port->timer_channel, TRUE);
+  timer_dev_t *tim = timer_defs[port->timer].instance;
+  tmr_output_channel_config(tim, port->timer_channel, &tim_oc_init);
+  tmr_output_channel_buffer_enable(tim, port->timer_channel, TRUE);
 
   const dma_stream_def_t *dma = &dma_stream_defs[port->dma_device];
 
@@ -125,37 +146,54 @@ static void dshot_init_gpio_port(dshot_gpio_port_t *port) {
   interrupt_enable(dma->irq, DMA_PRIORITY);
 }
 
-static void dshot_enable_dma_request(uint32_t timer_channel, confirm_state new_state) {
-  switch (timer_channel) {
+static void dshot_enable_dma_request(const dshot_gpio_port_t *port, confirm_state new_state) {
+  timer_dev_t *tim = timer_defs[port->timer].instance;
+  switch (port->timer_channel) {
   case TMR_SELECT_CHANNEL_1:
-    tmr_dma_request_enable(TMR1, TMR_C1_DMA_REQUEST, new_state);
+    tmr_dma_request_enable(tim, TMR_C1_DMA_REQUEST, new_state);
     break;
   case TMR_SELECT_CHANNEL_3:
-    tmr_dma_request_enable(TMR1, TMR_C3_DMA_REQUEST, new_state);
+    tmr_dma_request_enable(tim, TMR_C3_DMA_REQUEST, new_state);
     break;
   case TMR_SELECT_CHANNEL_4:
-    tmr_dma_request_enable(TMR1, TMR_C4_DMA_REQUEST, new_state);
+    tmr_dma_request_enable(tim, TMR_C4_DMA_REQUEST, new_state);
     break;
   default:
     break;
   }
 }
 
+static void dshot_init_timer(timer_index_t timer) {
+  timer_dev_t *tim = timer_defs[timer].instance;
+  rcc_enable(timer_defs[timer].rcc);
+
+  // setup timer to 1/3 of the full bit time
+  tmr_base_init(tim, DSHOT_SYMBOL_TIME, 0);
+  tmr_clock_source_div_set(tim, TMR_CLOCK_DIV1);
+  tmr_cnt_dir_set(tim, TMR_COUNT_UP);
+  tmr_period_buffer_enable(tim, TRUE);
+}
+
 void motor_dshot_init() {
   gpio_port_count = 0;
 
-  rcc_enable(RCC_ENCODE(TMR1));
-
-  // setup timer to 1/3 of the full bit time
-  tmr_base_init(TMR1, DSHOT_SYMBOL_TIME, 0);
-  tmr_clock_source_div_set(TMR1, TMR_CLOCK_DIV1);
-  tmr_cnt_dir_set(TMR1, TMR_COUNT_UP);
-  tmr_period_buffer_enable(TMR1, TRUE);
+  if (!timer_alloc_tag(TIMER_USE_MOTOR_DSHOT, TIMER_TAG(TIMER1, TIMER_CH1 | TIMER_CH3 | TIMER_CH4))) {
+    failloop(FAILLOOP_FAULT);
+  }
+  dshot_init_timer(TIMER1);
 
   for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
     dshot_init_motor_pin(i);
   }
 
+  // only claim tmr8 if the motor pins are spread over more than three ports
+  if (gpio_port_count == DSHOT_MAX_PORT_COUNT) {
+    if (!timer_alloc_tag(TIMER_USE_MOTOR_DSHOT, TIMER_TAG(TIMER8, TIMER_CH4))) {
+      failloop(FAILLOOP_FAULT);
+    }
+    dshot_init_timer(TIMER8);
+  }
+
   for (uint32_t j = 0; j < gpio_port_count; j++) {
     dshot_init_gpio_port(&gpio_ports[j]);
 
@@ -167,6 +205,9 @@ void motor_dshot_init() {
   }
 
   tmr_counter_enable(TMR1, TRUE);
+  if (gpio_port_count == DSHOT_MAX_PORT_COUNT) {
+    tmr_counter_enable(TMR8, TRUE);
+  }
   motor_dir = MOTOR_FORWARD;
 }
 
@@ -181,11 +222,11 @@ static void dshot_dma_setup_port(uint32_t index) {
   dma->channel->dtcnt = DSHOT_DMA_BUFFER_SIZE;
 
   dma_channel_enable(dma->channel, TRUE);
-  dshot_enable_dma_request(port->timer_channel, TRUE);
+  dshot_enable_dma_request(port, TRUE);
 }
 
 // make dshot dma packet, then fire
-void dshot_dma_start() {
+FAST_CODE void dshot_dma_start() {
   motor_wait_for_ready();
 
   for (uint32_t j = 0; j < gpio_port_count; j++) {
@@ -207,6 +248,10 @@ void dshot_dma_start() {
     }
 
     for (uint8_t motor = 0; motor < MOTOR_PIN_MAX; motor++) {
+      if (dshot_pins[motor].port == NULL) {
+        continue;
+      }
+
       const uint32_t port = dshot_pins[motor].dshot_port;
       const uint32_t motor_high = (dshot_pins[motor].pin);
       const uint32_t motor_low = (dshot_pins[motor].pin << 16);
@@ -245,9 +290,16 @@ void dshot_dma_isr(dma_device_t dev) {
 
     const dma_stream_def_t *dma = &dma_stream_defs[dev];
     dma_channel_enable(dma->channel, FALSE);
-    dshot_enable_dma_request(port->timer_channel, FALSE);
+    dshot_enable_dma_request(port, FALSE);
 
     dshot_dma_phase--;
+
+#ifdef USE_RGB_LED
+    if (dshot_dma_phase == 0) {
+      // motor frame is out, the led strip can use the rest of the loop
+      rgb_dma_fire();
+    }
+#endif
     break;
   }
 }
@@ -2,4 +2,9 @@
 
 void rcc_enable(rcc_reg_t reg) {
   crm_periph_clock_enable(reg, TRUE);
+}
+
+// the at32f435 already runs at its rated 288mhz
+bool rcc_set_clock(rcc_clock_t clock) {
+  return false;
 }
\ No newline at end of file
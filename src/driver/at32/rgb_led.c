@@ -0,0 +1,154 @@
+#include "driver/rgb_led.h"
+
+#include <stdbool.h>
+
+#include "core/project.h"
+#include "driver/dma.h"
+#include "driver/gpio.h"
+#include "driver/interrupt.h"
+#include "driver/timer.h"
+
+#ifdef USE_RGB_LED
+
+extern volatile uint32_t rgb_dma_buffer[RGB_DMA_BUFFER_SIZE];
+
+static resource_tag_t timer_tag = 0;
+static dma_device_t dma_device = DMA_DEVICE_MAX;
+
+// the overflow request streams the next compare value into the buffered cxdt
+static dma_device_t rgb_timer_dma_device(timer_index_t tim) {
+  switch (tim) {
+  case TIMER2:
+    return DMA_DEVICE_TIM2_UP;
+  case TIMER3:
+    return DMA_DEVICE_TIM3_UP;
+  default:
+    return DMA_DEVICE_MAX;
+  }
+}
+
+static volatile uint32_t *rgb_timer_cdt(timer_dev_t *tim, timer_channel_t ch) {
+  switch (ch) {
+  case TIMER_CH1:
+  case TIMER_CH1N:
+    return &tim->c1dt;
+  case TIMER_CH2:
+  case TIMER_CH2N:
+    return &tim->c2dt;
+  case TIMER_CH3:
+  case TIMER_CH3N:
+    return &tim->c3dt;
+  case TIMER_CH4:
+  default:
+    return &tim->c4dt;
+  }
+}
+
+bool rgb_dma_init() {
+  gpio_config_t gpio_init;
+  gpio_init.mode = GPIO_ALTERNATE;
+  gpio_init.drive = GPIO_DRIVE_HIGH;
+  gpio_init.output = GPIO_PUSHPULL;
+  gpio_init.pull = GPIO_NO_PULL;
+
+  timer_tag = 0;
+  dma_device = DMA_DEVICE_MAX;
+
+  for (uint32_t j = 0; j < GPIO_AF_MAX; j++) {
+    const gpio_af_t *func = &gpio_pin_afs[j];
+    if (func->pin != target.rgb_led || RESOURCE_TAG_TYPE(func->tag) != RESOURCE_TIM) {
+      continue;
+    }
+
+    const dma_device_t dev = rgb_timer_dma_device(TIMER_TAG_TIM(func->tag));
+    if (dev == DMA_DEVICE_MAX) {
+      continue;
+    }
+
+    if (timer_alloc_tag(TIMER_USE_RGB_LED, func->tag)) {
+      timer_tag = func->tag;
+      dma_device = dev;
+      gpio_pin_init_af(target.rgb_led, gpio_init, func->af);
+      break;
+    }
+  }
+
+  if (timer_tag == 0) {
+    return false;
+  }
+
+  const timer_index_t tim = TIMER_TAG_TIM(timer_tag);
+  const timer_channel_t ch = TIMER_TAG_CH(timer_tag);
+  timer_dev_t *instance = timer_defs[tim].instance;
+
+  tmr_counter_enable(instance, FALSE);
+
+  timer_up_init(tim, 1, RGB_BIT_TIME);
+
+  tmr_output_config_type tim_oc_init;
+  tmr_output_default_para_init(&tim_oc_init);
+  tim_oc_init.oc_mode = TMR_OUTPUT_CONTROL_PWM_MODE_A;
+  tim_oc_init.oc_idle_state = FALSE;
+  tim_oc_init.oc_polarity = TMR_OUTPUT_ACTIVE_HIGH;
+  tim_oc_init.oc_output_state = TRUE;
+  tmr_output_channel_config(instance, timer_channel_val(ch), &tim_oc_init);
+  tmr_channel_value_set(instance, timer_channel_val(ch), 0);
+  tmr_output_channel_buffer_enable(instance, timer_channel_val(ch), TRUE);
+
+  const dma_stream_def_t *dma = &dma_stream_defs[dma_device];
+  dma_enable_rcc(dma_device);
+
+  dma_reset(dma->channel);
+  dmamux_init(dma->mux, dma->request);
+
+  dma_init_type init;
+  init.peripheral_base_addr = (uint32_t)rgb_timer_cdt(instance, ch);
+  init.memory_base_addr = (uint32_t)rgb_dma_buffer;
+  init.direction = DMA_DIR_MEMORY_TO_PERIPHERAL;
+  init.buffer_size = RGB_DMA_BUFFER_SIZE;
+  init.peripheral_inc_enable = FALSE;
+  init.memory_inc_enable = TRUE;
+  init.peripheral_data_width = DMA_PERIPHERAL_DATA_WIDTH_WORD;
+  init.memory_data_width = DMA_MEMORY_DATA_WIDTH_WORD;
+  init.loop_mode_enable = FALSE;
+  // dshot and spi always win the arbitration
+  init.priority = DMA_PRIORITY_LOW;
+  dma_init(dma->channel, &init);
+  dma_interrupt_enable(dma->channel, DMA_FDT_INT, TRUE);
+
+  interrupt_enable(dma->irq, DMA_PRIORITY);
+
+  // the counter free-runs with a zero compare, keeping the line low between frames
+  tmr_output_enable(instance, TRUE);
+  tmr_counter_enable(instance, TRUE);
+
+  return true;
+}
+
+void rgb_dma_trigger() {
+  const dma_stream_def_t *dma = &dma_stream_defs[dma_device];
+
+  dma_clear_flag_tc(dma_device);
+
+  dma->channel->maddr = (uint32_t)rgb_dma_buffer;
+  dma->channel->dtcnt = RGB_DMA_BUFFER_SIZE;
+
+  dma_channel_enable(dma->channel, TRUE);
+  tmr_dma_request_enable(timer_defs[TIMER_TAG_TIM(timer_tag)].instance, TMR_OVERFLOW_DMA_REQUEST, TRUE);
+}
+
+void rgb_dma_isr(dma_device_t dev) {
+  if (dev != dma_device) {
+    return;
+  }
+
+  dma_clear_flag_tc(dev);
+
+  const dma_stream_def_t *dma = &dma_stream_defs[dev];
+  dma_channel_enable(dma->channel, FALSE);
+  tmr_dma_request_enable(timer_defs[TIMER_TAG_TIM(timer_tag)].instance, TMR_OVERFLOW_DMA_REQUEST, FALSE);
+
+  rgb_dma_done();
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include "driver/serial.h"
 
 #include "driver/serial_soft.h"
+#include "driver/time.h"
 
 const usart_port_def_t usart_port_defs[SERIAL_PORT_MAX] = {
     {},
@@ -107,6 +108,7 @@ void serial_hard_init(serial_port_t *serial, serial_port_config_t config, bool s
 
   usart_interrupt_enable(USART.channel, USART_TDC_INT, TRUE);
   usart_interrupt_enable(USART.channel, USART_RDBF_INT, TRUE);
+  usart_interrupt_enable(USART.channel, USART_IDLE_INT, TRUE);
 
   serial_enable_isr(serial->config.port);
 }
@@ -164,6 +166,13 @@ static void handle_serial_isr(serial_port_t *serial) {
   if (usart_flag_get(port->channel, USART_RDBF_FLAG)) {
     const volatile uint8_t data = usart_data_receive(port->channel);
     ring_buffer_write(serial->rx_buffer, data);
+    serial->rx_cycles = time_cycles();
+  }
+
+  if (usart_flag_get(port->channel, USART_IDLEF_FLAG)) {
+    // a frame ended, keep its time even if the next one starts before it is decoded
+    serial->rx_frame_cycles = serial->rx_cycles;
+    usart_flag_clear(port->channel, USART_IDLEF_FLAG);
   }
 
   if (usart_flag_get(port->channel, USART_ROERR_FLAG) == SET) {
@@ -181,6 +190,7 @@ static void handle_usart_isr(serial_ports_t index) {
   const usart_port_def_t *port = &usart_port_defs[index];
   usart_interrupt_enable(port->channel, USART_TDBE_INT, FALSE);
   usart_interrupt_enable(port->channel, USART_RDBF_INT, FALSE);
+  usart_interrupt_enable(port->channel, USART_IDLE_INT, FALSE);
   usart_flag_clear(port->channel, USART_ROERR_FLAG);
   usart_enable(port->channel, FALSE);
 }
@@ -47,6 +47,10 @@ extern FAST_RAM volatile spi_port_config_t spi_port_config[SPI_PORT_MAX];
 extern FAST_RAM volatile uint8_t dma_transfer_done[16];
 extern FAST_RAM spi_txn_t txn_pool[SPI_TXN_MAX];
 
+// stand-ins for segments without a tx or rx buffer, the dma does not increment over them
+static DMA_RAM uint8_t spi_dma_fill;
+static DMA_RAM uint8_t spi_dma_sink;
+
 #define PORT spi_port_defs[port]
 
 static uint32_t spi_divider_to_ll(uint32_t divider) {
@@ -139,9 +143,14 @@ static void spi_dma_init_rx(spi_ports_t port) {
 }
 
 static void spi_dma_reset_rx(spi_ports_t port, uint8_t *rx_data, uint32_t rx_size) {
-  dma_prepare_rx_memory(rx_data, rx_size);
-
   const dma_stream_def_t *dma = &dma_stream_defs[PORT.dma_rx];
+  if (rx_data) {
+    dma_prepare_rx_memory(rx_data, rx_size);
+    dma->channel->ctrl_bit.mincm = TRUE;
+  } else {
+    rx_data = &spi_dma_sink;
+    dma->channel->ctrl_bit.mincm = FALSE;
+  }
   dma->channel->maddr = (uint32_t)rx_data;
   dma_data_number_set(dma->channel, rx_size);
 }
@@ -166,10 +175,16 @@ static void spi_dma_init_tx(spi_ports_t port) {
   dma_init(dma->channel, &init);
 }
 
-static void spi_dma_reset_tx(spi_ports_t port, uint8_t *tx_data, uint32_t tx_size) {
-  dma_prepare_tx_memory(tx_data, tx_size);
-
+static void spi_dma_reset_tx(spi_ports_t port, const uint8_t *tx_data, uint32_t tx_size) {
   const dma_stream_def_t *dma = &dma_stream_defs[PORT.dma_tx];
+  if (tx_data) {
+    dma_prepare_tx_memory(tx_data, tx_size);
+    dma->channel->ctrl_bit.mincm = TRUE;
+  } else {
+    spi_dma_fill = 0xFF;
+    tx_data = &spi_dma_fill;
+    dma->channel->ctrl_bit.mincm = FALSE;
+  }
   dma->channel->maddr = (uint32_t)tx_data;
   dma_data_number_set(dma->channel, tx_size);
 }
@@ -223,7 +238,7 @@ void spi_reconfigure(spi_bus_device_t *bus) {
   }
 }
 
-void spi_dma_transfer_begin(spi_ports_t port, uint8_t *buffer, uint32_t length) {
+void spi_dma_transfer_begin(spi_ports_t port, const uint8_t *tx_data, uint8_t *rx_data, uint32_t length) {
   dma_transfer_done[port] = 0;
 
   const dma_stream_def_t *dma_tx = &dma_stream_defs[PORT.dma_tx];
@@ -232,8 +247,8 @@ void spi_dma_transfer_begin(spi_ports_t port, uint8_t *buffer, uint32_t length)
   dma_clear_flag_tc(PORT.dma_rx);
   dma_clear_flag_tc(PORT.dma_tx);
 
-  spi_dma_reset_rx(port, buffer, length);
-  spi_dma_reset_tx(port, buffer, length);
+  spi_dma_reset_rx(port, rx_data, length);
+  spi_dma_reset_tx(port, tx_data, length);
 
   dma_interrupt_enable(dma_rx->channel, DMA_FDT_INT, TRUE);
   dma_interrupt_enable(dma_rx->channel, DMA_DTERR_INT, TRUE);
@@ -367,6 +382,11 @@ static void handle_dma_rx_isr(spi_ports_t port) {
   }
 
   spi_bus_device_t *bus = spi_port_config[port].active_device;
+  if (spi_txn_continue_chunk(bus)) {
+    // more segments to go, keep the device selected
+    return;
+  }
+
   spi_csn_disable(bus);
 
   spi_txn_finish(bus);
@@ -3,6 +3,7 @@
 #include "core/project.h"
 
 volatile uint32_t systick_count = 0;
+uint32_t time_ticks_per_us = 0;
 static volatile uint32_t systick_val = 0;
 static volatile uint32_t systick_pending = 0;
 
@@ -17,6 +18,8 @@ void time_init() {
   system_clock_config();
   crm_periph_clock_enable(CRM_SCFG_PERIPH_CLOCK, TRUE);
 
+  time_ticks_per_us = SYS_CLOCK_FREQ_HZ / 1000000;
+
   // interrupt only every 1ms
   systick_clock_source_config(SYSTICK_CLOCK_SOURCE_AHBCLK_NODIV);
   SysTick_Config(SYS_CLOCK_FREQ_HZ / 1000);
@@ -65,7 +68,7 @@ uint32_t time_micros() {
 }
 
 void time_delay_us(uint32_t us) {
-  volatile uint32_t delay = us * (SYS_CLOCK_FREQ_HZ / 1000000L);
+  volatile uint32_t delay = us * TICKS_PER_US;
   volatile uint32_t start = DWT->CYCCNT;
   while (DWT->CYCCNT - start < delay) {
     __asm("NOP");
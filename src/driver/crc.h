@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// runs data through the hardware crc unit, msb first without reflection
+// returns false if the unit can not handle the polynomial or is in use, caller has to fall back to software
+bool crc_hw_calc(uint8_t bits, uint32_t poly, uint32_t *crc, const uint8_t *data, uint32_t size);
@@ -19,6 +19,7 @@ typedef struct _dma_allocation {
 } __attribute__((aligned(DMA_ALIGN_SIZE))) dma_allocation_t;
 
 static DMA_RAM uint8_t dma_buffer[DMA_ALLOC_BUFFER_SIZE];
+static uint32_t dma_buffer_peak = 0;
 
 void *dma_mem_alloc(uint32_t min_size) {
   ATOMIC_BLOCK_ALL {
@@ -53,6 +54,11 @@ void *dma_mem_alloc(uint32_t min_size) {
     alloc->magic = 0xBEEF;
     alloc->free = 0;
 
+    const uint32_t used = ((void *)(alloc) - (void *)(dma_buffer)) + sizeof(dma_allocation_t) + alloc->size;
+    if (used > dma_buffer_peak) {
+      dma_buffer_peak = used;
+    }
+
     return (void *)(alloc) + sizeof(dma_allocation_t);
   }
 
@@ -108,4 +114,27 @@ void *dma_mem_realloc(void *ptr, uint32_t min_size) {
 
   failloop(FAILLOOP_FAULT);
   return NULL;
-}
\ No newline at end of file
+}
+
+void dma_mem_stats(dma_mem_stats_t *stats) {
+  stats->size = DMA_ALLOC_BUFFER_SIZE;
+  stats->used = 0;
+  stats->peak = dma_buffer_peak;
+  stats->free = 0;
+
+  ATOMIC_BLOCK_ALL {
+    dma_allocation_t *alloc = (dma_allocation_t *)dma_buffer;
+    if (alloc->next == NULL && alloc->size == 0) {
+      // pool is empty
+      alloc = NULL;
+    }
+
+    while (alloc != NULL) {
+      if (alloc->free) {
+        stats->free += alloc->size;
+      }
+      stats->used = ((void *)(alloc) - (void *)(dma_buffer)) + sizeof(dma_allocation_t) + alloc->size;
+      alloc = alloc->next;
+    }
+  }
+}
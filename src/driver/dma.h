@@ -6,6 +6,10 @@
 
 #define DMA_ALLOC_BUFFER_SIZE 4096
 
+// buffers received into directly from cached ram have to own whole cache lines
+#define DMA_CACHE_LINE_SIZE 32
+#define DMA_CACHE_ALIGNED __attribute__((aligned(DMA_CACHE_LINE_SIZE)))
+
 typedef enum {
   DMA_DEVICE_SPI1_RX,
   DMA_DEVICE_SPI1_TX,
@@ -18,18 +22,34 @@ typedef enum {
   DMA_DEVICE_TIM1_CH1,
   DMA_DEVICE_TIM1_CH3,
   DMA_DEVICE_TIM1_CH4,
+  DMA_DEVICE_TIM8_CH4,
+  DMA_DEVICE_TIM2_UP,
+  DMA_DEVICE_TIM3_UP,
+  DMA_DEVICE_TIM4_UP,
 
   DMA_DEVICE_MAX,
 } dma_device_t;
 
 extern const dma_stream_def_t dma_stream_defs[DMA_DEVICE_MAX];
 
+typedef struct {
+  uint32_t size;
+  uint32_t used; // end of the last allocation
+  uint32_t peak;
+  uint32_t free; // freed blocks below the last allocation
+} dma_mem_stats_t;
+
 void *dma_mem_alloc(uint32_t min_size);
 void *dma_mem_realloc(void *ptr, uint32_t min_size);
 void dma_mem_free(void *ptr);
+void dma_mem_stats(dma_mem_stats_t *stats);
 
 void dma_prepare_tx_memory(void *addr, uint32_t size);
 void dma_prepare_rx_memory(void *addr, uint32_t size);
+void dma_finish_rx_memory(void *addr, uint32_t size);
+
+bool dma_can_use_tx_memory(const void *addr, uint32_t size);
+bool dma_can_use_rx_memory(void *addr, uint32_t size);
 
 void dma_enable_rcc(dma_device_t dev);
 
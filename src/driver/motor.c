@@ -1,5 +1,6 @@
 #include "driver/motor.h"
 
+#include "core/latency.h"
 #include "core/project.h"
 
 static float motor_values[MOTOR_PIN_MAX];
@@ -52,7 +53,7 @@ void motor_beep() {
 }
 
 void motor_set(motor_position_t pos, float pwm) {
-  if ((uint8_t)pos > MOTOR_PIN_MAX) {
+  if ((uint8_t)pos >= MOTOR_PIN_MAX) {
     return;
   }
 
@@ -60,10 +61,9 @@ void motor_set(motor_position_t pos, float pwm) {
 }
 
 void motor_set_all(float pwm) {
-  motor_set(MOTOR_BL, pwm);
-  motor_set(MOTOR_FL, pwm);
-  motor_set(MOTOR_FR, pwm);
-  motor_set(MOTOR_BR, pwm);
+  for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
+    motor_set(i, pwm);
+  }
 }
 
 void motor_update() {
@@ -78,6 +78,7 @@ void motor_update() {
     motor_pwm_write(motor_values);
 #endif
   }
+  latency_stamp(LATENCY_STAGE_MOTOR);
 }
 
 void motor_set_direction(motor_direction_t dir) {
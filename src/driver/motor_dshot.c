@@ -9,16 +9,35 @@
 #ifdef USE_MOTOR_DSHOT
 
 typedef enum {
-  DIR_CHANGE_START,
-  DIR_CHANGE_DELAY,
-  DIR_CHANGE_CMD,
-  DIR_CHANGE_STOP,
-} dir_change_state_t;
+  DSHOT_CMD_STAGE_START, // zero throttle until the escs accept commands
+  DSHOT_CMD_STAGE_SEND,  // command frames, spaced by the rule
+  DSHOT_CMD_STAGE_DELAY, // zero throttle while the esc acts on the command
+} dshot_command_stage_t;
 
-uint16_t dshot_packet[MOTOR_PIN_MAX]; // 16bits dshot data for 4 motors
+typedef struct {
+  uint32_t seq;
+  uint8_t command;
+  uint8_t repeats;
+  uint32_t spacing_us;
+  uint32_t delay_us;
+} dshot_command_t;
+
+uint16_t dshot_packet[MOTOR_PIN_MAX]; // 16bits dshot data per motor pin
 motor_direction_t motor_dir = MOTOR_FORWARD;
 
-static bool dir_change_done = true;
+static dshot_command_t command_queue[DSHOT_CMD_QUEUE_SIZE];
+static uint32_t command_head = 0;
+static uint32_t command_tail = 0;
+
+static dshot_command_stage_t command_stage = DSHOT_CMD_STAGE_START;
+static uint8_t command_sent = 0;
+static uint32_t command_time = 0;
+
+static uint32_t command_queued_seq = 0; // sequence of the last queued command
+static uint32_t command_done_seq = 0;   // sequence of the last retired command
+
+static uint32_t direction_seq = 0;
+static bool direction_pending = false;
 
 extern void dshot_dma_start();
 
@@ -41,99 +60,251 @@ void dshot_make_packet_all(uint16_t value, bool telemetry) {
   }
 }
 
-void motor_dshot_write(float *values) {
-  if (dir_change_done) {
-    for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
-      uint16_t value = 0;
-      if (values[i] >= 0.0f) {
-        const float pwm = constrain(values[i], 0.0f, 1.0f);
-        value = mapf(pwm, 0.0f, 1.0f, 48, 2047);
-      } else {
-        value = 0;
-      }
-      dshot_make_packet(profile.motor.motor_pins[i], value, false);
+static dshot_command_t dshot_command_rule(uint8_t command) {
+  dshot_command_t cmd = {
+      .command = command,
+      .repeats = 1,
+      .spacing_us = 0,
+      .delay_us = 0,
+  };
+
+  switch (command) {
+  case DSHOT_CMD_ESC_INFO:
+    cmd.delay_us = DSHOT_CMD_ESC_INFO_DELAY_US;
+    break;
+
+  case DSHOT_CMD_SPIN_DIRECTION_1:
+  case DSHOT_CMD_SPIN_DIRECTION_2:
+  case DSHOT_CMD_3D_MODE_OFF:
+  case DSHOT_CMD_3D_MODE_ON:
+  case DSHOT_CMD_EXTENDED_TELEMETRY_ENABLE:
+  case DSHOT_CMD_EXTENDED_TELEMETRY_DISABLE:
+  case DSHOT_CMD_ROTATE_NORMAL:
+  case DSHOT_CMD_ROTATE_REVERSE:
+    cmd.repeats = DSHOT_CMD_SETTING_REPEATS;
+    cmd.spacing_us = DSHOT_CMD_SPACING_US;
+    break;
+
+  case DSHOT_CMD_SAVE_SETTINGS:
+    cmd.repeats = DSHOT_CMD_SETTING_REPEATS;
+    cmd.spacing_us = DSHOT_CMD_SPACING_US;
+    cmd.delay_us = DSHOT_CMD_SAVE_DELAY_US;
+    break;
+
+  default:
+    break;
+  }
+
+  return cmd;
+}
+
+// returns the sequence number of the queued command, zero if the queue is full
+static uint32_t dshot_command_push(uint8_t command) {
+  const uint32_t next = (command_head + 1) % DSHOT_CMD_QUEUE_SIZE;
+  if (next == command_tail) {
+    return 0;
+  }
+
+  command_queued_seq++;
+  if (command_queued_seq == 0) {
+    command_queued_seq++;
+  }
+
+  command_queue[command_head] = dshot_command_rule(command);
+  command_queue[command_head].seq = command_queued_seq;
+  command_head = next;
+  return command_queued_seq;
+}
+
+// the queue holds every motor at zero while it runs, so commands are only taken while disarmed
+bool motor_dshot_command(uint8_t command) {
+  if (command > DSHOT_CMD_MAX || flags.arm_state) {
+    return false;
+  }
+  return dshot_command_push(command) != 0;
+}
+
+bool motor_dshot_command_done() {
+  return command_head == command_tail;
+}
+
+static bool dshot_command_is_beep(uint8_t command) {
+  return command >= DSHOT_CMD_BEEP1 && command <= DSHOT_CMD_BEEP5;
+}
+
+static bool dshot_command_is_not_direction(uint8_t command) {
+  return command != DSHOT_CMD_ROTATE_NORMAL && command != DSHOT_CMD_ROTATE_REVERSE;
+}
+
+// removes queued commands matching drop, with finish_on_wire a command already on the wire is finished
+static void dshot_command_drop(bool (*drop)(uint8_t), bool finish_on_wire) {
+  bool restart = false;
+  uint32_t keep = command_tail;
+  for (uint32_t i = command_tail; i != command_head; i = (i + 1) % DSHOT_CMD_QUEUE_SIZE) {
+    const bool on_wire = i == command_tail &&
+                         (command_stage == DSHOT_CMD_STAGE_DELAY || (command_stage == DSHOT_CMD_STAGE_SEND && command_sent > 0));
+    if (drop(command_queue[i].command) && !(on_wire && finish_on_wire)) {
+      restart = restart || on_wire;
+      continue;
     }
 
+    command_queue[keep] = command_queue[i];
+    keep = (keep + 1) % DSHOT_CMD_QUEUE_SIZE;
+  }
+  command_head = keep;
+
+  if (restart || motor_dshot_command_done()) {
+    // the next command has to stop the motors again
+    command_stage = DSHOT_CMD_STAGE_START;
+    command_sent = 0;
+    command_time = 0;
+  }
+}
+
+// queues a requested direction change, retried every write while the queue is full
+static void dshot_direction_push() {
+  if (!direction_pending) {
+    return;
+  }
+
+  const uint32_t seq = dshot_command_push(motor_dir == MOTOR_REVERSE ? DSHOT_CMD_ROTATE_REVERSE : DSHOT_CMD_ROTATE_NORMAL);
+  if (seq == 0) {
+    return;
+  }
+
+  direction_seq = seq;
+  direction_pending = false;
+}
+
+// runs the head of the command queue for one loop, returns false once the queue is empty.
+// every call sends at most one frame and never waits, motors are held at zero while busy.
+static bool dshot_command_update() {
+  if (motor_dshot_command_done()) {
+    return false;
+  }
+
+  const dshot_command_t *cmd = &command_queue[command_tail];
+  const uint32_t time = time_micros();
+
+  switch (command_stage) {
+  case DSHOT_CMD_STAGE_START:
+    if (command_time == 0) {
+      command_time = time;
+    }
+    dshot_make_packet_all(0, false);
     dshot_dma_start();
-  } else {
-    static uint8_t counter = 0;
-    static uint32_t dir_change_time = 0;
-    static dir_change_state_t state = DIR_CHANGE_START;
-
-    switch (state) {
-    case DIR_CHANGE_START: {
-      if (counter < 100) {
-        dshot_make_packet_all(0, false);
-        dshot_dma_start();
-        counter++;
-      } else {
-        state = DIR_CHANGE_DELAY;
-        counter = 0;
-      }
-      dir_change_time = time_micros();
-      break;
+
+    if ((time - command_time) >= DSHOT_CMD_IDLE_TIME_US) {
+      command_stage = DSHOT_CMD_STAGE_SEND;
+      command_sent = 0;
     }
+    break;
 
-    case DIR_CHANGE_DELAY:
-      if ((time_micros() - dir_change_time) < DSHOT_DIR_CHANGE_IDLE_TIME_US) {
-        break;
-      }
-      state = DIR_CHANGE_CMD;
-      dir_change_time = time_micros();
+  case DSHOT_CMD_STAGE_SEND:
+    if (command_sent > 0 && (time - command_time) < cmd->spacing_us) {
+      // no frame at all between repeats
       break;
+    }
 
-    case DIR_CHANGE_CMD: {
-      if ((time_micros() - dir_change_time) < DSHOT_DIR_CHANGE_CMD_TIME_US) {
-        break;
-      }
-
-      const uint16_t value = motor_dir == MOTOR_REVERSE ? DSHOT_CMD_ROTATE_REVERSE : DSHOT_CMD_ROTATE_NORMAL;
-      if (counter < 10) {
-        dshot_make_packet_all(value, true);
-        dshot_dma_start();
-        counter++;
-      } else {
-        state = DIR_CHANGE_STOP;
-        counter = 0;
-      }
-      dir_change_time = time_micros();
-      break;
+    dshot_make_packet_all(cmd->command, true);
+    dshot_dma_start();
+
+    command_time = time;
+    command_sent++;
+    if (command_sent >= cmd->repeats) {
+      command_stage = DSHOT_CMD_STAGE_DELAY;
     }
+    break;
+
+  case DSHOT_CMD_STAGE_DELAY:
+    dshot_make_packet_all(0, false);
+    dshot_dma_start();
 
-    case DIR_CHANGE_STOP:
-      dir_change_done = true;
-      state = DIR_CHANGE_START;
+    if ((time - command_time) < cmd->delay_us) {
       break;
     }
+
+    command_done_seq = cmd->seq;
+    command_tail = (command_tail + 1) % DSHOT_CMD_QUEUE_SIZE;
+    command_sent = 0;
+    if (motor_dshot_command_done()) {
+      // the next batch has to stop the motors again
+      command_stage = DSHOT_CMD_STAGE_START;
+      command_time = 0;
+    } else {
+      command_stage = DSHOT_CMD_STAGE_SEND;
+    }
+    break;
+  }
+
+  return true;
+}
+
+FAST_CODE void motor_dshot_write(float *values) {
+  static bool was_armed = false;
+  if (flags.arm_state && !was_armed) {
+    // anything still queued from the ground would cut the motors in flight, only direction changes stay
+    dshot_command_drop(dshot_command_is_not_direction, false);
+  }
+  was_armed = flags.arm_state;
+
+  dshot_direction_push();
+  if (dshot_command_update()) {
+    return;
+  }
+
+  for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
+    uint16_t value = 0;
+    if (values[i] >= 0.0f) {
+      const float pwm = constrain(values[i], 0.0f, 1.0f);
+      value = mapf(pwm, 0.0f, 1.0f, 48, 2047);
+    } else {
+      value = 0;
+    }
+    dshot_make_packet(profile.motor.motor_pins[i], value, false);
   }
+
+  dshot_dma_start();
 }
 
 void motor_dshot_set_direction(motor_direction_t dir) {
-  if (dir_change_done) {
-    motor_dir = dir;
-    dir_change_done = false;
+  if (dir == motor_dir) {
+    return;
   }
+
+  // a pending beacon must never hold back or swallow the direction change
+  motor_dir = dir;
+  direction_pending = true;
+  dshot_command_drop(dshot_command_is_beep, true);
+  dshot_direction_push();
 }
 
 bool motor_dshot_direction_change_done() {
-  return dir_change_done;
+  // done once the rotate command itself has left the send and delay stages
+  return !direction_pending && (int32_t)(command_done_seq - direction_seq) >= 0;
 }
 
 void motor_dshot_beep() {
   static uint32_t last_time = 0;
-  const uint32_t time = time_millis() - last_time;
-
   static uint8_t beep_command = DSHOT_CMD_BEEP1;
-  dshot_make_packet_all(beep_command, true);
-  dshot_dma_start();
 
-  if (time >= 500) {
+  dshot_direction_push();
+
+  // the tone runs for ~260ms, paced here so the queue never holds the motors past the beacon
+  if (motor_dshot_command_done() && (time_micros() - last_time) >= DSHOT_CMD_BEACON_DELAY_US) {
+    motor_dshot_command(beep_command);
+
     beep_command++;
     if (beep_command > DSHOT_CMD_BEEP5) {
       beep_command = DSHOT_CMD_BEEP1;
     }
 
-    last_time = time_millis();
+    last_time = time_micros();
+  }
+
+  if (!dshot_command_update()) {
+    dshot_make_packet_all(0, false);
+    dshot_dma_start();
   }
 }
-#endif
\ No newline at end of file
+#endif
@@ -2,14 +2,48 @@
 
 #include "driver/motor.h"
 
+#define DSHOT_CMD_MOTOR_STOP 0
 #define DSHOT_CMD_BEEP1 1
 #define DSHOT_CMD_BEEP2 2
 #define DSHOT_CMD_BEEP3 3
 #define DSHOT_CMD_BEEP4 4
 #define DSHOT_CMD_BEEP5 5 // 5 currently uses the same tone as 4 in BLHeli_S.
+#define DSHOT_CMD_ESC_INFO 6
+#define DSHOT_CMD_SPIN_DIRECTION_1 7
+#define DSHOT_CMD_SPIN_DIRECTION_2 8
+#define DSHOT_CMD_3D_MODE_OFF 9
+#define DSHOT_CMD_3D_MODE_ON 10
+#define DSHOT_CMD_SETTINGS_REQUEST 11
+#define DSHOT_CMD_SAVE_SETTINGS 12
+#define DSHOT_CMD_EXTENDED_TELEMETRY_ENABLE 13
+#define DSHOT_CMD_EXTENDED_TELEMETRY_DISABLE 14
 
 #define DSHOT_CMD_ROTATE_NORMAL 20
 #define DSHOT_CMD_ROTATE_REVERSE 21
 
-#define DSHOT_DIR_CHANGE_IDLE_TIME_US 10000
-#define DSHOT_DIR_CHANGE_CMD_TIME_US 1000
\ No newline at end of file
+#define DSHOT_CMD_LED0_ON 22
+#define DSHOT_CMD_LED1_ON 23
+#define DSHOT_CMD_LED2_ON 24
+#define DSHOT_CMD_LED3_ON 25
+#define DSHOT_CMD_LED0_OFF 26
+#define DSHOT_CMD_LED1_OFF 27
+#define DSHOT_CMD_LED2_OFF 28
+#define DSHOT_CMD_LED3_OFF 29
+
+#define DSHOT_CMD_MAX 47
+
+// zero throttle before the first command, escs ignore commands while spinning
+#define DSHOT_CMD_IDLE_TIME_US 10000
+// gap between repeats of a setting command
+#define DSHOT_CMD_SPACING_US 1000
+// settings only stick if received this many times
+#define DSHOT_CMD_SETTING_REPEATS 10
+
+#define DSHOT_CMD_BEACON_DELAY_US 500000
+#define DSHOT_CMD_SAVE_DELAY_US 35000
+#define DSHOT_CMD_ESC_INFO_DELAY_US 12000
+
+#define DSHOT_CMD_QUEUE_SIZE 8
+
+bool motor_dshot_command(uint8_t command);
+bool motor_dshot_command_done();
@@ -5,4 +5,13 @@
 
 typedef uint32_t rcc_reg_t;
 
-void rcc_enable(rcc_reg_t req);
\ No newline at end of file
+typedef enum {
+  RCC_CLOCK_DEFAULT,
+  RCC_CLOCK_OVERCLOCK_1,
+  RCC_CLOCK_OVERCLOCK_2,
+
+  RCC_CLOCK_MAX,
+} rcc_clock_t;
+
+void rcc_enable(rcc_reg_t req);
+bool rcc_set_clock(rcc_clock_t clock);
\ No newline at end of file
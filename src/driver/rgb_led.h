@@ -1,6 +1,30 @@
 #pragma once
 
+#include <stdint.h>
+
+#define RGB_LED_MAX 32
+
+// ws2812 bits are 1.25us long, a 0 is high for ~0.4us and a 1 for ~0.8us
+#define RGB_BIT_TIME ((PWM_CLOCK_FREQ_HZ / 800000) - 1)
+#define RGB_T0H_TIME (((RGB_BIT_TIME + 1) * 8) / 25)
+#define RGB_T1H_TIME (((RGB_BIT_TIME + 1) * 16) / 25)
+
+// newer ws2812b need the line low for 280us before they latch
+#define RGB_RESET_TIME_US 300
+
+// one timer compare value per bit, plus trailing zeros to return the line to low
+#define RGB_DMA_BUFFER_SIZE (RGB_LED_MAX * 24 + 2)
+
+typedef enum {
+  RGB_PHASE_IDLE,
+  RGB_PHASE_BUSY,  // dma is streaming the buffer
+  RGB_PHASE_READY, // buffer encoded, waiting for the next free slot after dshot
+  RGB_PHASE_DATA,  // new led values, buffer needs to be encoded
+} rgb_phase_t;
+
 void rgb_init();
-void rgb_send(int data);
+void rgb_send();
 
-void rgb_dma_start();
\ No newline at end of file
+void rgb_dma_start();
+void rgb_dma_fire();
+void rgb_dma_done();
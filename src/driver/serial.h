@@ -52,6 +52,8 @@ typedef struct {
   ring_buffer_t *tx_buffer;
 
   bool tx_done;
+  volatile uint32_t rx_cycles;       // time of the last received byte
+  volatile uint32_t rx_frame_cycles; // time of the last byte before the line went idle
 } serial_port_t;
 
 typedef struct {
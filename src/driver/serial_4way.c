@@ -12,6 +12,7 @@
 #include "driver/usb.h"
 #include "io/led.h"
 #include "util/cbor_helper.h"
+#include "util/crc.h"
 
 #define RX_LED_OFF led_off(1)
 #define RX_LED_ON led_on(1)
@@ -31,20 +32,10 @@
 
 static serial_esc4way_device_t device;
 static gpio_pins_t esc_pins[MOTOR_PIN_MAX] = {PIN_NONE};
+static uint8_t esc_count = 0;
 
 #define ESC_PIN (esc_pins[device.selected_esc])
 
-uint16_t _crc_xmodem_update(uint16_t crc, uint8_t data) {
-  crc = crc ^ ((uint16_t)data << 8);
-  for (uint8_t i = 0; i < 8; i++) {
-    if (crc & 0x8000)
-      crc = (crc << 1) ^ 0x1021;
-    else
-      crc <<= 1;
-  }
-  return crc;
-}
-
 bool device_is_connected() {
   return device.info[0] > 0 && device.info[1] > 0;
 }
@@ -90,19 +81,11 @@ static uint8_t read_byte() {
   return byte;
 }
 
-static uint8_t read_byte_crc(uint16_t *crc) {
-  uint8_t b = read_byte();
-  *crc = _crc_xmodem_update(*crc, b);
-  return b;
-}
-
-static void write_byte(uint8_t b) {
-  usb_serial_write(&b, 1);
-}
-
-static void write_byte_crc(uint16_t *crc, uint8_t b) {
-  write_byte(b);
-  *crc = _crc_xmodem_update(*crc, b);
+static void read_bytes(uint8_t *data, uint32_t len) {
+  uint32_t read = 0;
+  while (read < len) {
+    read += usb_serial_read(data + read, len - read);
+  }
 }
 
 static uint8_t connect_esc(gpio_pins_t pin, uint8_t *data) {
@@ -132,13 +115,40 @@ uint8_t serial_4way_init() {
 
   time_delay_ms(250);
 
-  for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
+  esc_count = constrain(profile.motor.motor_count, 1, MOTOR_PIN_MAX);
+
+  for (uint32_t i = 0; i < esc_count; i++) {
     const gpio_pins_t pin = target.motor_pins[profile.motor.motor_pins[i]];
     esc_pins[i] = pin;
     avr_bl_init_pin(pin);
   }
 
-  return MOTOR_PIN_MAX;
+  return esc_count;
+}
+
+// polls the escs until every bootloader answers, returns how many did before the timeout
+uint8_t serial_4way_wait_ready(uint32_t timeout_ms) {
+  uint8_t data[SERIAL_4WAY_DEVICE_INFO_SIZE];
+  uint32_t ready = 0;
+  uint8_t ready_count = 0;
+
+  // the handshake goes out without crc
+  device_set_disconnected();
+
+  const uint32_t start = time_millis();
+  while (ready_count < esc_count && (time_millis() - start) < timeout_ms) {
+    for (uint32_t i = 0; i < esc_count; i++) {
+      if (ready & (1 << i)) {
+        continue;
+      }
+      if (avr_bl_connect(esc_pins[i], data)) {
+        ready |= (1 << i);
+        ready_count++;
+      }
+    }
+  }
+
+  return ready_count;
 }
 
 void serial_4way_release() {
@@ -214,7 +224,7 @@ serial_esc4way_ack_t serial_4way_send(uint8_t cmd, uint16_t addr, const uint8_t
   }
 
   case ESC4WAY_DEVICE_RESET: {
-    if (input[0] >= MOTOR_PIN_MAX) {
+    if (input[0] >= esc_count) {
       return ESC4WAY_ACK_I_INVALID_CHANNEL;
     }
 
@@ -246,7 +256,7 @@ serial_esc4way_ack_t serial_4way_send(uint8_t cmd, uint16_t addr, const uint8_t
   case ESC4WAY_DEVICE_INIT_FLASH: {
     device_set_disconnected();
 
-    if (input[0] >= MOTOR_PIN_MAX) {
+    if (input[0] >= esc_count) {
       return ESC4WAY_ACK_I_INVALID_CHANNEL;
     }
 
@@ -548,39 +558,42 @@ serial_esc4way_ack_t serial_4way_write_settings(blheli_settings_t *settings, uin
 // ESC + CMD PARAM_LEN [PARAM (if len > 0)] CRC16_Hi CRC16_Lo
 // Return
 // ESC CMD PARAM_LEN [PARAM (if len > 0)] + ACK (uint8_t OK or ERR) + CRC16_Hi CRC16_Lo
+#define FRAME_HEADER_SIZE 5
+#define FRAME_MAX_SIZE (FRAME_HEADER_SIZE + 256 + 3)
+
 void serial_4way_process() {
-  uint8_t input_buffer[256];
-  uint8_t output_buffer[256];
+  // frames are moved over usb in one piece, per byte transfers dominate page reads and writes
+  uint8_t input_frame[FRAME_MAX_SIZE];
+  uint8_t output_frame[FRAME_MAX_SIZE];
   uint8_t output_size = 0;
 
-  uint16_t crc_in = 0;
-  uint16_t crc_out = 0;
-
   RX_LED_OFF;
   TX_LED_OFF;
 
   while (1) {
     // restart looking for new sequence from host
-    uint8_t magic;
     do {
       RX_LED_ON;
-      crc_in = 0;
-      magic = read_byte_crc(&crc_in);
+      input_frame[0] = read_byte();
       RX_LED_OFF;
-    } while (magic != ESC4WAY_LOCAL_ESCAPE);
+    } while (input_frame[0] != ESC4WAY_LOCAL_ESCAPE);
 
     RX_LED_ON;
 
-    const uint8_t cmd = read_byte_crc(&crc_in);
-    const uint16_t addr = (read_byte_crc(&crc_in) << 8) | (uint16_t)(read_byte_crc(&crc_in));
+    read_bytes(input_frame + 1, FRAME_HEADER_SIZE - 1);
 
-    const uint8_t size = read_byte_crc(&crc_in);
-    for (uint16_t i = 0; i < (size == 0 ? 256 : size); i++) {
-      input_buffer[i] = read_byte_crc(&crc_in);
-    }
+    const uint8_t cmd = input_frame[1];
+    const uint16_t addr = (input_frame[2] << 8) | (uint16_t)input_frame[3];
+    const uint8_t size = input_frame[4];
+    const uint32_t input_len = size == 0 ? 256 : size;
 
-    const uint16_t their_crc = (uint16_t)(read_byte() << 8) | (uint16_t)(read_byte());
+    // params and crc
+    read_bytes(input_frame + FRAME_HEADER_SIZE, input_len + 2);
 
+    const uint16_t crc_in = crc16_xmodem_data(0, input_frame, FRAME_HEADER_SIZE + input_len);
+    const uint16_t their_crc = (uint16_t)(input_frame[FRAME_HEADER_SIZE + input_len] << 8) | (uint16_t)(input_frame[FRAME_HEADER_SIZE + input_len + 1]);
+
+    uint8_t *output_buffer = output_frame + FRAME_HEADER_SIZE;
     memset(output_buffer, 0, 256);
 
     RX_LED_OFF;
@@ -588,26 +601,25 @@ void serial_4way_process() {
     serial_esc4way_ack_t ack_out = ESC4WAY_ACK_OK;
     if (their_crc == crc_in) {
       TX_LED_ON;
-      ack_out = serial_4way_send(cmd, addr, input_buffer, size, output_buffer, &output_size);
+      ack_out = serial_4way_send(cmd, addr, input_frame + FRAME_HEADER_SIZE, size, output_buffer, &output_size);
     } else {
       ack_out = ESC4WAY_ACK_I_INVALID_CRC;
     }
 
-    crc_out = 0;
+    const uint32_t output_len = output_size == 0 ? 256 : output_size;
 
-    write_byte_crc(&crc_out, ESC4WAY_REMOTE_ESCAPE);
-    write_byte_crc(&crc_out, cmd);
-    write_byte_crc(&crc_out, addr >> 8);
-    write_byte_crc(&crc_out, addr & 0xFF);
+    output_frame[0] = ESC4WAY_REMOTE_ESCAPE;
+    output_frame[1] = cmd;
+    output_frame[2] = addr >> 8;
+    output_frame[3] = addr & 0xFF;
+    output_frame[4] = output_size;
+    output_frame[FRAME_HEADER_SIZE + output_len] = ack_out;
 
-    write_byte_crc(&crc_out, output_size);
-    for (uint16_t i = 0; i < (output_size == 0 ? 256 : output_size); i++) {
-      write_byte_crc(&crc_out, output_buffer[i]);
-    }
+    const uint16_t crc_out = crc16_xmodem_data(0, output_frame, FRAME_HEADER_SIZE + output_len + 1);
+    output_frame[FRAME_HEADER_SIZE + output_len + 1] = crc_out >> 8;
+    output_frame[FRAME_HEADER_SIZE + output_len + 2] = crc_out & 0xFF;
 
-    write_byte_crc(&crc_out, ack_out);
-    write_byte(crc_out >> 8);
-    write_byte(crc_out & 0xFF);
+    usb_serial_write(output_frame, FRAME_HEADER_SIZE + output_len + 3);
 
     TX_LED_OFF;
     RX_LED_OFF;
@@ -19,6 +19,7 @@
 #define SERIAL_4WAY_VERSION_LO (uint8_t)(SERIAL_4WAY_VERSION % 100)
 
 #define SERIAL_4WAY_DEVICE_INFO_SIZE 4
+#define SERIAL_4WAY_READY_TIMEOUT_MS 1000
 
 typedef enum {
   ESC4WAY_SIL_C2 = 0,
@@ -212,6 +213,7 @@ cbor_result_t cbor_decode_blheli_settings_t(cbor_value_t *dec, blheli_settings_t
 cbor_result_t cbor_encode_blheli_settings_t(cbor_value_t *enc, const blheli_settings_t *p);
 
 uint8_t serial_4way_init();
+uint8_t serial_4way_wait_ready(uint32_t timeout_ms);
 void serial_4way_release();
 
 serial_esc4way_ack_t serial_4way_send(uint8_t cmd, uint16_t addr, const uint8_t *input, const uint8_t input_size, uint8_t *output, uint8_t *output_size);
@@ -107,11 +107,7 @@ static void hdzero_msp_send(msp_magic_t magic, uint8_t direction, uint16_t cmd,
     memcpy(buf + size, data, len);
     size += len;
 
-    uint8_t chksum = len ^ cmd;
-    for (uint8_t i = 0; i < len; i++) {
-      chksum ^= data[i];
-    }
-    buf[size++] = chksum;
+    buf[size++] = crc_xor_data(len ^ cmd, data, len);
 
     serial_write_bytes(&serial_hdzero, buf, size);
   }
@@ -144,11 +140,7 @@ static bool hdzero_push_subcmd(displayport_subcmd_t subcmd, const uint8_t *data,
   memcpy(buf + size, data, len);
   size += len;
 
-  uint8_t chksum = (len + 1) ^ MSP_DISPLAYPORT ^ subcmd;
-  for (uint8_t i = 0; i < len; i++) {
-    chksum ^= data[i];
-  }
-  buf[size++] = chksum;
+  buf[size++] = crc_xor_data((len + 1) ^ MSP_DISPLAYPORT ^ subcmd, data, len);
 
   return serial_write_bytes(&serial_hdzero, buf, size);
 }
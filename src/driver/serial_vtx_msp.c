@@ -46,11 +46,7 @@ static void serial_msp_send(msp_magic_t magic, uint8_t direction, uint16_t cmd,
 
     memcpy(vtx_frame + MSP_HEADER_LEN, data, len);
 
-    uint8_t chksum = len;
-    for (uint8_t i = 4; i < (size - 1); i++) {
-      chksum ^= vtx_frame[i];
-    }
-    vtx_frame[len + MSP_HEADER_LEN] = chksum;
+    vtx_frame[len + MSP_HEADER_LEN] = crc_xor_data(len, vtx_frame + 4, len + 1);
 
     serial_vtx_send_data(vtx_frame, size);
   }
@@ -11,7 +11,7 @@ FAST_RAM spi_txn_t txn_pool[SPI_TXN_MAX];
 
 extern void spi_reconfigure(spi_bus_device_t *bus);
 
-extern void spi_dma_transfer_begin(spi_ports_t port, uint8_t *buffer, uint32_t length);
+extern void spi_dma_transfer_begin(spi_ports_t port, const uint8_t *tx_data, uint8_t *rx_data, uint32_t length);
 
 void spi_enable_rcc(spi_ports_t port) {
   rcc_enable(spi_port_defs[port].rcc);
@@ -78,6 +78,51 @@ bool spi_txn_can_send(spi_bus_device_t *bus, bool dma) {
   return true;
 }
 
+static bool spi_txn_is_direct(const spi_txn_t *txn, uint32_t index) {
+  return (txn->direct_segments & (1 << index)) != 0;
+}
+
+// starts the next transfer of the txn, a direct segment goes out on its own while
+// consecutive pool segments share one transfer. returns false once all are out.
+static bool spi_txn_next_chunk(spi_txn_t *txn) {
+  if (txn->chunk_segment >= txn->segment_count) {
+    return false;
+  }
+
+  if (spi_txn_is_direct(txn, txn->chunk_segment)) {
+    const spi_txn_segment_t *seg = &txn->segments[txn->chunk_segment];
+    txn->chunk_segment++;
+
+    spi_dma_transfer_begin(txn->bus->port, seg->tx_data, seg->rx_data, seg->size);
+    return true;
+  }
+
+  uint32_t size = 0;
+  while (txn->chunk_segment < txn->segment_count && !spi_txn_is_direct(txn, txn->chunk_segment)) {
+    size += txn->segments[txn->chunk_segment].size;
+    txn->chunk_segment++;
+  }
+
+  uint8_t *buffer = txn->buffer + txn->chunk_offset;
+  txn->chunk_offset += size;
+
+  spi_dma_transfer_begin(txn->bus->port, buffer, buffer, size);
+  return true;
+}
+
+// called from the dma isr, keeps the chip selected while segments are left
+bool spi_txn_continue_chunk(spi_bus_device_t *bus) {
+  const uint32_t tail = (bus->txn_tail + 1) % SPI_TXN_MAX;
+  spi_txn_t *txn = bus->txns[tail];
+
+  const uint32_t last = txn->chunk_segment - 1;
+  if (spi_txn_is_direct(txn, last) && txn->segments[last].rx_data) {
+    dma_finish_rx_memory(txn->segments[last].rx_data, txn->segments[last].size);
+  }
+
+  return spi_txn_next_chunk(txn);
+}
+
 void spi_txn_continue(spi_bus_device_t *bus) {
   ATOMIC_BLOCK_ALL {
     if (bus->txn_head == bus->txn_tail) {
@@ -98,6 +143,9 @@ void spi_txn_continue(spi_bus_device_t *bus) {
       uint32_t txn_size = 0;
       for (uint32_t i = 0; i < txn->segment_count; ++i) {
         spi_txn_segment_t *seg = &txn->segments[i];
+        if (spi_txn_is_direct(txn, i)) {
+          continue;
+        }
         if (seg->tx_data) {
           memcpy((uint8_t *)txn->buffer + txn_size, seg->tx_data, seg->size);
         }
@@ -108,10 +156,32 @@ void spi_txn_continue(spi_bus_device_t *bus) {
     spi_reconfigure(bus);
 
     spi_csn_enable(bus);
-    spi_dma_transfer_begin(bus->port, txn->buffer, txn->size);
+
+    txn->chunk_segment = 0;
+    txn->chunk_offset = 0;
+    spi_txn_next_chunk(txn);
   }
 }
 
+// large buffers the dma can reach are transferred in place instead of through the pool.
+// tx data of a plain buffer segment is copied at submit, callers may reuse it right away,
+// so only delayed segments and pure reads qualify.
+static bool spi_seg_can_be_direct(const spi_txn_segment_t *seg) {
+  if (seg->size < SPI_TXN_DIRECT_MIN_SIZE) {
+    return false;
+  }
+  if (seg->type == TXN_CONST || (seg->type == TXN_BUFFER && seg->tx_data != NULL)) {
+    return false;
+  }
+  if (seg->tx_data && !dma_can_use_tx_memory(seg->tx_data, seg->size)) {
+    return false;
+  }
+  if (seg->rx_data && !dma_can_use_rx_memory(seg->rx_data, seg->size)) {
+    return false;
+  }
+  return true;
+}
+
 void spi_seg_submit_ex(spi_bus_device_t *bus, spi_txn_done_fn_t done_fn, const spi_txn_segment_t *segs, const uint32_t count) {
   spi_txn_t *txn = spi_txn_pop(bus);
   if (txn == NULL) {
@@ -120,6 +190,7 @@ void spi_seg_submit_ex(spi_bus_device_t *bus, spi_txn_done_fn_t done_fn, const s
 
   txn->bus = bus;
   txn->segment_count = 0;
+  txn->direct_segments = 0;
 
   txn->flags = 0;
   txn->size = 0;
@@ -127,41 +198,53 @@ void spi_seg_submit_ex(spi_bus_device_t *bus, spi_txn_done_fn_t done_fn, const s
 
   txn->buffer_size = 0;
   for (uint32_t i = 0; i < count; i++) {
-    txn->buffer_size += segs[i].size;
+    if (!spi_seg_can_be_direct(&segs[i])) {
+      txn->buffer_size += segs[i].size;
+    }
   }
-  txn->buffer = dma_mem_alloc(txn->buffer_size);
+  txn->buffer = txn->buffer_size ? dma_mem_alloc(txn->buffer_size) : NULL;
 
+  uint32_t buffer_offset = 0;
   spi_txn_segment_t *last_seg = NULL;
+  bool last_direct = false;
   for (uint32_t i = 0; i < count; i++) {
     const spi_txn_segment_t *seg = &segs[i];
+    const bool direct = spi_seg_can_be_direct(seg);
 
     const uint8_t *tx_data = NULL;
     uint8_t *rx_data = NULL;
 
-    switch (seg->type) {
-    case TXN_CONST:
-      txn->buffer[txn->size] = seg->byte;
-      break;
+    if (direct) {
+      tx_data = seg->tx_data;
+      rx_data = seg->rx_data;
+    } else {
+      switch (seg->type) {
+      case TXN_CONST:
+        txn->buffer[buffer_offset] = seg->byte;
+        break;
 
-    case TXN_BUFFER:
-      if (seg->tx_data) {
-        memcpy(txn->buffer + txn->size, seg->tx_data, seg->size);
-      } else {
-        memset(txn->buffer + txn->size, 0xFF, seg->size);
+      case TXN_BUFFER:
+        if (seg->tx_data) {
+          memcpy(txn->buffer + buffer_offset, seg->tx_data, seg->size);
+        } else {
+          memset(txn->buffer + buffer_offset, 0xFF, seg->size);
+        }
+        rx_data = seg->rx_data;
+        break;
+
+      case TXN_DELAY:
+        tx_data = seg->tx_data;
+        rx_data = seg->rx_data;
+        txn->flags |= TXN_DELAYED_TX;
+        break;
       }
-      rx_data = seg->rx_data;
-      break;
 
-    case TXN_DELAY:
-      tx_data = seg->tx_data;
-      rx_data = seg->rx_data;
-      txn->flags |= TXN_DELAYED_TX;
-      break;
+      buffer_offset += seg->size;
     }
 
     txn->size += seg->size;
 
-    if (last_seg != NULL && last_seg->rx_data == rx_data && last_seg->tx_data == tx_data) {
+    if (last_seg != NULL && !direct && !last_direct && last_seg->rx_data == rx_data && last_seg->tx_data == tx_data) {
       // merge segments
       last_seg->size += seg->size;
       continue;
@@ -171,14 +254,18 @@ void spi_seg_submit_ex(spi_bus_device_t *bus, spi_txn_done_fn_t done_fn, const s
       failloop(FAILLOOP_SPI);
     }
 
-    if (rx_data) {
+    if (rx_data && !direct) {
       txn->flags |= TXN_DELAYED_RX;
     }
+    if (direct) {
+      txn->direct_segments |= (1 << txn->segment_count);
+    }
 
     last_seg = &txn->segments[txn->segment_count];
     last_seg->rx_data = rx_data;
     last_seg->tx_data = tx_data;
     last_seg->size = seg->size;
+    last_direct = direct;
     txn->segment_count++;
   }
 
@@ -206,9 +293,14 @@ void spi_txn_finish(spi_bus_device_t *bus) {
   spi_txn_t *txn = bus->txns[tail];
 
   if (txn->flags & TXN_DELAYED_RX) {
+    dma_finish_rx_memory(txn->buffer, txn->buffer_size);
+
     uint32_t txn_size = 0;
     for (uint32_t i = 0; i < txn->segment_count; ++i) {
       spi_txn_segment_t *seg = &txn->segments[i];
+      if (spi_txn_is_direct(txn, i)) {
+        continue;
+      }
       if (seg->rx_data) {
         memcpy(seg->rx_data, (uint8_t *)txn->buffer + txn_size, seg->size);
       }
@@ -220,7 +312,9 @@ void spi_txn_finish(spi_bus_device_t *bus) {
     txn->done_fn();
   }
 
-  dma_mem_free(txn->buffer);
+  if (txn->buffer) {
+    dma_mem_free(txn->buffer);
+  }
 
   ATOMIC_BLOCK_ALL {
     txn->buffer = NULL;
@@ -24,6 +24,8 @@ typedef struct {
 
 #define SPI_TXN_MAX 32
 #define SPI_TXN_SEG_MAX 8
+// smaller segments are cheaper to copy through the pool than to give their own dma transfer
+#define SPI_TXN_DIRECT_MIN_SIZE 32
 
 typedef enum {
   TXN_CONST,
@@ -76,6 +78,10 @@ typedef struct {
   uint8_t flags;
   spi_txn_segment_t segments[SPI_TXN_SEG_MAX];
   uint8_t segment_count;
+  uint8_t direct_segments; // bitmask, dma'd straight from and to the caller buffers
+
+  uint8_t chunk_segment; // first segment of the next transfer
+  uint32_t chunk_offset; // pool offset of the next transfer
 
   uint8_t *buffer;
   uint32_t buffer_size;
@@ -118,6 +124,7 @@ void spi_bus_device_reconfigure(spi_bus_device_t *bus, spi_mode_t mode, uint32_t
 
 bool spi_txn_ready(spi_bus_device_t *bus);
 void spi_txn_continue(spi_bus_device_t *bus);
+bool spi_txn_continue_chunk(spi_bus_device_t *bus);
 void spi_txn_wait(spi_bus_device_t *bus);
 
 void spi_seg_submit_ex(spi_bus_device_t *bus, spi_txn_done_fn_t done_fn, const spi_txn_segment_t *segs, const uint32_t count);
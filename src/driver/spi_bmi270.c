@@ -14,16 +14,17 @@
 #define SPI_SPEED_SLOW MHZ_TO_HZ(0.5)
 #define SPI_SPEED_FAST MHZ_TO_HZ(10.5)
 
-extern spi_bus_device_t gyro_bus;
+extern spi_bus_device_t *gyro_bus;
+extern uint8_t gyro_index;
 extern const uint8_t bmi270_config_file[8192];
 
-static int8_t gyro_cas = 0;
+static int8_t gyro_cas[GYRO_MAX] = {0};
 
 static void bmi270_reset_to_spi() {
   // put the device in spi mode by toggeling CS
-  gpio_pin_reset(gyro_bus.nss);
+  gpio_pin_reset(gyro_bus->nss);
   time_delay_ms(1);
-  gpio_pin_set(gyro_bus.nss);
+  gpio_pin_set(gyro_bus->nss);
   time_delay_ms(10);
 }
 
@@ -60,6 +61,13 @@ static void bmi270_init_config() {
   bmi270_write(BMI270_REG_INT1_IO_CTRL, BMI270_INT1_IO_CTRL_PINMODE, 1);
   bmi270_write(BMI270_REG_PWR_CONF, BMI270_PWR_CONF, 1);
   bmi270_write(BMI270_REG_PWR_CTRL, BMI270_PWR_CTRL, 1);
+
+#ifdef USE_GYRO_FIFO
+  bmi270_write(BMI270_REG_FIFO_DOWNS, BMI270_FIFO_DOWNS_FILTERED, 1);
+  bmi270_write(BMI270_REG_FIFO_CONFIG_0, BMI270_FIFO_CONFIG_0, 1);
+  bmi270_write(BMI270_REG_FIFO_CONFIG_1, BMI270_FIFO_CONFIG_1, 1);
+  bmi270_write(BMI270_REG_CMD, BMI270_CMD_FIFOFLUSH, 1);
+#endif
 }
 
 static int8_t bmi270_compute_gyro_cas(uint8_t raw) {
@@ -80,7 +88,7 @@ static void bmi270_enable_cas() {
   bmi270_write(BMI270_REG_FEAT_PAGE, 0, 1);
 
   const uint8_t cas_factor = bmi270_read(BMI270_REG_FEATURES_0_GYR_CAS);
-  gyro_cas = bmi270_compute_gyro_cas(cas_factor);
+  gyro_cas[gyro_index] = bmi270_compute_gyro_cas(cas_factor);
 }
 
 static void bmi270_enable_crt() {
@@ -125,115 +133,177 @@ void bmi270_calibrate() {
 }
 
 uint8_t bmi270_read(uint8_t reg) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
 
   uint8_t buffer[3] = {reg | 0x80, 0x0, 0x0};
 
   const spi_txn_segment_t segs[] = {
       spi_make_seg_buffer(buffer, buffer, 3),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
 
   return buffer[2];
 }
 
 uint16_t bmi270_read16(uint8_t reg) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
 
   uint8_t buffer[4] = {reg | 0x80, 0x0, 0x0, 0x0};
 
   const spi_txn_segment_t segs[] = {
       spi_make_seg_buffer(buffer, buffer, 4),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
 
   return ((buffer[3] << 8) | buffer[2]);
 }
 
 void bmi270_write(uint8_t reg, uint8_t data, uint32_t delay) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
 
   const spi_txn_segment_t segs[] = {
       spi_make_seg_const(reg),
       spi_make_seg_const(data),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
 
   time_delay_ms(delay);
 }
 
 void bmi270_write16(uint8_t reg, uint16_t data, uint32_t delay) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
 
   const spi_txn_segment_t segs[] = {
       spi_make_seg_const(reg),
       spi_make_seg_const(data & 0xff),
       spi_make_seg_const(data >> 8),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
 
   time_delay_ms(delay);
 }
 
 void bmi270_write_data(uint8_t reg, uint8_t *data, uint32_t size, uint32_t delay) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
 
   const spi_txn_segment_t segs[] = {
       spi_make_seg_const(reg),
       spi_make_seg_buffer(NULL, data, size),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
 
   time_delay_ms(delay);
 }
 
 void bmi270_read_data(uint8_t reg, uint8_t *data, uint32_t size) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_FAST);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_FAST);
 
   const spi_txn_segment_t segs[] = {
       spi_make_seg_const(reg | 0x80),
       spi_make_seg_const(0xFF),
       spi_make_seg_buffer(data, NULL, size),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
+}
+
+static int16_t bmi270_apply_cas(int16_t x, int16_t z) {
+  const int32_t tempx = x - (int16_t)(gyro_cas[gyro_index] * z / 512);
+  if (tempx > 32767) {
+    return 32767;
+  } else if (tempx < -32768) {
+    return -32768;
+  }
+  return tempx;
 }
 
+#ifdef USE_GYRO_FIFO
 void bmi270_read_gyro_data(gyro_data_t *data) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_FAST);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_FAST);
 
-  uint8_t buf[12];
+  // registers from the accel data up to the fifo length
+  uint8_t buf[26];
   const spi_txn_segment_t gyro_segs[] = {
       spi_make_seg_const(BMI270_REG_ACC_DATA_X_LSB | 0x80),
       spi_make_seg_const(0xFF),
-      spi_make_seg_buffer(buf, NULL, 12),
+      spi_make_seg_buffer(buf, NULL, sizeof(buf)),
   };
-  spi_seg_submit_wait(&gyro_bus, gyro_segs);
+  spi_seg_submit_wait(gyro_bus, gyro_segs);
 
   data->accel.roll = -(int16_t)((buf[1] << 8) | buf[0]);
   data->accel.pitch = -(int16_t)((buf[3] << 8) | buf[2]);
   data->accel.yaw = (int16_t)((buf[5] << 8) | buf[4]);
 
-  int16_t gyro_data[3] = {
-      (int16_t)((buf[7] << 8) | buf[6]),
-      (int16_t)((buf[9] << 8) | buf[8]),
-      (int16_t)((buf[11] << 8) | buf[10]),
-  };
+  data->temp = 0;
 
-  const int32_t tempx = gyro_data[0] - (int16_t)(gyro_cas * (int16_t)(gyro_data[2]) / 512);
-  if (tempx > 32767) {
-    gyro_data[0] = 32767;
-  } else if (tempx < -32768) {
-    gyro_data[0] = -32768;
-  } else {
-    gyro_data[0] = tempx;
+  const uint16_t fifo_length = ((buf[25] & 0x3F) << 8) | buf[24];
+
+  const uint32_t frames = min(fifo_length / BMI270_FIFO_FRAME_SIZE, BMI270_FIFO_MAX_FRAMES);
+
+  // only pop the frames counted above, anything arriving during the burst stays for the next loop
+  static uint8_t fifo[MEMORY_ALIGN(BMI270_FIFO_MAX_FRAMES * BMI270_FIFO_FRAME_SIZE, DMA_CACHE_LINE_SIZE)] DMA_CACHE_ALIGNED;
+  if (frames > 0) {
+    const spi_txn_segment_t fifo_segs[] = {
+        spi_make_seg_const(BMI270_REG_FIFO_DATA | 0x80),
+        spi_make_seg_const(0xFF),
+        spi_make_seg_buffer(fifo, NULL, frames * BMI270_FIFO_FRAME_SIZE),
+    };
+    spi_seg_submit_wait(gyro_bus, fifo_segs);
   }
 
-  data->gyro.pitch = gyro_data[0];
-  data->gyro.roll = gyro_data[1];
-  data->gyro.yaw = gyro_data[2];
+  if (fifo_length > BMI270_FIFO_MAX_FRAMES * BMI270_FIFO_FRAME_SIZE) {
+    // we fell behind, drop the backlog instead of lagging from here on
+    bmi270_write(BMI270_REG_CMD, BMI270_CMD_FIFOFLUSH, 0);
+  }
+
+  if (frames == 0) {
+    // no new sample since the last loop, the register snapshot holds the latest one
+    const int16_t gyro_z = (int16_t)((buf[11] << 8) | buf[10]);
+
+    data->gyro.pitch = bmi270_apply_cas((int16_t)((buf[7] << 8) | buf[6]), gyro_z);
+    data->gyro.roll = (int16_t)((buf[9] << 8) | buf[8]);
+    data->gyro.yaw = gyro_z;
+    return;
+  }
+
+  int32_t sum[3] = {0, 0, 0};
+  for (uint32_t i = 0; i < frames; i++) {
+    const uint8_t *frame = fifo + i * BMI270_FIFO_FRAME_SIZE;
+    sum[0] += (int16_t)((frame[1] << 8) | frame[0]);
+    sum[1] += (int16_t)((frame[3] << 8) | frame[2]);
+    sum[2] += (int16_t)((frame[5] << 8) | frame[4]);
+  }
+
+  // average down to loop rate
+  const float scale = 1.0f / (float)frames;
+  data->gyro.pitch = bmi270_apply_cas(sum[0] * scale, sum[2] * scale);
+  data->gyro.roll = (float)sum[1] * scale;
+  data->gyro.yaw = (float)sum[2] * scale;
+}
+#else
+void bmi270_read_gyro_data(gyro_data_t *data) {
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_FAST);
+
+  uint8_t buf[12];
+  const spi_txn_segment_t gyro_segs[] = {
+      spi_make_seg_const(BMI270_REG_ACC_DATA_X_LSB | 0x80),
+      spi_make_seg_const(0xFF),
+      spi_make_seg_buffer(buf, NULL, 12),
+  };
+  spi_seg_submit_wait(gyro_bus, gyro_segs);
+
+  data->accel.roll = -(int16_t)((buf[1] << 8) | buf[0]);
+  data->accel.pitch = -(int16_t)((buf[3] << 8) | buf[2]);
+  data->accel.yaw = (int16_t)((buf[5] << 8) | buf[4]);
+
+  const int16_t gyro_z = (int16_t)((buf[11] << 8) | buf[10]);
+
+  data->gyro.pitch = bmi270_apply_cas((int16_t)((buf[7] << 8) | buf[6]), gyro_z);
+  data->gyro.roll = (int16_t)((buf[9] << 8) | buf[8]);
+  data->gyro.yaw = gyro_z;
 
   data->temp = 0;
 }
+#endif
 
 const uint8_t bmi270_config_file[8192] = {
     0xc8, 0x2e, 0x00, 0x2e, 0x80, 0x2e, 0x3d, 0xb1, 0xc8, 0x2e, 0x00, 0x2e, 0x80, 0x2e, 0x91, 0x03, 0x80, 0x2e, 0xbc,
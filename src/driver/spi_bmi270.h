@@ -83,6 +83,10 @@
 #define BMI270_FIFO_DOWNS 0x00             // select unfiltered gyro data with no downsampling (6.4KHz samples)
 #define BMI270_FIFO_WTM_0 0x06             // set the FIFO watermark level to 1 gyro sample (6 bytes)
 #define BMI270_FIFO_WTM_1 0x00             // FIFO watermark MSB
+#define BMI270_FIFO_DOWNS_FILTERED 0x08    // gyr_fifo_filt_data, select filtered gyro data at the configured odr
+
+#define BMI270_FIFO_FRAME_SIZE 6 // headerless gyro frame
+#define BMI270_FIFO_MAX_FRAMES 4
 
 #define BMI270_GYRO_CAS_MASK 0x7F
 #define BMI270_GYRO_CAS_SIGN_BIT_MASK 0x40
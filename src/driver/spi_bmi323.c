@@ -12,15 +12,16 @@
 #define SPI_SPEED_SLOW MHZ_TO_HZ(4)
 #define SPI_SPEED_FAST MHZ_TO_HZ(10)
 
-extern spi_bus_device_t gyro_bus;
+extern spi_bus_device_t *gyro_bus;
+extern uint8_t gyro_index;
 
-static int8_t gyro_cas = 0; // not ready
+static int8_t gyro_cas[GYRO_MAX] = {0}; // not ready
 
 static void bmi323_reset_to_spi() {
   // put the device in spi mode by toggeling CS
-  gpio_pin_reset(gyro_bus.nss);
+  gpio_pin_reset(gyro_bus->nss);
   time_delay_ms(1);
-  gpio_pin_set(gyro_bus.nss);
+  gpio_pin_set(gyro_bus->nss);
   time_delay_ms(10);
 }
 
@@ -106,81 +107,81 @@ void bmi323_configure() {
 }
 
 uint8_t bmi3_read8(uint8_t reg) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
 
   uint8_t buffer[3] = {reg | 0x80, 0x0, 0x0};
 
   const spi_txn_segment_t segs[] = {
       spi_make_seg_buffer(buffer, buffer, 3),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
 
   return buffer[2];
 }
 
 uint16_t bmi3_read16(uint8_t reg) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
 
   uint8_t buffer[4] = {reg | 0x80, 0x0, 0x0, 0x0};
 
   const spi_txn_segment_t segs[] = {
       spi_make_seg_buffer(buffer, buffer, 4),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
 
   return ((buffer[3] << 8) | buffer[2]);
 }
 
 void bmi3_write8(uint8_t reg, uint8_t data, uint32_t delay) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
 
   const spi_txn_segment_t segs[] = {
       spi_make_seg_const(reg),
       spi_make_seg_const(data),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
 
   time_delay_ms(delay);
 }
 
 void bmi3_write16(uint8_t reg, uint16_t data, uint32_t delay) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
 
   const spi_txn_segment_t segs[] = {
       spi_make_seg_const(reg),
       spi_make_seg_const(data & 0xff),
       spi_make_seg_const(data >> 8),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
 
   time_delay_ms(delay);
 }
 
 void bmi3_write_data(uint8_t reg, uint8_t *data, uint32_t size, uint32_t delay) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
 
   const spi_txn_segment_t segs[] = {
       spi_make_seg_const(reg),
       spi_make_seg_buffer(NULL, data, size),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
 
   time_delay_ms(delay);
 }
 
 void bmi3_read_data(uint8_t reg, uint8_t *data, uint32_t size) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_FAST);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_FAST);
 
   const spi_txn_segment_t segs[] = {
       spi_make_seg_const(reg | 0x80),
       spi_make_seg_const(0xFF),
       spi_make_seg_buffer(data, NULL, size),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
 }
 
 void bmi323_read_gyro_data(gyro_data_t *data) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_FAST);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_FAST);
 
   uint8_t buf[12];
   const spi_txn_segment_t gyro_segs[] = {
@@ -188,7 +189,7 @@ void bmi323_read_gyro_data(gyro_data_t *data) {
       spi_make_seg_const(0xFF),
       spi_make_seg_buffer(buf, NULL, 12),
   };
-  spi_seg_submit_wait(&gyro_bus, gyro_segs);
+  spi_seg_submit_wait(gyro_bus, gyro_segs);
 
   data->accel.roll = -(int16_t)((buf[1] << 8) | buf[0]);
   data->accel.pitch = -(int16_t)((buf[3] << 8) | buf[2]);
@@ -200,7 +201,7 @@ void bmi323_read_gyro_data(gyro_data_t *data) {
       (int16_t)((buf[11] << 8) | buf[10]),
   };
 
-  const int32_t tempx = gyro_data[0] - (int16_t)(gyro_cas * (int16_t)(gyro_data[2]) / 512);
+  const int32_t tempx = gyro_data[0] - (int16_t)(gyro_cas[gyro_index] * (int16_t)(gyro_data[2]) / 512);
   if (tempx > 32767) {
     gyro_data[0] = 32767;
   } else if (tempx < -32768) {
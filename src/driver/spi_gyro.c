@@ -1,5 +1,8 @@
 #include "driver/spi_gyro.h"
 
+#include <math.h>
+
+#include "core/profile.h"
 #include "core/project.h"
 #include "driver/spi.h"
 #include "driver/time.h"
@@ -11,9 +14,32 @@
 
 #ifdef USE_GYRO
 
+// samples further apart than this are not averaged, ~100deg/s in raw units
+#define GYRO_OUTLIER_LIMIT 1640.0f
+
+// sensor to sensor offset is tracked over ~1s, at 8k loop
+#define GYRO_OFFSET_COEFF 0.99988f
+#define GYRO_NOISE_COEFF 0.999f
+
+// type and bus of the selected sensor, used by the drivers
 gyro_types_t gyro_type = GYRO_TYPE_INVALID;
+spi_bus_device_t *gyro_bus = NULL;
+uint8_t gyro_index = 0;
 
-spi_bus_device_t gyro_bus = {};
+static gyro_types_t gyro_types[GYRO_MAX] = {GYRO_TYPE_INVALID};
+static spi_bus_device_t gyro_buses[GYRO_MAX] = {};
+static uint8_t gyro_count = 0;
+
+static gyro_data_t gyro_last[GYRO_MAX];
+static float gyro_noise_sq[GYRO_MAX];
+static vec3_t gyro_offset;
+static vec3_t gyro_fused;
+
+static void gyro_select(uint8_t index) {
+  gyro_index = index;
+  gyro_bus = &gyro_buses[index];
+  gyro_type = gyro_types[index];
+}
 
 static gyro_types_t gyro_spi_detect() {
   gyro_types_t type = GYRO_TYPE_INVALID;
@@ -61,24 +87,14 @@ static gyro_types_t gyro_spi_detect() {
   return type;
 }
 
-uint8_t gyro_spi_init() {
-#ifdef GYRO_INT
-  // Interrupt GPIO
-  gpio_config_t gpio_init;
-  gpio_init.mode = GPIO_INPUT;
-  gpio_init.output = GPIO_PUSHPULL;
-  gpio_init.pull = GPIO_UP_PULL;
-  gpio_init.drive = GPIO_DRIVE_HIGH;
-  gpio_pin_init(GYRO_INT, gpio_init);
-#endif
-
-  if (!target_gyro_spi_device_valid(&target.gyro)) {
+static gyro_types_t gyro_spi_configure(const target_gyro_spi_device_t *dev) {
+  if (!target_gyro_spi_device_valid(dev)) {
     return GYRO_TYPE_INVALID;
   }
 
-  gyro_bus.port = target.gyro.port;
-  gyro_bus.nss = target.gyro.nss;
-  spi_bus_device_init(&gyro_bus);
+  gyro_bus->port = dev->port;
+  gyro_bus->nss = dev->nss;
+  spi_bus_device_init(gyro_bus);
 
   gyro_type = gyro_spi_detect();
 
@@ -111,8 +127,79 @@ uint8_t gyro_spi_init() {
   return gyro_type;
 }
 
-gyro_data_t gyro_spi_read() {
-  static gyro_data_t data;
+uint8_t gyro_spi_init() {
+#ifdef GYRO_INT
+  // Interrupt GPIO
+  gpio_config_t gpio_init;
+  gpio_init.mode = GPIO_INPUT;
+  gpio_init.output = GPIO_PUSHPULL;
+  gpio_init.pull = GPIO_UP_PULL;
+  gpio_init.drive = GPIO_DRIVE_HIGH;
+  gpio_pin_init(GYRO_INT, gpio_init);
+#endif
+
+  const target_gyro_spi_device_t *devs[GYRO_MAX] = {
+      &target.gyro,
+      &target.gyro2,
+  };
+
+  gyro_count = 0;
+  for (uint8_t i = 0; i < GYRO_MAX; i++) {
+    gyro_select(gyro_count);
+
+    const gyro_types_t type = gyro_spi_configure(devs[i]);
+    if (type == GYRO_TYPE_INVALID) {
+      if (i == 0) {
+        // without the primary sensor there is nothing to fuse against
+        break;
+      }
+      continue;
+    }
+
+    gyro_types[gyro_count] = type;
+    gyro_noise_sq[gyro_count] = 0;
+    gyro_count++;
+  }
+
+  for (uint8_t i = 0; i < 3; i++) {
+    gyro_offset.axis[i] = 0;
+    gyro_fused.axis[i] = 0;
+  }
+
+  gyro_select(0);
+  return gyro_types[0];
+}
+
+uint8_t gyro_spi_count() {
+  return gyro_count;
+}
+
+gyro_types_t gyro_spi_type(uint8_t index) {
+  return gyro_types[index];
+}
+
+// false if any fused sensor does not report its temperature
+bool gyro_spi_has_temp() {
+  for (uint8_t i = 0; i < gyro_count; i++) {
+    switch (gyro_types[i]) {
+    case GYRO_TYPE_BMI270:
+    case GYRO_TYPE_BMI323:
+      return false;
+
+    default:
+      break;
+    }
+  }
+  return gyro_count > 0;
+}
+
+// rms of the sample to sample difference, in raw units
+float gyro_spi_noise(uint8_t index) {
+  return sqrtf(gyro_noise_sq[index] * 0.5f);
+}
+
+static void gyro_spi_read_sensor(uint8_t index, gyro_data_t *data) {
+  gyro_select(index);
 
   switch (gyro_type) {
   case GYRO_TYPE_MPU6000:
@@ -121,22 +208,22 @@ gyro_data_t gyro_spi_read() {
   case GYRO_TYPE_ICM20602:
   case GYRO_TYPE_ICM20608:
   case GYRO_TYPE_ICM20689: {
-    mpu6xxx_read_gyro_data(&data);
+    mpu6xxx_read_gyro_data(data);
     break;
   }
 
   case GYRO_TYPE_ICM42605:
   case GYRO_TYPE_ICM42688P: {
-    icm42605_read_gyro_data(&data);
+    icm42605_read_gyro_data(data);
     break;
   }
 
   case GYRO_TYPE_BMI270: {
-    bmi270_read_gyro_data(&data);
+    bmi270_read_gyro_data(data);
     break;
   }
   case GYRO_TYPE_BMI323: {
-    bmi323_read_gyro_data(&data);
+    bmi323_read_gyro_data(data);
     break;
   }
 
@@ -144,18 +231,107 @@ gyro_data_t gyro_spi_read() {
     break;
   }
 
+  float noise = 0;
+  for (uint8_t i = 0; i < 3; i++) {
+    const float diff = data->gyro.axis[i] - gyro_last[index].gyro.axis[i];
+    noise += diff * diff;
+  }
+  gyro_noise_sq[index] = gyro_noise_sq[index] * GYRO_NOISE_COEFF + (noise * (1.0f / 3.0f)) * (1.0f - GYRO_NOISE_COEFF);
+  gyro_last[index] = *data;
+}
+
+// only right angle rotations and the flip, the sensors are expected to share the board plane
+static void gyro_spi_rotate(gyro_data_t *data, uint8_t orientation) {
+  float temp = 0;
+
+  if (orientation & GYRO_ROTATE_90_CW) {
+    temp = data->accel.pitch;
+    data->accel.pitch = data->accel.roll;
+    data->accel.roll = -temp;
+
+    temp = data->gyro.pitch;
+    data->gyro.pitch = -data->gyro.roll;
+    data->gyro.roll = temp;
+  }
+
+  if (orientation & GYRO_ROTATE_90_CCW) {
+    temp = data->accel.pitch;
+    data->accel.pitch = -data->accel.roll;
+    data->accel.roll = temp;
+
+    temp = data->gyro.pitch;
+    data->gyro.pitch = data->gyro.roll;
+    data->gyro.roll = -temp;
+  }
+
+  if (orientation & GYRO_ROTATE_180) {
+    data->accel.pitch = -data->accel.pitch;
+    data->accel.roll = -data->accel.roll;
+
+    data->gyro.pitch = -data->gyro.pitch;
+    data->gyro.roll = -data->gyro.roll;
+  }
+
+  if (orientation & GYRO_FLIP_180) {
+    data->accel.yaw = -data->accel.yaw;
+    data->accel.roll = -data->accel.roll;
+
+    data->gyro.yaw = -data->gyro.yaw;
+    data->gyro.roll = -data->gyro.roll;
+  }
+}
+
+gyro_data_t gyro_spi_read() {
+  static gyro_data_t data;
+
+  if (gyro_count < 2) {
+    gyro_spi_read_sensor(0, &data);
+    return data;
+  }
+
+  // both sensors are read back to back, so the samples line up within a few us
+  gyro_data_t second;
+  gyro_spi_read_sensor(0, &data);
+  gyro_spi_read_sensor(1, &second);
+  gyro_select(0);
+
+  gyro_spi_rotate(&second, target.gyro2_orientation);
+
+  for (uint8_t i = 0; i < 3; i++) {
+    const float a = data.gyro.axis[i];
+    const float b = second.gyro.axis[i] - gyro_offset.axis[i];
+
+    if (fabsf(a - b) < GYRO_OUTLIER_LIMIT) {
+      gyro_offset.axis[i] = gyro_offset.axis[i] * GYRO_OFFSET_COEFF + (second.gyro.axis[i] - a) * (1.0f - GYRO_OFFSET_COEFF);
+      data.gyro.axis[i] = (a + b) * 0.5f;
+    } else {
+      // one sensor glitched, keep the one closer to the last fused sample
+      const float last = gyro_fused.axis[i];
+      data.gyro.axis[i] = fabsf(a - last) < fabsf(b - last) ? a : b;
+    }
+    gyro_fused.axis[i] = data.gyro.axis[i];
+
+    data.accel.axis[i] = (data.accel.axis[i] + second.accel.axis[i]) * 0.5f;
+  }
+  data.temp = (data.temp + second.temp) * 0.5f;
+
   return data;
 }
 
 void gyro_spi_calibrate() {
-  switch (gyro_type) {
-  case GYRO_TYPE_BMI270: {
-    bmi270_calibrate();
-    break;
-  }
+  for (uint8_t i = 0; i < gyro_count; i++) {
+    gyro_select(i);
 
-  default:
-    break;
+    switch (gyro_type) {
+    case GYRO_TYPE_BMI270: {
+      bmi270_calibrate();
+      break;
+    }
+
+    default:
+      break;
+    }
   }
+  gyro_select(0);
 }
 #endif
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdbool.h>
+
 #include "util/vector.h"
 
 typedef enum {
@@ -30,4 +32,9 @@ extern gyro_types_t gyro_type;
 
 uint8_t gyro_spi_init();
 gyro_data_t gyro_spi_read();
-void gyro_spi_calibrate();
\ No newline at end of file
+void gyro_spi_calibrate();
+
+uint8_t gyro_spi_count();
+gyro_types_t gyro_spi_type(uint8_t index);
+float gyro_spi_noise(uint8_t index);
+bool gyro_spi_has_temp();
\ No newline at end of file
@@ -20,7 +20,7 @@
 #define AAF_DELTSQR 25
 #define AAF_BITSHIFT 10
 
-extern spi_bus_device_t gyro_bus;
+extern spi_bus_device_t *gyro_bus;
 
 uint8_t icm42605_detect() {
   const uint8_t id = icm42605_read(ICM42605_WHO_AM_I);
@@ -82,40 +82,112 @@ void icm42605_configure() {
 
   icm42605_write(ICM42605_ACCEL_CONFIG0, ICM42605_AFS_16G | ICM42605_AODR_8000Hz);
   time_delay_ms(15);
+
+#ifdef USE_GYRO_FIFO
+  icm42605_write(ICM42605_FIFO_CONFIG1, ICM42605_FIFO_GYRO_EN);
+  icm42605_write(ICM42605_FIFO_CONFIG, ICM42605_FIFO_MODE_STREAM);
+  icm42605_write(ICM42605_SIGNAL_PATH_RESET, ICM42605_FIFO_FLUSH);
+#endif
 }
 
 uint8_t icm42605_read(uint8_t reg) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
 
   uint8_t buffer[2] = {reg | 0x80, 0x00};
 
   const spi_txn_segment_t segs[] = {
       spi_make_seg_buffer(buffer, buffer, 2),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
 
   return buffer[1];
 }
 
 void icm42605_write(uint8_t reg, uint8_t data) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_SLOW);
 
   const spi_txn_segment_t segs[] = {
       spi_make_seg_const(reg),
       spi_make_seg_const(data),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
 }
 
+#ifdef USE_GYRO_FIFO
+void icm42605_read_gyro_data(gyro_data_t *data) {
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_FAST);
+
+  // registers from temperature up to the fifo count
+  uint8_t buf[19];
+  const spi_txn_segment_t segs[] = {
+      spi_make_seg_const(ICM42605_TEMP_DATA1 | 0x80),
+      spi_make_seg_buffer(buf, NULL, sizeof(buf)),
+  };
+  spi_seg_submit_wait(gyro_bus, segs);
+
+  data->temp = (float)((int16_t)((buf[0] << 8) | buf[1])) / 132.48f + 25.f;
+
+  data->accel.roll = -(int16_t)((buf[2] << 8) | buf[3]);
+  data->accel.pitch = -(int16_t)((buf[4] << 8) | buf[5]);
+  data->accel.yaw = (int16_t)((buf[6] << 8) | buf[7]);
+
+  const uint16_t fifo_count = (buf[17] << 8) | buf[18];
+  const uint32_t pending = min(fifo_count / ICM42605_FIFO_FRAME_SIZE, ICM42605_FIFO_MAX_FRAMES);
+
+  // only pop the frames counted above, anything arriving during the burst stays for the next loop.
+  // kept off the stack and line aligned so a whole line burst can go straight into it
+  static uint8_t fifo[MEMORY_ALIGN(ICM42605_FIFO_MAX_FRAMES * ICM42605_FIFO_FRAME_SIZE, DMA_CACHE_LINE_SIZE)] DMA_CACHE_ALIGNED;
+  if (pending > 0) {
+    const spi_txn_segment_t fifo_segs[] = {
+        spi_make_seg_const(ICM42605_FIFO_DATA | 0x80),
+        spi_make_seg_buffer(fifo, NULL, pending * ICM42605_FIFO_FRAME_SIZE),
+    };
+    spi_seg_submit_wait(gyro_bus, fifo_segs);
+  }
+
+  int32_t sum[3] = {0, 0, 0};
+  uint32_t frames = 0;
+  for (uint32_t i = 0; i < pending; i++) {
+    const uint8_t *frame = fifo + i * ICM42605_FIFO_FRAME_SIZE;
+    if ((frame[0] & ICM42605_FIFO_HEADER_EMPTY) || !(frame[0] & ICM42605_FIFO_HEADER_GYRO)) {
+      break;
+    }
+
+    sum[0] += (int16_t)((frame[1] << 8) | frame[2]);
+    sum[1] += (int16_t)((frame[3] << 8) | frame[4]);
+    sum[2] += (int16_t)((frame[5] << 8) | frame[6]);
+    frames++;
+  }
+
+  if (fifo_count > ICM42605_FIFO_MAX_FRAMES * ICM42605_FIFO_FRAME_SIZE) {
+    // we fell behind, drop the backlog instead of lagging from here on
+    icm42605_write(ICM42605_SIGNAL_PATH_RESET, ICM42605_FIFO_FLUSH);
+  }
+
+  if (frames == 0) {
+    // no new sample since the last loop, the register snapshot holds the latest one
+    data->gyro.pitch = (int16_t)((buf[8] << 8) | buf[9]);
+    data->gyro.roll = (int16_t)((buf[10] << 8) | buf[11]);
+    data->gyro.yaw = (int16_t)((buf[12] << 8) | buf[13]);
+    return;
+  }
+
+  // average down to loop rate
+  const float scale = 1.0f / (float)frames;
+  data->gyro.pitch = (float)sum[0] * scale;
+  data->gyro.roll = (float)sum[1] * scale;
+  data->gyro.yaw = (float)sum[2] * scale;
+}
+#else
 void icm42605_read_gyro_data(gyro_data_t *data) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_FAST);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_FAST);
 
   uint8_t buf[14];
   const spi_txn_segment_t segs[] = {
       spi_make_seg_const(ICM42605_TEMP_DATA1 | 0x80),
       spi_make_seg_buffer(buf, NULL, 14),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
 
   data->temp = (float)((int16_t)((buf[0] << 8) | buf[1])) / 132.48f + 25.f;
 
@@ -127,4 +199,5 @@ void icm42605_read_gyro_data(gyro_data_t *data) {
   data->gyro.roll = (int16_t)((buf[10] << 8) | buf[11]);
   data->gyro.yaw = (int16_t)((buf[12] << 8) | buf[13]);
 }
+#endif
 #endif
\ No newline at end of file
@@ -189,6 +189,17 @@
 #define ICM42605_INT_TPULSE_DURATION_100 (0 << ICM42605_INT_TPULSE_DURATION_BIT)
 #define ICM42605_INT_TPULSE_DURATION_8 (1 << ICM42605_INT_TPULSE_DURATION_BIT)
 
+#define ICM42605_FIFO_MODE_STREAM (1 << 6)
+#define ICM42605_FIFO_GYRO_EN (1 << 1)
+#define ICM42605_FIFO_FLUSH (1 << 1)
+
+#define ICM42605_FIFO_HEADER_EMPTY (1 << 7)
+#define ICM42605_FIFO_HEADER_GYRO (1 << 5)
+
+// packet 1: header, gyro xyz, temperature
+#define ICM42605_FIFO_FRAME_SIZE 8
+#define ICM42605_FIFO_MAX_FRAMES 6
+
 #define ICM42605_INTF_CONFIG1_AFSR_MASK 0xC0
 #define ICM42605_INTF_CONFIG1_AFSR_DISABLE 0x40
 
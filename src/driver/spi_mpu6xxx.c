@@ -21,7 +21,7 @@
 
 #define SPI_SPEED_INIT MHZ_TO_HZ(0.5)
 
-extern spi_bus_device_t gyro_bus;
+extern spi_bus_device_t *gyro_bus;
 
 static uint32_t mpu6xxx_fast_divider() {
   switch (gyro_type) {
@@ -89,38 +89,38 @@ void mpu6xxx_configure() {
 
 // blocking dma read of a single register
 uint8_t mpu6xxx_read(uint8_t reg) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_INIT);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_INIT);
 
   uint8_t buffer[2] = {reg | 0x80, 0x00};
 
   const spi_txn_segment_t segs[] = {
       spi_make_seg_buffer(buffer, buffer, 2),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
 
   return buffer[1];
 }
 
 // blocking dma write of a single register
 void mpu6xxx_write(uint8_t reg, uint8_t data) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_INIT);
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, SPI_SPEED_INIT);
 
   const spi_txn_segment_t segs[] = {
       spi_make_seg_const(reg),
       spi_make_seg_const(data),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
 }
 
 void mpu6xxx_read_gyro_data(gyro_data_t *data) {
-  spi_bus_device_reconfigure(&gyro_bus, SPI_MODE_TRAILING_EDGE, mpu6xxx_fast_divider());
+  spi_bus_device_reconfigure(gyro_bus, SPI_MODE_TRAILING_EDGE, mpu6xxx_fast_divider());
 
   uint8_t buf[14];
   const spi_txn_segment_t segs[] = {
       spi_make_seg_const(MPU_RA_ACCEL_XOUT_H | 0x80),
       spi_make_seg_buffer(buf, NULL, 14),
   };
-  spi_seg_submit_wait(&gyro_bus, segs);
+  spi_seg_submit_wait(gyro_bus, segs);
 
   data->accel.roll = -(int16_t)((buf[0] << 8) | buf[1]);
   data->accel.pitch = -(int16_t)((buf[2] << 8) | buf[3]);
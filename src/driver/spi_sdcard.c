@@ -5,6 +5,7 @@
 #include "core/project.h"
 #include "driver/spi.h"
 #include "driver/time.h"
+#include "util/cbor_helper.h"
 #include "util/util.h"
 
 #ifdef USE_SDCARD
@@ -32,6 +33,7 @@ typedef enum {
   SDCARD_WRITE_MULTIPLE_CONTINUE,
   SDCARD_WRITE_MULTIPLE_VERIFY,
   SDCARD_WRITE_MULTIPLE_SECTOR_SUCCESS,
+  SDCARD_WRITE_MULTIPLE_SECTOR_ERROR,
   SDCARD_WRITE_MULTIPLE_FINISH,
   SDCARD_WRITE_MULTIPLE_FINISH_WAIT,
   SDCARD_WRITE_MULTIPLE_DONE
@@ -52,12 +54,32 @@ typedef struct {
 
 #define SPI_SPEED_SLOW MHZ_TO_HZ(0.5)
 #define SPI_SPEED_FAST MHZ_TO_HZ(25)
+#define SPI_SPEED_HIGH MHZ_TO_HZ(50)
+
+// data response token, xxx00101 means the sector was accepted
+#define DATA_RESPONSE_MASK 0x1F
+#define DATA_RESPONSE_ACCEPTED 0x05
 
 sdcard_info_t sdcard_info;
+sdcard_stats_t sdcard_stats;
 
 static volatile sdcard_state_t state = SDCARD_POWER_UP;
 static sdcard_operation_t operation;
 
+static uint8_t write_response = 0xFF;
+static uint32_t busy_start = 0;
+
+static uint32_t rate_start = 0;
+static uint32_t rate_bytes = 0;
+
+#define MEMBER CBOR_ENCODE_MEMBER
+
+CBOR_START_STRUCT_ENCODER(sdcard_stats_t)
+SDCARD_STATS_MEMBERS
+CBOR_END_STRUCT_ENCODER()
+
+#undef MEMBER
+
 static spi_bus_device_t bus = {
     .auto_continue = false,
 };
@@ -278,6 +300,48 @@ static void sdcard_parse_csd(sdcard_csd_t *csd, uint8_t *c) {
   }
 }
 
+// TRAN_SPEED is a rate unit (100kbit/s * 10^n) times a value scaled by 10
+static uint32_t sdcard_parse_tran_speed(const uint8_t tran_speed) {
+  static const uint32_t units[] = {100000, 1000000, 10000000, 100000000};
+  static const uint8_t values[] = {0, 10, 12, 13, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60, 70, 80};
+
+  const uint8_t unit = tran_speed & 0x7;
+  if (unit >= 4) {
+    return SPI_SPEED_FAST;
+  }
+  return units[unit] / 10 * values[(tran_speed >> 3) & 0xF];
+}
+
+// CMD6 switch function, group 1 to high-speed, valid for class 10 cards
+static bool sdcard_switch_high_speed() {
+  if (sdcard_info.version != 2 || (sdcard_info.csd.v2.CCC & (1 << 10)) == 0) {
+    return false;
+  }
+
+  if (sdcard_command(SDCARD_SWITCH_FUNC, 0x80FFFFF1) != 0x0) {
+    return false;
+  }
+
+  uint8_t status[64] = {0};
+  sdcard_read_data(status, 64);
+
+  // bits 379:376 hold the function selected for group 1
+  return (status[16] & 0x0F) == 0x1;
+}
+
+static void sdcard_update_rate(const uint32_t bytes) {
+  const uint32_t now = time_millis();
+  if (rate_bytes == 0) {
+    rate_start = now;
+  }
+
+  rate_bytes += bytes;
+  if ((now - rate_start) >= 1000) {
+    sdcard_stats.write_rate = rate_bytes * 1000 / (now - rate_start);
+    rate_bytes = 0;
+  }
+}
+
 sdcard_status_t sdcard_update() {
   if (!sdcard_read_detect()) {
     return SDCARD_WAIT;
@@ -399,7 +463,16 @@ sdcard_status_t sdcard_update() {
       }
     }
 
-    spi_bus_device_reconfigure(&bus, SPI_MODE_LEADING_EDGE, SPI_SPEED_FAST);
+    const sdcard_csd_t *csd = &sdcard_info.csd;
+    const uint8_t tran_speed = csd->CSD_STRUCTURE_VER == 0 ? csd->v1.TRAN_SPEED : csd->v2.TRAN_SPEED;
+    sdcard_info.spi_hz = min(sdcard_parse_tran_speed(tran_speed), SPI_SPEED_FAST);
+
+    sdcard_info.high_speed = sdcard_switch_high_speed();
+    if (sdcard_info.high_speed) {
+      sdcard_info.spi_hz = SPI_SPEED_HIGH;
+    }
+
+    spi_bus_device_reconfigure(&bus, SPI_MODE_LEADING_EDGE, sdcard_info.spi_hz);
     state = SDCARD_READY;
     break;
   }
@@ -477,20 +550,40 @@ sdcard_status_t sdcard_update() {
         spi_make_seg_const(0xFF),
 
         // write response
-        spi_make_seg_const(0xFF),
+        spi_make_seg_buffer(&write_response, NULL, 1),
     };
     spi_seg_submit_continue(&bus, NULL, segs);
 
+    busy_start = 0;
     state = SDCARD_WRITE_MULTIPLE_VERIFY;
     break;
   }
 
   case SDCARD_WRITE_MULTIPLE_VERIFY: {
+    // sector is on the wire, the card holds the line low until it has been programmed
+    if (busy_start == 0) {
+      busy_start = time_micros();
+    }
     if (!sdcard_wait_for_idle()) {
       break;
     }
 
+    sdcard_stats.busy_last_us = time_micros() - busy_start;
+    if (sdcard_stats.busy_last_us > sdcard_stats.busy_max_us) {
+      sdcard_stats.busy_max_us = sdcard_stats.busy_last_us;
+    }
+
     operation.count_done++;
+
+    if ((write_response & DATA_RESPONSE_MASK) != DATA_RESPONSE_ACCEPTED) {
+      sdcard_stats.write_errors++;
+      state = SDCARD_WRITE_MULTIPLE_SECTOR_ERROR;
+      break;
+    }
+
+    sdcard_stats.sectors_written++;
+    sdcard_update_rate(SDCARD_PAGE_SIZE);
+
     state = SDCARD_WRITE_MULTIPLE_SECTOR_SUCCESS;
     break;
   }
@@ -517,6 +610,7 @@ sdcard_status_t sdcard_update() {
   case SDCARD_READY:
   case SDCARD_WRITE_MULTIPLE_READY:
   case SDCARD_WRITE_MULTIPLE_SECTOR_SUCCESS:
+  case SDCARD_WRITE_MULTIPLE_SECTOR_ERROR:
   case SDCARD_WRITE_MULTIPLE_DONE:
   case SDCARD_READ_MULTIPLE_DONE:
     return SDCARD_IDLE;
@@ -587,7 +681,8 @@ uint8_t sdcard_write_pages_start(uint32_t sector, uint32_t count) {
     return 0;
   }
 
-  if (sdcard_app_command(SDCARD_ACMD_SET_WR_BLK_ERASE_COUNT, count * 2) != 0x0) {
+  // pre-erase hint only, the session may run past it
+  if (sdcard_app_command(SDCARD_ACMD_SET_WR_BLK_ERASE_COUNT, count) != 0x0) {
     return 0;
   }
 
@@ -618,8 +713,13 @@ uint8_t sdcard_write_pages_continue(uint8_t *buf) {
   return 0;
 }
 
+// the card did not accept the last sector, the session has to be closed before it can be written again
+uint8_t sdcard_write_pages_rejected() {
+  return state == SDCARD_WRITE_MULTIPLE_SECTOR_ERROR;
+}
+
 uint8_t sdcard_write_pages_finish() {
-  if (state == SDCARD_WRITE_MULTIPLE_SECTOR_SUCCESS) {
+  if (state == SDCARD_WRITE_MULTIPLE_SECTOR_SUCCESS || state == SDCARD_WRITE_MULTIPLE_SECTOR_ERROR) {
     state = SDCARD_WRITE_MULTIPLE_READY;
     return 0;
   }
@@ -639,8 +739,8 @@ uint8_t sdcard_write_page(uint8_t *buf, uint32_t sector) {
   if (state == SDCARD_READY) {
     sdcard_write_pages_start(sector, 1);
   }
-  if (state == SDCARD_WRITE_MULTIPLE_SECTOR_SUCCESS) {
-    sdcard_write_pages_continue(buf);
+  if (state == SDCARD_WRITE_MULTIPLE_SECTOR_SUCCESS || state == SDCARD_WRITE_MULTIPLE_SECTOR_ERROR) {
+    state = SDCARD_WRITE_MULTIPLE_READY;
   }
   if (state == SDCARD_WRITE_MULTIPLE_DONE) {
     if (sdcard_write_pages_finish()) {
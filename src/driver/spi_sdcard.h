@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cbor.h>
 #include <stdint.h>
 
 #include "io/blackbox_device.h"
@@ -8,6 +9,7 @@
 
 typedef enum {
   SDCARD_GO_IDLE = 0,
+  SDCARD_SWITCH_FUNC = 6,
   SDCARD_IF_COND = 8,
   SDCARD_CSD = 9,
   SDCARD_CID = 10,
@@ -117,12 +119,34 @@ typedef struct {
 
   uint8_t high_capacity;
 
+  uint8_t high_speed;
+  uint32_t spi_hz;
+
   uint32_t ocr;
   sdcard_cid_t cid;
   sdcard_csd_t csd;
 
 } sdcard_info_t;
 
+typedef struct {
+  uint32_t sectors_written;
+  uint32_t write_errors;
+  uint32_t write_rate;   // bytes per second over the last second of writing
+  uint32_t busy_max_us;  // worst case the card held busy after a sector
+  uint32_t busy_last_us; // busy time of the most recent sector
+} sdcard_stats_t;
+
+#define SDCARD_STATS_MEMBERS          \
+  MEMBER(sectors_written, uint32_t)   \
+  MEMBER(write_errors, uint32_t)      \
+  MEMBER(write_rate, uint32_t)        \
+  MEMBER(busy_max_us, uint32_t)       \
+  MEMBER(busy_last_us, uint32_t)
+
+extern sdcard_stats_t sdcard_stats;
+
+cbor_result_t cbor_encode_sdcard_stats_t(cbor_value_t *enc, const sdcard_stats_t *s);
+
 typedef enum {
   SDCARD_WAIT,
   SDCARD_ERROR,
@@ -140,4 +164,5 @@ uint8_t sdcard_write_page(uint8_t *buf, uint32_t page);
 
 uint8_t sdcard_write_pages_start(uint32_t page, uint32_t count);
 uint8_t sdcard_write_pages_continue(uint8_t *buf);
+uint8_t sdcard_write_pages_rejected();
 uint8_t sdcard_write_pages_finish();
@@ -28,6 +28,9 @@ static uint8_t payload_len = 8;
 extern volatile uint32_t packet_time_us;
 extern volatile uint8_t packet_status[2];
 
+// periodBase = 1ms, page 71 datasheet, set to FF for cont RX
+static const uint8_t rx_command[4] = {SX1280_RADIO_SET_RX, 0x00, 0xFF, 0xFF};
+
 static bool sx128x_spi_device_valid(const target_rx_spi_device_t *dev) {
   if (dev->port == SPI_PORT_INVALID || dev->nss == PIN_NONE) {
     return false;
@@ -291,11 +294,10 @@ void sx128x_set_mode_async(const sx128x_modes_t mode) {
     break;
 
   case SX1280_MODE_RX: {
-    uint8_t buf[3];
-    buf[0] = 0x00; // periodBase = 1ms, page 71 datasheet, set to FF for cont RX
-    buf[1] = 0xFF;
-    buf[2] = 0xFF;
-    sx128x_write_command_burst(SX1280_RADIO_SET_RX, buf, 3);
+    static const spi_txn_segment_t segs[] = {
+        spi_make_seg_buffer(NULL, rx_command, 4),
+    };
+    spi_seg_submit(&bus, NULL, segs);
     break;
   }
 
@@ -427,6 +429,24 @@ void sx128x_set_frequency(const uint32_t freq) {
   sx128x_write_command_burst(SX1280_RADIO_SET_RFFREQUENCY, buf, 3);
 }
 
+// freq_image is the 3 byte big endian SET_RFFREQUENCY payload, prepared ahead of time by the fhss code
+void sx128x_hop_async(const uint8_t *freq_image, bool enter_rx) {
+  {
+    const spi_txn_segment_t segs[] = {
+        spi_make_seg_const(SX1280_RADIO_SET_RFFREQUENCY),
+        spi_make_seg_buffer(NULL, freq_image, 3),
+    };
+    spi_seg_submit(&bus, NULL, segs);
+  }
+  if (enter_rx) {
+    static const spi_txn_segment_t segs[] = {
+        spi_make_seg_buffer(NULL, rx_command, 4),
+    };
+    spi_seg_submit(&bus, NULL, segs);
+  }
+  spi_txn_continue(&bus);
+}
+
 void sx128x_set_dio_irq_params(const uint16_t irq_mask, const uint16_t dio1_mask, const uint16_t dio2_mask, const uint16_t dio3_mask) {
   const uint8_t buf[8] = {
       (uint8_t)((irq_mask >> 8) & 0x00FF),
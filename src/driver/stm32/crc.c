@@ -0,0 +1,72 @@
+#include "driver/crc.h"
+
+#include "driver/rcc.h"
+
+#if defined(STM32F7) || defined(STM32H7)
+
+static bool crc_hw_initialized = false;
+static volatile bool crc_hw_busy = false;
+
+static void crc_hw_init() {
+#ifdef STM32H7
+  rcc_enable(RCC_AHB4_GRP1(CRC));
+#else
+  rcc_enable(RCC_AHB1_GRP1(CRC));
+#endif
+
+  LL_CRC_SetInputDataReverseMode(CRC, LL_CRC_INDATA_REVERSE_NONE);
+  LL_CRC_SetOutputDataReverseMode(CRC, LL_CRC_OUTDATA_REVERSE_NONE);
+
+  crc_hw_initialized = true;
+}
+
+bool crc_hw_calc(uint8_t bits, uint32_t poly, uint32_t *crc, const uint8_t *data, uint32_t size) {
+  uint32_t poly_size = 0;
+  switch (bits) {
+  case 8:
+    poly_size = LL_CRC_POLYLENGTH_8B;
+    break;
+  case 16:
+    poly_size = LL_CRC_POLYLENGTH_16B;
+    break;
+  default:
+    return false;
+  }
+
+  if (crc_hw_busy) {
+    // interrupted a calculation in progress
+    return false;
+  }
+  crc_hw_busy = true;
+
+  if (!crc_hw_initialized) {
+    crc_hw_init();
+  }
+
+  LL_CRC_SetPolynomialSize(CRC, poly_size);
+  LL_CRC_SetPolynomialCoef(CRC, poly);
+  LL_CRC_SetInitialData(CRC, *crc);
+  LL_CRC_ResetCRCCalculationUnit(CRC);
+
+  for (uint32_t i = 0; i < size; i++) {
+    LL_CRC_FeedData8(CRC, data[i]);
+  }
+
+  if (bits == 8) {
+    *crc = LL_CRC_ReadData8(CRC);
+  } else {
+    *crc = LL_CRC_ReadData16(CRC);
+  }
+
+  crc_hw_busy = false;
+  return true;
+}
+
+#else
+
+// the f4 unit only does the fixed crc32 polynomial
+bool crc_hw_calc(uint8_t bits, uint32_t poly, uint32_t *crc, const uint8_t *data, uint32_t size) {
+  return false;
+}
+
+#endif
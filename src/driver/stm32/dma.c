@@ -3,12 +3,12 @@
 #include "driver/rcc.h"
 
 // DMA1 Stream0 SPI3_RX
-// DMA1 Stream1
-// DMA1 Stream2
+// DMA1 Stream1 TIM2_UP
+// DMA1 Stream2 TIM3_UP
 // DMA1 Stream3 SPI2_RX
 // DMA1 Stream4 SPI2_TX
 // DMA1 Stream5
-// DMA1 Stream6
+// DMA1 Stream6 TIM4_UP
 // DMA1 Stream7 SPI3_TX
 
 // DMA2 Stream0 SPI4_RX
@@ -18,7 +18,7 @@
 // DMA2 Stream4 TIM1_CH4
 // DMA2 Stream5 SPI1_TX
 // DMA2 Stream6 TIM1_CH3
-// DMA2 Stream7
+// DMA2 Stream7 TIM8_CH4
 
 #define DMA_STREAMS             \
   DMA_STREAM(2, 3, 2, SPI1_RX)  \
@@ -31,7 +31,18 @@
   DMA_STREAM(2, 4, 1, SPI4_TX)  \
   DMA_STREAM(2, 6, 3, TIM1_CH1) \
   DMA_STREAM(2, 6, 6, TIM1_CH3) \
-  DMA_STREAM(2, 6, 4, TIM1_CH4)
+  DMA_STREAM(2, 6, 4, TIM1_CH4) \
+  DMA_STREAM(1, 3, 1, TIM2_UP)  \
+  DMA_STREAM(1, 5, 2, TIM3_UP)  \
+  DMA_STREAM(1, 2, 6, TIM4_UP)  \
+  DMA_STREAMS_TIM8
+
+// the f411 has no tim8
+#ifdef STM32F411
+#define DMA_STREAMS_TIM8
+#else
+#define DMA_STREAMS_TIM8 DMA_STREAM(2, 7, 7, TIM8_CH4)
+#endif
 
 #ifdef STM32H7
 #define DMA_STREAM(_port, _chan, _stream, _dev)   \
@@ -66,26 +77,66 @@ const dma_stream_def_t dma_stream_defs[DMA_DEVICE_MAX] = {DMA_STREAMS};
 #undef DMA_STREAM
 
 #if defined(STM32F7) || defined(STM32H7)
-#define CACHE_LINE_SIZE 32
-#define CACHE_LINE_MASK (CACHE_LINE_SIZE - 1)
+#define CACHE_LINE_MASK (DMA_CACHE_LINE_SIZE - 1)
+
+// dtcm and the dma ram are never cached
+#define WITHIN_CACHED_RAM(p) (!WITHIN_DTCM_RAM(p) && !WITHIN_DMA_RAM(p))
+
+// every line touched by [addr, addr + size)
+#define CACHE_LINE_START(addr) ((uint32_t *)((uint32_t)(addr) & ~CACHE_LINE_MASK))
+#define CACHE_LINE_SPAN(addr, size) (((((uint32_t)(addr) + (size)) + CACHE_LINE_MASK) & ~CACHE_LINE_MASK) - ((uint32_t)(addr) & ~CACHE_LINE_MASK))
 #endif
 
 void dma_prepare_tx_memory(void *addr, uint32_t size) {
 #if defined(STM32F7) || defined(STM32H7)
-  if (!WITHIN_DTCM_RAM(addr) && !WITHIN_DMA_RAM(addr)) {
-    SCB_CleanDCache_by_Addr((uint32_t *)((uint32_t)addr & ~CACHE_LINE_MASK), (size + CACHE_LINE_SIZE) & ~CACHE_LINE_MASK);
+  if (WITHIN_CACHED_RAM(addr)) {
+    SCB_CleanDCache_by_Addr(CACHE_LINE_START(addr), CACHE_LINE_SPAN(addr, size));
   }
 #endif
 }
 
 void dma_prepare_rx_memory(void *addr, uint32_t size) {
 #if defined(STM32F7) || defined(STM32H7)
-  if (!WITHIN_DTCM_RAM(addr) && !WITHIN_DMA_RAM(addr)) {
-    SCB_CleanInvalidateDCache_by_Addr((uint32_t *)((uint32_t)addr & ~CACHE_LINE_MASK), (size + CACHE_LINE_SIZE) & ~CACHE_LINE_MASK);
+  if (WITHIN_CACHED_RAM(addr)) {
+    SCB_CleanInvalidateDCache_by_Addr(CACHE_LINE_START(addr), CACHE_LINE_SPAN(addr, size));
+  }
+#endif
+}
+
+// the m7 may speculatively refill lines while the dma is still writing, drop them again
+void dma_finish_rx_memory(void *addr, uint32_t size) {
+#if defined(STM32F7) || defined(STM32H7)
+  if (WITHIN_CACHED_RAM(addr)) {
+    SCB_InvalidateDCache_by_Addr(CACHE_LINE_START(addr), CACHE_LINE_SPAN(addr, size));
   }
 #endif
 }
 
+// caller owned memory the dma can read straight from
+bool dma_can_use_tx_memory(const void *addr, uint32_t size) {
+#if defined(STM32F7) || defined(STM32H7)
+  return WITHIN_DMA_CAPABLE_RAM(addr) && WITHIN_DMA_CAPABLE_RAM((const uint8_t *)addr + size - 1);
+#else
+  return false;
+#endif
+}
+
+// like tx, but cached buffers also have to own all of their cache lines,
+// otherwise the invalidate after the transfer discards neighbouring data
+bool dma_can_use_rx_memory(void *addr, uint32_t size) {
+#if defined(STM32F7) || defined(STM32H7)
+  if (!dma_can_use_tx_memory(addr, size)) {
+    return false;
+  }
+  if (WITHIN_CACHED_RAM(addr)) {
+    return ((uint32_t)addr & CACHE_LINE_MASK) == 0 && (size & CACHE_LINE_MASK) == 0;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
 void dma_enable_rcc(dma_device_t dev) {
   const dma_stream_def_t *dma = &dma_stream_defs[dev];
   switch (dma->port_index) {
@@ -179,6 +230,7 @@ void dma_clear_flag_tc(dma_device_t dev) {
 
 extern void dshot_dma_isr(dma_device_t dev);
 extern void spi_dma_isr(dma_device_t dev);
+extern void rgb_dma_isr(dma_device_t dev);
 
 static void handle_dma_stream_isr(dma_device_t dev) {
   switch (dev) {
@@ -195,8 +247,19 @@ static void handle_dma_stream_isr(dma_device_t dev) {
   case DMA_DEVICE_TIM1_CH1:
   case DMA_DEVICE_TIM1_CH3:
   case DMA_DEVICE_TIM1_CH4:
+  case DMA_DEVICE_TIM8_CH4:
+#ifdef USE_MOTOR_DSHOT
+    dshot_dma_isr(dev);
+#endif
+    break;
+  case DMA_DEVICE_TIM2_UP:
+  case DMA_DEVICE_TIM3_UP:
+  case DMA_DEVICE_TIM4_UP:
 #ifdef USE_MOTOR_DSHOT
     dshot_dma_isr(dev);
+#endif
+#ifdef USE_RGB_LED
+    rgb_dma_isr(dev);
 #endif
     break;
   case DMA_DEVICE_MAX:
@@ -2,20 +2,39 @@
 
 #include <stdint.h>
 
+#include "core/failloop.h"
 #include "core/profile.h"
 #include "core/project.h"
 #include "driver/dma.h"
 #include "driver/gpio.h"
 #include "driver/interrupt.h"
 #include "driver/rcc.h"
+#include "driver/rgb_led.h"
 #include "driver/spi.h"
+#include "driver/timer.h"
 
 #ifdef USE_MOTOR_DSHOT
 
-#define DSHOT_TIME profile.motor.dshot_time
+#define DSHOT_TIME dshot_time
 #define DSHOT_SYMBOL_TIME (PWM_CLOCK_FREQ_HZ / (3 * DSHOT_TIME * 1000) - 1)
 
+// timer engine, one compare value per bit, a 0 is high for 3/8 and a 1 for 3/4 of it
+#define DSHOT_BIT_TIME (PWM_CLOCK_FREQ_HZ / (DSHOT_TIME * 1000) - 1)
+#define DSHOT_T0H_TIME (((DSHOT_BIT_TIME + 1) * 3) / 8)
+#define DSHOT_T1H_TIME (((DSHOT_BIT_TIME + 1) * 3) / 4)
+
+// only tim2 - tim4 have an update dma request in our stream map
+#define DSHOT_MAX_TIMER_COUNT 3
+// every update bursts ccr1 - ccr4, unused channels just get zeros
+#define DSHOT_TIMER_CHANNELS 4
+#define DSHOT_TIMER_BUFFER_SIZE ((16 + 2) * DSHOT_TIMER_CHANNELS)
+
+// tim8 paces a fourth gpio port where the mcu has one
+#ifdef STM32F411
 #define DSHOT_MAX_PORT_COUNT 3
+#else
+#define DSHOT_MAX_PORT_COUNT 4
+#endif
 #define DSHOT_DMA_BUFFER_SIZE (3 * (16 + 2))
 
 typedef struct {
@@ -23,6 +42,7 @@ typedef struct {
   uint32_t pin;
 
   uint32_t dshot_port;
+  uint32_t timer_slot; // ccr index within the burst, timer engine only
 } dshot_pin_t;
 
 typedef struct {
@@ -31,10 +51,17 @@ typedef struct {
   uint32_t port_low;  // motor pins for BSRRL, for setting pins low
   uint32_t port_high; // motor pins for BSRRH, for setting pins high
 
+  timer_index_t timer;
   uint32_t timer_channel;
   dma_device_t dma_device;
 } dshot_gpio_port_t;
 
+typedef struct {
+  timer_index_t timer;
+  uint32_t channels;
+  dma_device_t dma_device;
+} dshot_timer_port_t;
+
 extern uint16_t dshot_packet[MOTOR_PIN_MAX];
 extern motor_direction_t motor_dir;
 
@@ -43,22 +70,48 @@ volatile uint32_t dshot_dma_phase = 0; // 0: idle, 1 - (gpio_port_count + 1): ha
 static uint8_t gpio_port_count = 0;
 static dshot_gpio_port_t gpio_ports[DSHOT_MAX_PORT_COUNT] = {
     {
+        .timer = TIMER1,
         .timer_channel = LL_TIM_CHANNEL_CH1,
         .dma_device = DMA_DEVICE_TIM1_CH1,
     },
     {
+        .timer = TIMER1,
         .timer_channel = LL_TIM_CHANNEL_CH3,
         .dma_device = DMA_DEVICE_TIM1_CH3,
     },
     {
+        .timer = TIMER1,
         .timer_channel = LL_TIM_CHANNEL_CH4,
         .dma_device = DMA_DEVICE_TIM1_CH4,
     },
+#ifndef STM32F411
+    {
+        .timer = TIMER8,
+        .timer_channel = LL_TIM_CHANNEL_CH4,
+        .dma_device = DMA_DEVICE_TIM8_CH4,
+    },
+#endif
 };
 static volatile DMA_RAM uint32_t port_dma_buffer[DSHOT_MAX_PORT_COUNT][DSHOT_DMA_BUFFER_SIZE];
 static dshot_pin_t dshot_pins[MOTOR_PIN_MAX];
 
+static bool dshot_timer_mode = false;
+static uint8_t timer_port_count = 0;
+static dshot_timer_port_t timer_ports[DSHOT_MAX_TIMER_COUNT];
+static volatile DMA_RAM uint32_t timer_dma_buffer[DSHOT_MAX_TIMER_COUNT][DSHOT_TIMER_BUFFER_SIZE];
+
+static uint16_t dshot_time = DSHOT_TIME_600;
+static uint32_t dshot_t0h_time = 0;
+static uint32_t dshot_t1h_time = 0;
+
 static void dshot_init_motor_pin(uint32_t index) {
+  if (target.motor_pins[index] == PIN_NONE) {
+    dshot_pins[index].port = NULL;
+    dshot_pins[index].pin = 0;
+    dshot_pins[index].dshot_port = 0;
+    return;
+  }
+
   dshot_pins[index].port = gpio_pin_defs[target.motor_pins[index]].port;
   dshot_pins[index].pin = gpio_pin_defs[target.motor_pins[index]].pin;
   dshot_pins[index].dshot_port = 0;
@@ -99,8 +152,9 @@ static void dshot_init_gpio_port(dshot_gpio_port_t *port) {
   tim_oc_init.OCState = LL_TIM_OCSTATE_ENABLE;
   tim_oc_init.OCPolarity = LL_TIM_OCPOLARITY_LOW;
   tim_oc_init.CompareValue = 10;
-  LL_TIM_OC_Init(TIM1, port->timer_channel, &tim_oc_init);
-  LL_TIM_OC_EnablePreload(TIM1, port->timer_channel);
+  timer_dev_t *tim = timer_defs[port->timer].instance;
+  LL_TIM_OC_Init(tim, port->timer_channel, &tim_oc_init);
+  LL_TIM_OC_EnablePreload(tim, port->timer_channel);
 
   const dma_stream_def_t *dma = &dma_stream_defs[port->dma_device];
 
@@ -133,59 +187,283 @@ static void dshot_init_gpio_port(dshot_gpio_port_t *port) {
   LL_DMA_EnableIT_TC(dma->port, dma->stream_index);
 }
 
-static void dshot_enable_dma_request(uint32_t timer_channel) {
-  switch (timer_channel) {
+static void dshot_enable_dma_request(const dshot_gpio_port_t *port) {
+  timer_dev_t *tim = timer_defs[port->timer].instance;
+  switch (port->timer_channel) {
   case LL_TIM_CHANNEL_CH1:
-    LL_TIM_EnableDMAReq_CC1(TIM1);
+    LL_TIM_EnableDMAReq_CC1(tim);
     break;
   case LL_TIM_CHANNEL_CH3:
-    LL_TIM_EnableDMAReq_CC3(TIM1);
+    LL_TIM_EnableDMAReq_CC3(tim);
     break;
   case LL_TIM_CHANNEL_CH4:
-    LL_TIM_EnableDMAReq_CC4(TIM1);
+    LL_TIM_EnableDMAReq_CC4(tim);
     break;
   default:
     break;
   }
 }
 
-static void dshot_disable_dma_request(uint32_t timer_channel) {
-  switch (timer_channel) {
+static void dshot_disable_dma_request(const dshot_gpio_port_t *port) {
+  timer_dev_t *tim = timer_defs[port->timer].instance;
+  switch (port->timer_channel) {
   case LL_TIM_CHANNEL_CH1:
-    LL_TIM_DisableDMAReq_CC1(TIM1);
+    LL_TIM_DisableDMAReq_CC1(tim);
     break;
   case LL_TIM_CHANNEL_CH3:
-    LL_TIM_DisableDMAReq_CC3(TIM1);
+    LL_TIM_DisableDMAReq_CC3(tim);
     break;
   case LL_TIM_CHANNEL_CH4:
-    LL_TIM_DisableDMAReq_CC4(TIM1);
+    LL_TIM_DisableDMAReq_CC4(tim);
     break;
   default:
     break;
   }
 }
 
-void motor_dshot_init() {
-  gpio_port_count = 0;
-
-  rcc_enable(RCC_APB2_GRP1(TIM1));
-  rcc_enable(RCC_AHB1_GRP1(DMA2));
+static void dshot_init_timer(timer_index_t timer) {
+  rcc_enable(timer_defs[timer].rcc);
 
   // setup timer to 1/3 of the full bit time
-
   LL_TIM_InitTypeDef tim_init;
   LL_TIM_StructInit(&tim_init);
   tim_init.Autoreload = DSHOT_SYMBOL_TIME;
   tim_init.Prescaler = 0;
   tim_init.ClockDivision = 0;
   tim_init.CounterMode = LL_TIM_COUNTERMODE_UP;
-  LL_TIM_Init(TIM1, &tim_init);
-  LL_TIM_EnableARRPreload(TIM1);
+  LL_TIM_Init(timer_defs[timer].instance, &tim_init);
+  LL_TIM_EnableARRPreload(timer_defs[timer].instance);
+}
+
+static dma_device_t dshot_timer_dma_device(timer_index_t tim) {
+  switch (tim) {
+  case TIMER2:
+    return DMA_DEVICE_TIM2_UP;
+  case TIMER3:
+    return DMA_DEVICE_TIM3_UP;
+  case TIMER4:
+    return DMA_DEVICE_TIM4_UP;
+  default:
+    return DMA_DEVICE_MAX;
+  }
+}
+
+static uint32_t dshot_timer_slot(timer_channel_t ch) {
+  switch (ch) {
+  case TIMER_CH1:
+    return 0;
+  case TIMER_CH2:
+    return 1;
+  case TIMER_CH3:
+    return 2;
+  case TIMER_CH4:
+    return 3;
+  default:
+    return DSHOT_TIMER_CHANNELS;
+  }
+}
+
+// first timer function of the pin that has an update dma and a channel no other motor took
+static const gpio_af_t *dshot_timer_pin_af(gpio_pins_t pin, uint32_t *used_channels) {
+  for (uint32_t j = 0; j < GPIO_AF_MAX; j++) {
+    const gpio_af_t *func = &gpio_pin_afs[j];
+    if (func->pin != pin || RESOURCE_TAG_TYPE(func->tag) != RESOURCE_TIM) {
+      continue;
+    }
+
+    const timer_index_t tim = TIMER_TAG_TIM(func->tag);
+    const timer_channel_t ch = TIMER_TAG_CH(func->tag);
+    if (dshot_timer_dma_device(tim) == DMA_DEVICE_MAX || dshot_timer_slot(ch) == DSHOT_TIMER_CHANNELS) {
+      continue;
+    }
+    if (used_channels[tim] & ch) {
+      continue;
+    }
+
+    used_channels[tim] |= ch;
+    return func;
+  }
+  return NULL;
+}
+
+static void dshot_init_timer_port(dshot_timer_port_t *port, volatile uint32_t *buffer) {
+  timer_dev_t *tim = timer_defs[port->timer].instance;
+
+  timer_up_init(port->timer, 1, DSHOT_BIT_TIME);
+  LL_TIM_EnableARRPreload(tim);
+
+  for (uint32_t i = 0; i < DSHOT_TIMER_CHANNELS; i++) {
+    const timer_channel_t ch = TIMER_CH1 << (i * 2);
+    if (!(port->channels & ch)) {
+      continue;
+    }
+
+    LL_TIM_OC_InitTypeDef tim_oc_init;
+    LL_TIM_OC_StructInit(&tim_oc_init);
+    tim_oc_init.OCMode = LL_TIM_OCMODE_PWM1;
+    tim_oc_init.OCState = LL_TIM_OCSTATE_ENABLE;
+    tim_oc_init.OCPolarity = LL_TIM_OCPOLARITY_HIGH;
+    tim_oc_init.OCIdleState = LL_TIM_OCIDLESTATE_LOW;
+    tim_oc_init.CompareValue = 0;
+    LL_TIM_OC_Init(tim, timer_channel_val(ch), &tim_oc_init);
+    LL_TIM_OC_EnablePreload(tim, timer_channel_val(ch));
+  }
+
+  // each update request writes the next four words to ccr1 - ccr4 through dmar
+  LL_TIM_ConfigDMABurst(tim, LL_TIM_DMABURST_BASEADDR_CCR1, LL_TIM_DMABURST_LENGTH_4TRANSFERS);
+
+  const dma_stream_def_t *dma = &dma_stream_defs[port->dma_device];
+  dma_enable_rcc(port->dma_device);
+
+  LL_DMA_DeInit(dma->port, dma->stream_index);
+
+  LL_DMA_InitTypeDef DMA_InitStructure;
+  LL_DMA_StructInit(&DMA_InitStructure);
+#ifdef STM32H7
+  DMA_InitStructure.PeriphRequest = dma->request;
+#else
+  DMA_InitStructure.Channel = dma->channel;
+#endif
+  DMA_InitStructure.PeriphOrM2MSrcAddress = (uint32_t)&tim->DMAR;
+  DMA_InitStructure.MemoryOrM2MDstAddress = (uint32_t)buffer;
+  DMA_InitStructure.Direction = LL_DMA_DIRECTION_MEMORY_TO_PERIPH;
+  DMA_InitStructure.NbData = DSHOT_TIMER_BUFFER_SIZE;
+  DMA_InitStructure.PeriphOrM2MSrcIncMode = LL_DMA_PERIPH_NOINCREMENT;
+  DMA_InitStructure.MemoryOrM2MDstIncMode = LL_DMA_MEMORY_INCREMENT;
+  DMA_InitStructure.PeriphOrM2MSrcDataSize = LL_DMA_PDATAALIGN_WORD;
+  DMA_InitStructure.MemoryOrM2MDstDataSize = LL_DMA_MDATAALIGN_WORD;
+  DMA_InitStructure.Mode = LL_DMA_MODE_NORMAL;
+  DMA_InitStructure.Priority = LL_DMA_PRIORITY_VERYHIGH;
+  DMA_InitStructure.FIFOMode = LL_DMA_FIFOMODE_DISABLE;
+  DMA_InitStructure.MemBurst = LL_DMA_MBURST_SINGLE;
+  DMA_InitStructure.PeriphBurst = LL_DMA_PBURST_SINGLE;
+  LL_DMA_Init(dma->port, dma->stream_index, &DMA_InitStructure);
+
+  interrupt_enable(dma->irq, DMA_PRIORITY);
+  LL_DMA_EnableIT_TC(dma->port, dma->stream_index);
+
+  // the counter free-runs with zero compares, keeping the lines low between frames
+  LL_TIM_EnableCounter(tim);
+}
+
+// drives every motor pin from its own timer channel if the pin mapping allows it,
+// which leaves tim1 free and keeps the dma load at one word per bit and motor.
+// all resources are checked before anything is claimed, so a failed check can
+// still fall back to the gpio engine.
+static bool dshot_timer_init() {
+  const gpio_af_t *funcs[MOTOR_PIN_MAX];
+  uint32_t used_channels[TIMER_MAX] = {0};
+
+  for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
+    funcs[i] = NULL;
+    if (target.motor_pins[i] == PIN_NONE) {
+      continue;
+    }
+
+    funcs[i] = dshot_timer_pin_af(target.motor_pins[i], used_channels);
+    if (funcs[i] == NULL) {
+      return false;
+    }
+  }
+
+  gpio_config_t gpio_init;
+  gpio_init.mode = GPIO_ALTERNATE;
+  gpio_init.drive = GPIO_DRIVE_HIGH;
+  gpio_init.output = GPIO_PUSHPULL;
+  gpio_init.pull = GPIO_NO_PULL;
+
+  timer_port_count = 0;
+  for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
+    dshot_pins[i].port = NULL;
+    dshot_pins[i].pin = 0;
+    dshot_pins[i].dshot_port = 0;
+    dshot_pins[i].timer_slot = 0;
+
+    if (funcs[i] == NULL) {
+      continue;
+    }
+
+    if (!timer_alloc_tag(TIMER_USE_MOTOR_DSHOT, funcs[i]->tag)) {
+      failloop(FAILLOOP_FAULT);
+    }
+
+    const timer_index_t tim = TIMER_TAG_TIM(funcs[i]->tag);
+    const timer_channel_t ch = TIMER_TAG_CH(funcs[i]->tag);
+
+    uint32_t port = 0;
+    while (port < timer_port_count && timer_ports[port].timer != tim) {
+      port++;
+    }
+    if (port == timer_port_count) {
+      timer_ports[port].timer = tim;
+      timer_ports[port].channels = 0;
+      timer_ports[port].dma_device = dshot_timer_dma_device(tim);
+      timer_port_count++;
+    }
+    timer_ports[port].channels |= ch;
+
+    dshot_pins[i].port = gpio_pin_defs[target.motor_pins[i]].port;
+    dshot_pins[i].pin = gpio_pin_defs[target.motor_pins[i]].pin;
+    dshot_pins[i].dshot_port = port;
+    dshot_pins[i].timer_slot = dshot_timer_slot(ch);
+
+    gpio_pin_init_af(target.motor_pins[i], gpio_init, funcs[i]->af);
+  }
+
+  for (uint32_t j = 0; j < timer_port_count; j++) {
+    // zeros everywhere, the trailing bits and unused channels are never touched again
+    for (uint32_t i = 0; i < DSHOT_TIMER_BUFFER_SIZE; i++) {
+      timer_dma_buffer[j][i] = 0;
+    }
+    dshot_init_timer_port(&timer_ports[j], timer_dma_buffer[j]);
+  }
+
+  return true;
+}
+
+void motor_dshot_init() {
+  gpio_port_count = 0;
+  timer_port_count = 0;
+
+  dshot_time = profile.motor.dshot_time;
+  dshot_t0h_time = DSHOT_T0H_TIME;
+  dshot_t1h_time = DSHOT_T1H_TIME;
+
+  dshot_timer_mode = dshot_timer_init();
+  if (dshot_timer_mode) {
+    motor_dir = MOTOR_FORWARD;
+    return;
+  }
+
+#ifdef STM32F4
+  // three bsrr writes per bit and port would saturate dma2 at dshot1200
+  if (dshot_time > DSHOT_TIME_600) {
+    dshot_time = DSHOT_TIME_600;
+  }
+#endif
+
+  if (!timer_alloc_tag(TIMER_USE_MOTOR_DSHOT, TIMER_TAG(TIMER1, TIMER_CH1 | TIMER_CH3 | TIMER_CH4))) {
+    failloop(FAILLOOP_FAULT);
+  }
+
+  rcc_enable(RCC_AHB1_GRP1(DMA2));
+
+  dshot_init_timer(TIMER1);
 
   for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
     dshot_init_motor_pin(i);
   }
 
+#ifndef STM32F411
+  // only claim tim8 if the motor pins are spread over more than three ports
+  if (gpio_port_count == DSHOT_MAX_PORT_COUNT) {
+    if (!timer_alloc_tag(TIMER_USE_MOTOR_DSHOT, TIMER_TAG(TIMER8, TIMER_CH4))) {
+      failloop(FAILLOOP_FAULT);
+    }
+    dshot_init_timer(TIMER8);
+  }
+#endif
+
   for (uint32_t j = 0; j < gpio_port_count; j++) {
     dshot_init_gpio_port(&gpio_ports[j]);
 
@@ -197,6 +475,11 @@ void motor_dshot_init() {
   }
 
   LL_TIM_EnableCounter(TIM1);
+#ifndef STM32F411
+  if (gpio_port_count == DSHOT_MAX_PORT_COUNT) {
+    LL_TIM_EnableCounter(TIM8);
+  }
+#endif
   motor_dir = MOTOR_FORWARD;
 }
 
@@ -211,13 +494,55 @@ static void dshot_dma_setup_port(uint32_t index) {
   dma->stream->NDTR = DSHOT_DMA_BUFFER_SIZE;
 
   LL_DMA_EnableStream(dma->port, dma->stream_index);
-  dshot_enable_dma_request(port->timer_channel);
+  dshot_enable_dma_request(port);
+}
+
+static void dshot_timer_setup_port(uint32_t index) {
+  const dshot_timer_port_t *port = &timer_ports[index];
+  const dma_stream_def_t *dma = &dma_stream_defs[port->dma_device];
+
+  dma_clear_flag_tc(port->dma_device);
+
+  dma->stream->M0AR = (uint32_t)&timer_dma_buffer[index][0];
+  dma->stream->NDTR = DSHOT_TIMER_BUFFER_SIZE;
+
+  LL_DMA_EnableStream(dma->port, dma->stream_index);
+  LL_TIM_EnableDMAReq_UPDATE(timer_defs[port->timer].instance);
+}
+
+// one pass over the motors, each one only touches its own ccr slot
+static void dshot_timer_dma_start() {
+  for (uint8_t motor = 0; motor < MOTOR_PIN_MAX; motor++) {
+    if (dshot_pins[motor].port == NULL) {
+      continue;
+    }
+
+    volatile uint32_t *buffer = &timer_dma_buffer[dshot_pins[motor].dshot_port][dshot_pins[motor].timer_slot];
+
+    uint16_t packet = dshot_packet[motor];
+    for (uint8_t i = 0; i < 16; i++) {
+      buffer[i * DSHOT_TIMER_CHANNELS] = (packet & 0x8000) ? dshot_t1h_time : dshot_t0h_time;
+      packet <<= 1;
+    }
+  }
+
+  dma_prepare_tx_memory((void *)timer_dma_buffer, sizeof(timer_dma_buffer));
+
+  dshot_dma_phase = timer_port_count;
+  for (uint32_t j = 0; j < timer_port_count; j++) {
+    dshot_timer_setup_port(j);
+  }
 }
 
 // make dshot dma packet, then fire
-void dshot_dma_start() {
+FAST_CODE void dshot_dma_start() {
   motor_wait_for_ready();
 
+  if (dshot_timer_mode) {
+    dshot_timer_dma_start();
+    return;
+  }
+
   for (uint32_t j = 0; j < gpio_port_count; j++) {
     // set all ports to low before and after the packet
     port_dma_buffer[j][0] = gpio_ports[j].port_low;
@@ -237,6 +562,10 @@ void dshot_dma_start() {
     }
 
     for (uint8_t motor = 0; motor < MOTOR_PIN_MAX; motor++) {
+      if (dshot_pins[motor].port == NULL) {
+        continue;
+      }
+
       const uint32_t port = dshot_pins[motor].dshot_port;
       const uint32_t motor_high = (dshot_pins[motor].pin);
       const uint32_t motor_low = (dshot_pins[motor].pin << 16);
@@ -268,7 +597,34 @@ void motor_dshot_wait_for_ready() {
     __NOP();
 }
 
+static void dshot_dma_frame_done() {
+  dshot_dma_phase--;
+
+#ifdef USE_RGB_LED
+  if (dshot_dma_phase == 0) {
+    // motor frame is out, the led strip can use the rest of the loop
+    rgb_dma_fire();
+  }
+#endif
+}
+
 void dshot_dma_isr(dma_device_t dev) {
+  for (uint32_t j = 0; j < timer_port_count; j++) {
+    const dshot_timer_port_t *port = &timer_ports[j];
+    if (port->dma_device != dev) {
+      continue;
+    }
+
+    dma_clear_flag_tc(port->dma_device);
+
+    const dma_stream_def_t *dma = &dma_stream_defs[dev];
+    LL_DMA_DisableStream(dma->port, dma->stream_index);
+    LL_TIM_DisableDMAReq_UPDATE(timer_defs[port->timer].instance);
+
+    dshot_dma_frame_done();
+    return;
+  }
+
   for (uint32_t j = 0; j < gpio_port_count; j++) {
     const dshot_gpio_port_t *port = &gpio_ports[j];
     if (port->dma_device != dev) {
@@ -279,9 +635,9 @@ void dshot_dma_isr(dma_device_t dev) {
 
     const dma_stream_def_t *dma = &dma_stream_defs[dev];
     LL_DMA_DisableStream(dma->port, dma->stream_index);
-    dshot_disable_dma_request(port->timer_channel);
+    dshot_disable_dma_request(port);
 
-    dshot_dma_phase--;
+    dshot_dma_frame_done();
     break;
   }
 }
@@ -25,6 +25,9 @@ void motor_pwm_init() {
 
   for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
     const gpio_pins_t pin = target.motor_pins[i];
+    if (pin == PIN_NONE) {
+      continue;
+    }
 
     for (uint32_t j = 0; j < GPIO_AF_MAX; j++) {
       const gpio_af_t *func = &gpio_pin_afs[j];
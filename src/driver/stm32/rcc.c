@@ -43,4 +43,110 @@ void rcc_enable(rcc_reg_t reg) {
   default:
     break;
   }
-}
\ No newline at end of file
+}
+
+#if defined(STM32F411) || defined(STM32F405)
+typedef struct {
+  uint32_t hz;
+  uint16_t n;
+  uint8_t p;
+  uint8_t q;
+  uint8_t latency;
+} rcc_pll_config_t;
+
+// vco input is fixed at 1mhz by pll_m, q always lands usb on 48mhz
+// levels without an entry are not available on the mcu
+//
+// flash wait states are per mcu, the default levels match what SystemInit programs
+// and each overclock level adds one on top
+static const rcc_pll_config_t rcc_pll_configs[RCC_CLOCK_MAX] = {
+#ifdef STM32F411
+    [RCC_CLOCK_DEFAULT] = {.hz = 108000000, .n = 432, .p = 4, .q = 9, .latency = 2},
+    [RCC_CLOCK_OVERCLOCK_1] = {.hz = 120000000, .n = 240, .p = 2, .q = 5, .latency = 3},
+#endif
+#ifdef STM32F405
+    [RCC_CLOCK_DEFAULT] = {.hz = 168000000, .n = 336, .p = 2, .q = 7, .latency = 5},
+    [RCC_CLOCK_OVERCLOCK_1] = {.hz = 192000000, .n = 384, .p = 2, .q = 8, .latency = 6},
+    [RCC_CLOCK_OVERCLOCK_2] = {.hz = 216000000, .n = 432, .p = 2, .q = 9, .latency = 7},
+#endif
+};
+
+// the apb prescalers set by SystemInit are kept, timer and spi clocks are derived
+// as fixed ratios of the core clock (see PWM_CLOCK_FREQ_HZ and SPI_CLOCK_FREQ_HZ),
+// so a level is refused if it would push apb1 past its rated maximum.
+// every overclock level above does, a target has to opt in with RCC_APB1_OUT_OF_SPEC
+#ifdef STM32F411
+#define RCC_APB1_MAX_HZ 50000000
+#endif
+#ifdef STM32F405
+#define RCC_APB1_MAX_HZ 42000000
+#endif
+
+static uint32_t rcc_apb1_divider() {
+  const uint32_t ppre1 = (RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+  if ((ppre1 & 0x4) == 0) {
+    return 1;
+  }
+  return 2 << (ppre1 & 0x3);
+}
+
+// reprograms the main pll, has to run before any peripheral derives a divider from the clock
+bool rcc_set_clock(rcc_clock_t clock) {
+  if (clock == RCC_CLOCK_DEFAULT || clock >= RCC_CLOCK_MAX) {
+    return false;
+  }
+  if ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL || (RCC->PLLCFGR & RCC_PLLCFGR_PLLSRC) != RCC_PLLCFGR_PLLSRC_HSE) {
+    // hse failed to start, stay on whatever we are running on
+    return false;
+  }
+
+  const rcc_pll_config_t *config = &rcc_pll_configs[clock];
+  if (config->hz == 0) {
+    return false;
+  }
+#ifndef RCC_APB1_OUT_OF_SPEC
+  if (config->hz / rcc_apb1_divider() > RCC_APB1_MAX_HZ) {
+    return false;
+  }
+#endif
+
+  __disable_irq();
+
+  // run from hse while the pll is down
+  RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_HSE;
+  while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_HSE)
+    ;
+
+  RCC->CR &= ~RCC_CR_PLLON;
+  while (RCC->CR & RCC_CR_PLLRDY)
+    ;
+
+  RCC->PLLCFGR = (RCC->PLLCFGR & (RCC_PLLCFGR_PLLM | RCC_PLLCFGR_PLLSRC)) |
+                 (config->n << RCC_PLLCFGR_PLLN_Pos) |
+                 (((config->p >> 1) - 1) << RCC_PLLCFGR_PLLP_Pos) |
+                 (config->q << RCC_PLLCFGR_PLLQ_Pos);
+
+  FLASH->ACR = (FLASH->ACR & ~FLASH_ACR_LATENCY) | config->latency;
+  while ((FLASH->ACR & FLASH_ACR_LATENCY) != config->latency)
+    ;
+
+  RCC->CR |= RCC_CR_PLLON;
+  while ((RCC->CR & RCC_CR_PLLRDY) == 0)
+    ;
+
+  RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_PLL;
+  while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL)
+    ;
+
+  SystemCoreClockUpdate();
+
+  __enable_irq();
+
+  return true;
+}
+#else
+// f7 runs at its rated maximum, the h7 already picks its clock by silicon revision
+bool rcc_set_clock(rcc_clock_t clock) {
+  return false;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "driver/rgb_led.h"
+
+#include <stdbool.h>
+
+#include "core/project.h"
+#include "driver/dma.h"
+#include "driver/gpio.h"
+#include "driver/interrupt.h"
+#include "driver/timer.h"
+
+#ifdef USE_RGB_LED
+
+extern volatile uint32_t rgb_dma_buffer[RGB_DMA_BUFFER_SIZE];
+
+static resource_tag_t timer_tag = 0;
+static dma_device_t dma_device = DMA_DEVICE_MAX;
+
+// the update request streams the next compare value into the preloaded ccr
+static dma_device_t rgb_timer_dma_device(timer_index_t tim) {
+  switch (tim) {
+  case TIMER2:
+    return DMA_DEVICE_TIM2_UP;
+  case TIMER3:
+    return DMA_DEVICE_TIM3_UP;
+  case TIMER4:
+    return DMA_DEVICE_TIM4_UP;
+  default:
+    return DMA_DEVICE_MAX;
+  }
+}
+
+static volatile uint32_t *rgb_timer_ccr(timer_dev_t *tim, timer_channel_t ch) {
+  switch (ch) {
+  case TIMER_CH1:
+  case TIMER_CH1N:
+    return &tim->CCR1;
+  case TIMER_CH2:
+  case TIMER_CH2N:
+    return &tim->CCR2;
+  case TIMER_CH3:
+  case TIMER_CH3N:
+    return &tim->CCR3;
+  case TIMER_CH4:
+  default:
+    return &tim->CCR4;
+  }
+}
+
+bool rgb_dma_init() {
+  gpio_config_t gpio_init;
+  gpio_init.mode = GPIO_ALTERNATE;
+  gpio_init.drive = GPIO_DRIVE_HIGH;
+  gpio_init.output = GPIO_PUSHPULL;
+  gpio_init.pull = GPIO_NO_PULL;
+
+  timer_tag = 0;
+  dma_device = DMA_DEVICE_MAX;
+
+  for (uint32_t j = 0; j < GPIO_AF_MAX; j++) {
+    const gpio_af_t *func = &gpio_pin_afs[j];
+    if (func->pin != target.rgb_led || RESOURCE_TAG_TYPE(func->tag) != RESOURCE_TIM) {
+      continue;
+    }
+
+    const dma_device_t dev = rgb_timer_dma_device(TIMER_TAG_TIM(func->tag));
+    if (dev == DMA_DEVICE_MAX) {
+      continue;
+    }
+
+    if (timer_alloc_tag(TIMER_USE_RGB_LED, func->tag)) {
+      timer_tag = func->tag;
+      dma_device = dev;
+      gpio_pin_init_af(target.rgb_led, gpio_init, func->af);
+      break;
+    }
+  }
+
+  if (timer_tag == 0) {
+    return false;
+  }
+
+  const timer_index_t tim = TIMER_TAG_TIM(timer_tag);
+  const timer_channel_t ch = TIMER_TAG_CH(timer_tag);
+  timer_dev_t *instance = timer_defs[tim].instance;
+
+  timer_up_init(tim, 1, RGB_BIT_TIME);
+
+  LL_TIM_OC_InitTypeDef tim_oc_init;
+  LL_TIM_OC_StructInit(&tim_oc_init);
+  tim_oc_init.OCMode = LL_TIM_OCMODE_PWM1;
+  tim_oc_init.OCState = LL_TIM_OCSTATE_ENABLE;
+  tim_oc_init.OCPolarity = LL_TIM_OCPOLARITY_HIGH;
+  tim_oc_init.OCIdleState = LL_TIM_OCIDLESTATE_LOW;
+  tim_oc_init.CompareValue = 0;
+  LL_TIM_OC_Init(instance, timer_channel_val(ch), &tim_oc_init);
+  LL_TIM_OC_EnablePreload(instance, timer_channel_val(ch));
+
+  const dma_stream_def_t *dma = &dma_stream_defs[dma_device];
+  dma_enable_rcc(dma_device);
+
+  LL_DMA_DeInit(dma->port, dma->stream_index);
+
+  LL_DMA_InitTypeDef DMA_InitStructure;
+  LL_DMA_StructInit(&DMA_InitStructure);
+#ifdef STM32H7
+  DMA_InitStructure.PeriphRequest = dma->request;
+#else
+  DMA_InitStructure.Channel = dma->channel;
+#endif
+  DMA_InitStructure.PeriphOrM2MSrcAddress = (uint32_t)rgb_timer_ccr(instance, ch);
+  DMA_InitStructure.MemoryOrM2MDstAddress = (uint32_t)rgb_dma_buffer;
+  DMA_InitStructure.Direction = LL_DMA_DIRECTION_MEMORY_TO_PERIPH;
+  DMA_InitStructure.NbData = RGB_DMA_BUFFER_SIZE;
+  DMA_InitStructure.PeriphOrM2MSrcIncMode = LL_DMA_PERIPH_NOINCREMENT;
+  DMA_InitStructure.MemoryOrM2MDstIncMode = LL_DMA_MEMORY_INCREMENT;
+  DMA_InitStructure.PeriphOrM2MSrcDataSize = LL_DMA_PDATAALIGN_WORD;
+  DMA_InitStructure.MemoryOrM2MDstDataSize = LL_DMA_MDATAALIGN_WORD;
+  DMA_InitStructure.Mode = LL_DMA_MODE_NORMAL;
+  // dshot and spi always win the arbitration
+  DMA_InitStructure.Priority = LL_DMA_PRIORITY_LOW;
+  DMA_InitStructure.FIFOMode = LL_DMA_FIFOMODE_DISABLE;
+  DMA_InitStructure.MemBurst = LL_DMA_MBURST_SINGLE;
+  DMA_InitStructure.PeriphBurst = LL_DMA_PBURST_SINGLE;
+  LL_DMA_Init(dma->port, dma->stream_index, &DMA_InitStructure);
+
+  interrupt_enable(dma->irq, DMA_PRIORITY);
+  LL_DMA_EnableIT_TC(dma->port, dma->stream_index);
+
+  // the counter free-runs with a zero compare, keeping the line low between frames
+  LL_TIM_EnableCounter(instance);
+
+  return true;
+}
+
+void rgb_dma_trigger() {
+  const dma_stream_def_t *dma = &dma_stream_defs[dma_device];
+
+  dma_clear_flag_tc(dma_device);
+
+  dma->stream->M0AR = (uint32_t)rgb_dma_buffer;
+  dma->stream->NDTR = RGB_DMA_BUFFER_SIZE;
+
+  LL_DMA_EnableStream(dma->port, dma->stream_index);
+  LL_TIM_EnableDMAReq_UPDATE(timer_defs[TIMER_TAG_TIM(timer_tag)].instance);
+}
+
+void rgb_dma_isr(dma_device_t dev) {
+  if (dev != dma_device) {
+    return;
+  }
+
+  dma_clear_flag_tc(dev);
+
+  const dma_stream_def_t *dma = &dma_stream_defs[dev];
+  LL_DMA_DisableStream(dma->port, dma->stream_index);
+  LL_TIM_DisableDMAReq_UPDATE(timer_defs[TIMER_TAG_TIM(timer_tag)].instance);
+
+  rgb_dma_done();
+}
+
+#endif
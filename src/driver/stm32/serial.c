@@ -1,6 +1,7 @@
 #include "driver/serial.h"
 
 #include "driver/serial_soft.h"
+#include "driver/time.h"
 
 const usart_port_def_t usart_port_defs[SERIAL_PORT_MAX] = {
     {},
@@ -170,6 +171,7 @@ void serial_hard_init(serial_port_t *serial, serial_port_config_t config, bool s
 
   LL_USART_EnableIT_TC(usart_port_defs[serial->config.port].channel);
   LL_USART_EnableIT_RXNE(usart_port_defs[serial->config.port].channel);
+  LL_USART_EnableIT_IDLE(usart_port_defs[serial->config.port].channel);
 
   serial_enable_isr(serial->config.port);
 }
@@ -227,11 +229,18 @@ static void handle_serial_isr(serial_port_t *serial) {
   if (LL_USART_IsEnabledIT_RXNE(port->channel) && LL_USART_IsActiveFlag_RXNE(port->channel)) {
     const volatile uint8_t data = LL_USART_ReceiveData8(port->channel);
     ring_buffer_write(serial->rx_buffer, data);
+    serial->rx_cycles = time_cycles();
 #if defined(STM32F4)
     LL_USART_ClearFlag_RXNE(port->channel);
 #endif
   }
 
+  if (LL_USART_IsEnabledIT_IDLE(port->channel) && LL_USART_IsActiveFlag_IDLE(port->channel)) {
+    // a frame ended, keep its time even if the next one starts before it is decoded
+    serial->rx_frame_cycles = serial->rx_cycles;
+    LL_USART_ClearFlag_IDLE(port->channel);
+  }
+
   if (LL_USART_IsActiveFlag_ORE(port->channel)) {
     LL_USART_ClearFlag_ORE(port->channel);
   }
@@ -247,6 +256,7 @@ static void handle_usart_isr(serial_ports_t index) {
   const usart_port_def_t *port = &usart_port_defs[index];
   LL_USART_DisableIT_TXE(port->channel);
   LL_USART_DisableIT_RXNE(port->channel);
+  LL_USART_DisableIT_IDLE(port->channel);
   LL_USART_ClearFlag_ORE(port->channel);
   LL_USART_Disable(port->channel);
 }
@@ -49,6 +49,10 @@ extern FAST_RAM volatile spi_port_config_t spi_port_config[SPI_PORT_MAX];
 extern FAST_RAM volatile uint8_t dma_transfer_done[16];
 extern FAST_RAM spi_txn_t txn_pool[SPI_TXN_MAX];
 
+// stand-ins for segments without a tx or rx buffer, the dma does not increment over them
+static DMA_RAM uint8_t spi_dma_fill;
+static DMA_RAM uint8_t spi_dma_sink;
+
 #define PORT spi_port_defs[port]
 
 static uint32_t spi_divider_to_ll(uint32_t divider) {
@@ -150,7 +154,13 @@ static void spi_dma_reset_rx(spi_ports_t port, uint8_t *rx_data, uint32_t rx_siz
   while (LL_DMA_IsEnabledStream(dma->port, dma->stream_index))
     ;
 
-  dma_prepare_rx_memory(rx_data, rx_size);
+  if (rx_data) {
+    dma_prepare_rx_memory(rx_data, rx_size);
+    LL_DMA_SetMemoryIncMode(dma->port, dma->stream_index, LL_DMA_MEMORY_INCREMENT);
+  } else {
+    rx_data = &spi_dma_sink;
+    LL_DMA_SetMemoryIncMode(dma->port, dma->stream_index, LL_DMA_MEMORY_NOINCREMENT);
+  }
 
 #ifdef STM32H7
   LL_DMA_SetPeriphAddress(dma->port, dma->stream_index, (uint32_t)&PORT.channel->RXDR);
@@ -189,13 +199,21 @@ static void spi_dma_init_tx(spi_ports_t port) {
   LL_DMA_Init(dma->port, dma->stream_index, &DMA_InitStructure);
 }
 
-static void spi_dma_reset_tx(spi_ports_t port, uint8_t *tx_data, uint32_t tx_size) {
+static void spi_dma_reset_tx(spi_ports_t port, const uint8_t *tx_data, uint32_t tx_size) {
   const dma_stream_def_t *dma = &dma_stream_defs[PORT.dma_tx];
 
   while (LL_DMA_IsEnabledStream(dma->port, dma->stream_index))
     ;
 
-  dma_prepare_tx_memory(tx_data, tx_size);
+  if (tx_data) {
+    dma_prepare_tx_memory(tx_data, tx_size);
+    LL_DMA_SetMemoryIncMode(dma->port, dma->stream_index, LL_DMA_MEMORY_INCREMENT);
+  } else {
+    spi_dma_fill = 0xFF;
+    tx_data = &spi_dma_fill;
+    dma_prepare_tx_memory(tx_data, 1);
+    LL_DMA_SetMemoryIncMode(dma->port, dma->stream_index, LL_DMA_MEMORY_NOINCREMENT);
+  }
 
 #ifdef STM32H7
   LL_DMA_SetPeriphAddress(dma->port, dma->stream_index, (uint32_t)&PORT.channel->TXDR);
@@ -239,7 +257,7 @@ void spi_reconfigure(spi_bus_device_t *bus) {
   }
 }
 
-void spi_dma_transfer_begin(spi_ports_t port, uint8_t *buffer, uint32_t length) {
+void spi_dma_transfer_begin(spi_ports_t port, const uint8_t *tx_data, uint8_t *rx_data, uint32_t length) {
   dma_transfer_done[port] = 0;
 
 #if !defined(STM32H7)
@@ -254,8 +272,8 @@ void spi_dma_transfer_begin(spi_ports_t port, uint8_t *buffer, uint32_t length)
   dma_clear_flag_tc(PORT.dma_rx);
   dma_clear_flag_tc(PORT.dma_tx);
 
-  spi_dma_reset_rx(port, buffer, length);
-  spi_dma_reset_tx(port, buffer, length);
+  spi_dma_reset_rx(port, rx_data, length);
+  spi_dma_reset_tx(port, tx_data, length);
 
   LL_DMA_EnableIT_TC(dma_rx->port, dma_rx->stream_index);
   LL_DMA_EnableIT_TE(dma_rx->port, dma_rx->stream_index);
@@ -432,6 +450,11 @@ static void handle_dma_rx_isr(spi_ports_t port) {
   }
 
   spi_bus_device_t *bus = spi_port_config[port].active_device;
+  if (spi_txn_continue_chunk(bus)) {
+    // more segments to go, keep the device selected
+    return;
+  }
+
   spi_csn_disable(bus);
 
   spi_txn_finish(bus);
@@ -21,6 +21,7 @@
 #include <stm32f7xx_hal_flash.h>
 #include <stm32f7xx_ll_adc.h>
 #include <stm32f7xx_ll_bus.h>
+#include <stm32f7xx_ll_crc.h>
 #include <stm32f7xx_ll_dma.h>
 #include <stm32f7xx_ll_exti.h>
 #include <stm32f7xx_ll_gpio.h>
@@ -37,6 +38,7 @@
 #include <stm32h7xx_hal_flash.h>
 #include <stm32h7xx_ll_adc.h>
 #include <stm32h7xx_ll_bus.h>
+#include <stm32h7xx_ll_crc.h>
 #include <stm32h7xx_ll_dma.h>
 #include <stm32h7xx_ll_exti.h>
 #include <stm32h7xx_ll_gpio.h>
@@ -48,35 +50,38 @@
 #include <stm32h7xx_ll_usart.h>
 #endif
 
+// the core clock is only known at runtime, see rcc_set_clock
+#define SYS_CLOCK_FREQ_HZ SystemCoreClock
+
 #ifdef STM32F411
-#define SYS_CLOCK_FREQ_HZ 108000000
-#define PWM_CLOCK_FREQ_HZ 108000000
+#define PWM_CLOCK_FREQ_HZ (SYS_CLOCK_FREQ_HZ)
 #define SPI_CLOCK_FREQ_HZ (SYS_CLOCK_FREQ_HZ / 2)
 
 #define LOOPTIME LOOPTIME_4K
+// sample and filter the gyro at 8k while running the pid at 4k
+#define GYRO_PID_DENOM 2
 #endif
 
 #ifdef STM32F405
-#define SYS_CLOCK_FREQ_HZ 168000000
-#define PWM_CLOCK_FREQ_HZ 84000000
+#define PWM_CLOCK_FREQ_HZ (SYS_CLOCK_FREQ_HZ / 2)
 #define SPI_CLOCK_FREQ_HZ (SYS_CLOCK_FREQ_HZ / 4)
 
 #define LOOPTIME LOOPTIME_8K
 #endif
 
 #ifdef STM32F7
-#define SYS_CLOCK_FREQ_HZ 216000000
-#define PWM_CLOCK_FREQ_HZ 216000000
+#define PWM_CLOCK_FREQ_HZ (SYS_CLOCK_FREQ_HZ)
 #define SPI_CLOCK_FREQ_HZ (SYS_CLOCK_FREQ_HZ / 4)
 
 #define LOOPTIME LOOPTIME_8K
 
 #define WITHIN_DTCM_RAM(p) (((uint32_t)p & 0xffff0000) == 0x20000000)
 #define WITHIN_DMA_RAM(p) (false)
+// dtcm, sram1 and sram2 all sit on the bus matrix
+#define WITHIN_DMA_CAPABLE_RAM(p) (((uint32_t)p & 0xfff80000) == 0x20000000)
 #endif
 
 #ifdef STM32H7
-#define SYS_CLOCK_FREQ_HZ 480000000
 #define PWM_CLOCK_FREQ_HZ (SYS_CLOCK_FREQ_HZ / 2)
 #define SPI_CLOCK_FREQ_HZ (SYS_CLOCK_FREQ_HZ / 4)
 
@@ -84,6 +89,8 @@
 
 #define WITHIN_DTCM_RAM(p) (((uint32_t)p & 0xfffe0000) == 0x20000000)
 #define WITHIN_DMA_RAM(p) (((uint32_t)p & 0xfffe0000) == 0x30000000)
+// dma1/2 reach the axi and d2 srams, but not the dtcm
+#define WITHIN_DMA_CAPABLE_RAM(p) ((((uint32_t)p & 0xfff80000) == 0x24000000) || WITHIN_DMA_RAM(p))
 #endif
 
 #include "adc.h"
@@ -10,6 +10,7 @@
 #endif
 
 volatile uint32_t systick_count = 0;
+uint32_t time_ticks_per_us = 0;
 static volatile uint32_t systick_val = 0;
 static volatile uint32_t systick_pending = 0;
 
@@ -35,6 +36,8 @@ void time_init() {
 #endif
   __HAL_RCC_SYSCFG_CLK_ENABLE();
 
+  time_ticks_per_us = SYS_CLOCK_FREQ_HZ / 1000000;
+
   // interrupt only every 1ms
   SysTick_Config(SYS_CLOCK_FREQ_HZ / 1000);
 
@@ -87,7 +90,7 @@ uint32_t time_micros() {
 }
 
 void time_delay_us(uint32_t us) {
-  volatile uint32_t delay = us * (SYS_CLOCK_FREQ_HZ / 1000000L);
+  volatile uint32_t delay = us * TICKS_PER_US;
   volatile uint32_t start = DWT->CYCCNT;
   while (DWT->CYCCNT - start < delay) {
     __asm("NOP");
@@ -2,7 +2,10 @@
 
 #include <stdint.h>
 
-#define TICKS_PER_US (SYS_CLOCK_FREQ_HZ / 1000000)
+// cached by time_init, the core clock is a runtime value and a divide per call adds up
+extern uint32_t time_ticks_per_us;
+
+#define TICKS_PER_US time_ticks_per_us
 
 #define US_TO_CYCLES(us) ((us) * TICKS_PER_US)
 #define CYCLES_TO_US(cycles) ((cycles) / TICKS_PER_US)
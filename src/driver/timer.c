@@ -5,9 +5,10 @@
 timer_assigment_t timer_assigments[TIMER_ASSIGMENT_MAX] = {};
 
 void timer_alloc_init() {
-  if (target.brushless) {
-    timer_assigments[0].use = TIMER_USE_MOTOR_DSHOT;
-    timer_assigments[0].tag = TIMER_TAG(TIMER1, TIMER_CH1 | TIMER_CH3 | TIMER_CH4);
+  // the dshot driver claims its timers in motor_init, before any other user
+  for (uint32_t i = 0; i < TIMER_ASSIGMENT_MAX; i++) {
+    timer_assigments[i].use = TIMER_USE_FREE;
+    timer_assigments[i].tag = 0;
   }
 }
 
@@ -53,6 +53,7 @@ typedef enum {
   TIMER_USE_MOTOR_PWM,
   TIMER_USE_ELRS,
   TIMER_USE_SOFT_SERIAL,
+  TIMER_USE_RGB_LED,
 } timer_use_t;
 
 typedef struct {
@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 #include "angle_pid.h"
+#include "core/latency.h"
 #include "core/profile.h"
 #include "driver/fmc.h"
 #include "driver/motor.h"
@@ -68,6 +69,8 @@ FAST_RAM control_state_t state = {
     .stick_calibration_wizard = STICK_WIZARD_INACTIVE,
 
     .rx_filter_hz = 0.0f,
+    .rx_frame_hz = 0.0f,
+    .rx_setpoint_delay_us = 0.0f,
 
     .rx_rssi = 0,
     .rx_status = 0,
@@ -276,7 +279,10 @@ void control() {
   }
 
   control_flight_mode();
+  latency_stamp(LATENCY_STAGE_SETPOINT);
+
   pid_calc();
+  latency_stamp(LATENCY_STAGE_PID);
 
   bool failsafe_lock = false;
   if (flags.failsafe) {
@@ -383,8 +389,8 @@ void control() {
   }
 
   if (flags.motortest_override) {
-    motor_test_calc(motortest_usb, state.motor_mix.axis);
-    motor_output_calc(state.motor_mix.axis);
+    motor_test_calc(motortest_usb, state.motor_mix);
+    motor_output_calc(state.motor_mix);
   } else if (!flags.arm_state || flags.failsafe || (state.throttle < 0.001f)) {
     // CONDITION: disarmed OR failsafe OR throttle off
     flags.on_ground = 1;
@@ -408,8 +414,8 @@ void control() {
       }
     }
 
-    motor_mixer_calc(state.motor_mix.axis);
-    motor_output_calc(state.motor_mix.axis);
+    motor_mixer_calc(state.motor_mix);
+    motor_output_calc(state.motor_mix);
   }
 
 #ifdef MOTOR_BEEPS
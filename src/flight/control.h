@@ -43,14 +43,17 @@ extern control_flags_t flags;
 typedef struct {
   failloop_t failloop;
 
-  uint16_t looptime_autodetect;
-  float looptime;        // looptime in seconds
-  float timefactor;      // timefactor for pid calc
-  uint32_t looptime_us;  // looptime in us
-  uint32_t loop_counter; // number of loops ran
-  float uptime;          // running sum of looptimes
-  float armtime;         // running sum of looptimes (while armed)
-  uint32_t cpu_load;     // micros we have had left last loop
+  uint16_t looptime_autodetect;      // pid loop period in us
+  uint16_t gyro_looptime_autodetect; // gyro sample period in us
+  uint8_t pid_denom;                 // gyro samples per pid loop
+  uint16_t gyro_rate_hz;             // gyro samples actually taken per second
+  float looptime;                    // looptime in seconds
+  float timefactor;                  // timefactor for pid calc
+  uint32_t looptime_us;              // looptime in us
+  uint32_t loop_counter;             // number of loops ran
+  float uptime;                      // running sum of looptimes
+  float armtime;                     // running sum of looptimes (while armed)
+  uint32_t cpu_load;                 // micros we have had left last loop
 
   uint32_t failsafe_time_ms; // time the last failsafe occured in ms
 
@@ -68,10 +71,13 @@ typedef struct {
   float ibat;
   float ibat_filtered;
 
-  vec4_t rx;          // holds the raw or calibrated main four channels, roll, pitch, yaw, throttle
-  vec4_t rx_filtered; // same as above, but with constraints (just in case), smoothing and deadband applied
-  vec4_t rx_override; // override values, activated by controls_override
-  float rx_filter_hz;
+  vec4_t rx;                  // holds the raw or calibrated main four channels, roll, pitch, yaw, throttle
+  vec4_t rx_interpolated;     // rx extrapolated between frames from the last two
+  vec4_t rx_filtered;         // same as above, but with constraints (just in case), smoothing and deadband applied
+  vec4_t rx_override;         // override values, activated by controls_override
+  float rx_filter_hz;         // smoothing cutoff derived from the frame rate
+  float rx_frame_hz;          // measured frame rate of the active protocol
+  float rx_setpoint_delay_us; // estimated stick to setpoint delay of the active protocol
 
   stick_wizard_state_t stick_calibration_wizard; // current phase of the calibration wizard
 
@@ -86,10 +92,11 @@ typedef struct {
   vec3_t accel_raw; // raw accel reading with rotation and scaling applied
   vec3_t accel;     // filtered accel readings
 
-  float gyro_temp;         // gyro temparture reading
-  vec3_t gyro_raw;         // raw gyro reading with rotation and scaling applied
-  vec3_t gyro;             // filtered gyro reading
-  vec3_t gyro_delta_angle; // angle covered in  last time interval
+  float gyro_temp;            // gyro temparture reading
+  float gyro_noise[GYRO_MAX]; // per sensor noise estimate in deg/s
+  vec3_t gyro_raw;            // raw gyro reading with rotation and scaling applied
+  vec3_t gyro;                // filtered gyro reading
+  vec3_t gyro_delta_angle;    // angle covered in  last time interval
 
   vec3_t GEstG; // gravity vector
   vec3_t attitude;
@@ -100,58 +107,68 @@ typedef struct {
   vec3_t pid_p_term;
   vec3_t pid_i_term;
   vec3_t pid_d_term;
+  vec3_t pid_ff_term;
   vec3_t pidoutput; // combinded output of the pid controller
 
-  vec4_t motor_mix;
+  float motor_mix[MOTOR_PIN_MAX];
 
   float angleerror[ANGLE_PID_SIZE];
 } control_state_t;
 
-#define STATE_MEMBERS                         \
-  MEMBER(failloop, uint8_t)                   \
-  MEMBER(looptime_autodetect, uint16_t)       \
-  MEMBER(looptime, float)                     \
-  MEMBER(timefactor, float)                   \
-  MEMBER(looptime_us, uint32_t)               \
-  MEMBER(loop_counter, uint32_t)              \
-  MEMBER(uptime, float)                       \
-  MEMBER(armtime, float)                      \
-  MEMBER(cpu_load, uint32_t)                  \
-  MEMBER(failsafe_time_ms, uint32_t)          \
-  MEMBER(lipo_cell_count, uint8_t)            \
-  MEMBER(cpu_temp, float)                     \
-  MEMBER(vbat, float)                         \
-  MEMBER(vbat_filtered, float)                \
-  MEMBER(vbat_filtered_decay, float)          \
-  MEMBER(vbat_cell_avg, float)                \
-  MEMBER(vbat_compensated, float)             \
-  MEMBER(vbat_compensated_cell_avg, float)    \
-  MEMBER(ibat, float)                         \
-  MEMBER(ibat_filtered, float)                \
-  MEMBER(rx, vec4_t)                          \
-  MEMBER(rx_filtered, vec4_t)                 \
-  MEMBER(rx_override, vec4_t)                 \
-  MEMBER(stick_calibration_wizard, uint8_t)   \
-  MEMBER(rx_rssi, float)                      \
-  MEMBER(rx_status, uint32_t)                 \
-  MEMBER(throttle, float)                     \
-  MEMBER(thrsum, float)                       \
-  ARRAY_MEMBER(aux, AUX_CHANNEL_MAX, uint8_t) \
-  MEMBER(accel_raw, vec3_t)                   \
-  MEMBER(accel, vec3_t)                       \
-  MEMBER(gyro_temp, float)                    \
-  MEMBER(gyro_raw, vec3_t)                    \
-  MEMBER(gyro, vec3_t)                        \
-  MEMBER(gyro_delta_angle, vec3_t)            \
-  MEMBER(GEstG, vec3_t)                       \
-  MEMBER(attitude, vec3_t)                    \
-  MEMBER(setpoint, vec3_t)                    \
-  MEMBER(error, vec3_t)                       \
-  MEMBER(pid_p_term, vec3_t)                  \
-  MEMBER(pid_i_term, vec3_t)                  \
-  MEMBER(pid_d_term, vec3_t)                  \
-  MEMBER(pidoutput, vec3_t)                   \
-  MEMBER(motor_mix, vec4_t)                   \
+#define STATE_MEMBERS                             \
+  MEMBER(failloop, uint8_t)                       \
+  MEMBER(looptime_autodetect, uint16_t)           \
+  MEMBER(gyro_looptime_autodetect, uint16_t)      \
+  MEMBER(pid_denom, uint8_t)                      \
+  MEMBER(gyro_rate_hz, uint16_t)                  \
+  MEMBER(looptime, float)                         \
+  MEMBER(timefactor, float)                       \
+  MEMBER(looptime_us, uint32_t)                   \
+  MEMBER(loop_counter, uint32_t)                  \
+  MEMBER(uptime, float)                           \
+  MEMBER(armtime, float)                          \
+  MEMBER(cpu_load, uint32_t)                      \
+  MEMBER(failsafe_time_ms, uint32_t)              \
+  MEMBER(lipo_cell_count, uint8_t)                \
+  MEMBER(cpu_temp, float)                         \
+  MEMBER(vbat, float)                             \
+  MEMBER(vbat_filtered, float)                    \
+  MEMBER(vbat_filtered_decay, float)              \
+  MEMBER(vbat_cell_avg, float)                    \
+  MEMBER(vbat_compensated, float)                 \
+  MEMBER(vbat_compensated_cell_avg, float)        \
+  MEMBER(ibat, float)                             \
+  MEMBER(ibat_filtered, float)                    \
+  MEMBER(rx, vec4_t)                              \
+  MEMBER(rx_interpolated, vec4_t)                 \
+  MEMBER(rx_filtered, vec4_t)                     \
+  MEMBER(rx_override, vec4_t)                     \
+  MEMBER(rx_filter_hz, float)                     \
+  MEMBER(rx_frame_hz, float)                      \
+  MEMBER(rx_setpoint_delay_us, float)             \
+  MEMBER(stick_calibration_wizard, uint8_t)       \
+  MEMBER(rx_rssi, float)                          \
+  MEMBER(rx_status, uint32_t)                     \
+  MEMBER(throttle, float)                         \
+  MEMBER(thrsum, float)                           \
+  ARRAY_MEMBER(aux, AUX_CHANNEL_MAX, uint8_t)     \
+  MEMBER(accel_raw, vec3_t)                       \
+  MEMBER(accel, vec3_t)                           \
+  MEMBER(gyro_temp, float)                        \
+  ARRAY_MEMBER(gyro_noise, GYRO_MAX, float)       \
+  MEMBER(gyro_raw, vec3_t)                        \
+  MEMBER(gyro, vec3_t)                            \
+  MEMBER(gyro_delta_angle, vec3_t)                \
+  MEMBER(GEstG, vec3_t)                           \
+  MEMBER(attitude, vec3_t)                        \
+  MEMBER(setpoint, vec3_t)                        \
+  MEMBER(error, vec3_t)                           \
+  MEMBER(pid_p_term, vec3_t)                      \
+  MEMBER(pid_i_term, vec3_t)                      \
+  MEMBER(pid_d_term, vec3_t)                      \
+  MEMBER(pid_ff_term, vec3_t)                     \
+  MEMBER(pidoutput, vec3_t)                       \
+  ARRAY_MEMBER(motor_mix, MOTOR_PIN_MAX, float)   \
   ARRAY_MEMBER(angleerror, ANGLE_PID_SIZE, float)
 
 typedef struct {
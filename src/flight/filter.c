@@ -1,6 +1,8 @@
 #include "flight/filter.h"
 
 #include <math.h>
+#include <stddef.h>
+#include <string.h>
 
 #include "core/project.h"
 #include "flight/control.h"
@@ -40,6 +42,7 @@ static void filter_init_state(filter_state_t *state, uint8_t count) {
     state[i].delay_element[0] = 0;
     state[i].delay_element[1] = 0;
     state[i].delay_element[2] = 0;
+    state[i].delay_element[3] = 0;
   }
 }
 
@@ -48,20 +51,24 @@ void filter_lp_pt1_init(filter_lp_pt1 *filter, filter_state_t *state, uint8_t co
   filter_init_state(state, count);
 }
 
-void filter_lp_pt1_coeff(filter_lp_pt1 *filter, float hz) {
-  if (filter->hz == hz && filter->sample_period_us == state.looptime_autodetect) {
+static void filter_lp_pt1_coeff_period(filter_lp_pt1 *filter, float hz, uint32_t period_us) {
+  if (filter->hz == hz && filter->sample_period_us == period_us) {
     return;
   }
   filter->hz = hz;
-  filter->sample_period_us = state.looptime_autodetect;
+  filter->sample_period_us = period_us;
 
   const float rc = 1 / (2 * ORDER1_CORRECTION * M_PI_F * hz);
-  const float sample_period = state.looptime_autodetect * 1e-6f;
+  const float sample_period = period_us * 1e-6f;
 
   filter->alpha = sample_period / (rc + sample_period);
 }
 
-float filter_lp_pt1_step(filter_lp_pt1 *filter, filter_state_t *state, float in) {
+void filter_lp_pt1_coeff(filter_lp_pt1 *filter, float hz) {
+  filter_lp_pt1_coeff_period(filter, hz, state.looptime_autodetect);
+}
+
+FAST_CODE float filter_lp_pt1_step(filter_lp_pt1 *filter, filter_state_t *state, float in) {
   state->delay_element[0] = state->delay_element[0] + filter->alpha * (in - state->delay_element[0]);
   return state->delay_element[0];
 }
@@ -71,20 +78,24 @@ void filter_lp_pt2_init(filter_lp_pt2 *filter, filter_state_t *state, uint8_t co
   filter_init_state(state, count);
 }
 
-void filter_lp_pt2_coeff(filter_lp_pt2 *filter, float hz) {
-  if (filter->hz == hz && filter->sample_period_us == state.looptime_autodetect) {
+static void filter_lp_pt2_coeff_period(filter_lp_pt2 *filter, float hz, uint32_t period_us) {
+  if (filter->hz == hz && filter->sample_period_us == period_us) {
     return;
   }
   filter->hz = hz;
-  filter->sample_period_us = state.looptime_autodetect;
+  filter->sample_period_us = period_us;
 
   const float rc = 1 / (2 * ORDER2_CORRECTION * M_PI_F * hz);
-  const float sample_period = state.looptime_autodetect * 1e-6f;
+  const float sample_period = period_us * 1e-6f;
 
   filter->alpha = sample_period / (rc + sample_period);
 }
 
-float filter_lp_pt2_step(filter_lp_pt2 *filter, filter_state_t *state, float in) {
+void filter_lp_pt2_coeff(filter_lp_pt2 *filter, float hz) {
+  filter_lp_pt2_coeff_period(filter, hz, state.looptime_autodetect);
+}
+
+FAST_CODE float filter_lp_pt2_step(filter_lp_pt2 *filter, filter_state_t *state, float in) {
   state->delay_element[1] = state->delay_element[1] + filter->alpha * (in - state->delay_element[1]);
   state->delay_element[0] = state->delay_element[0] + filter->alpha * (state->delay_element[1] - state->delay_element[0]);
   return state->delay_element[0];
@@ -95,26 +106,188 @@ void filter_lp_pt3_init(filter_lp_pt3 *filter, filter_state_t *state, uint8_t co
   filter_init_state(state, count);
 }
 
-void filter_lp_pt3_coeff(filter_lp_pt3 *filter, float hz) {
-  if (filter->hz == hz && filter->sample_period_us == state.looptime_autodetect) {
+static void filter_lp_pt3_coeff_period(filter_lp_pt3 *filter, float hz, uint32_t period_us) {
+  if (filter->hz == hz && filter->sample_period_us == period_us) {
     return;
   }
   filter->hz = hz;
-  filter->sample_period_us = state.looptime_autodetect;
+  filter->sample_period_us = period_us;
 
   const float rc = 1 / (2 * ORDER3_CORRECTION * M_PI_F * hz);
-  const float sample_period = state.looptime_autodetect * 1e-6f;
+  const float sample_period = period_us * 1e-6f;
 
   filter->alpha = sample_period / (rc + sample_period);
 }
 
-float filter_lp_pt3_step(filter_lp_pt3 *filter, filter_state_t *state, float in) {
+void filter_lp_pt3_coeff(filter_lp_pt3 *filter, float hz) {
+  filter_lp_pt3_coeff_period(filter, hz, state.looptime_autodetect);
+}
+
+FAST_CODE float filter_lp_pt3_step(filter_lp_pt3 *filter, filter_state_t *state, float in) {
   state->delay_element[1] = state->delay_element[1] + filter->alpha * (in - state->delay_element[1]);
   state->delay_element[2] = state->delay_element[2] + filter->alpha * (state->delay_element[1] - state->delay_element[2]);
   state->delay_element[0] = state->delay_element[0] + filter->alpha * (state->delay_element[2] - state->delay_element[0]);
   return state->delay_element[0];
 }
 
+void filter_biquad_init(filter_type_t type, filter_biquad *filter, filter_state_t *filter_state, uint8_t count, float hz, float q) {
+  filter_biquad_coeff(type, filter, hz, q, state.looptime_autodetect);
+  filter_init_state(filter_state, count);
+}
+
+// rbj audio eq cookbook designs, normalized to a0 = 1
+static void filter_biquad_sos(filter_type_t type, filter_sos_t *sos, float hz, float q, float sample_period) {
+  const float omega = 2.0f * M_PI_F * hz * sample_period;
+  const float sn = sinf(omega);
+  const float cs = cosf(omega);
+  const float alpha = sn / (2.0f * q);
+  const float a0 = 1.0f / (1.0f + alpha);
+
+  switch (type) {
+  case FILTER_NOTCH:
+    sos->b0 = a0;
+    sos->b1 = -2.0f * cs * a0;
+    sos->b2 = a0;
+    break;
+
+  case FILTER_BANDPASS:
+    sos->b0 = alpha * a0;
+    sos->b1 = 0;
+    sos->b2 = -alpha * a0;
+    break;
+
+  default:
+    sos->b0 = (1.0f - cs) * 0.5f * a0;
+    sos->b1 = (1.0f - cs) * a0;
+    sos->b2 = (1.0f - cs) * 0.5f * a0;
+    break;
+  }
+
+  sos->a1 = -2.0f * cs * a0;
+  sos->a2 = (1.0f - alpha) * a0;
+}
+
+// first order (1 + s/wz) / (1 + s/wp), bilinear transform
+static void filter_lead_lag_sos(filter_sos_t *sos, float hz, float ratio, float sample_period) {
+  const float k = 2.0f / sample_period;
+  const float kz = k / (2.0f * M_PI_F * hz);
+  const float kp = k / (2.0f * M_PI_F * hz * ratio);
+  const float a0 = 1.0f / (1.0f + kp);
+
+  sos->b0 = (1.0f + kz) * a0;
+  sos->b1 = (1.0f - kz) * a0;
+  sos->b2 = 0;
+  sos->a1 = (1.0f - kp) * a0;
+  sos->a2 = 0;
+}
+
+// only recalculated when the cutoff, q or the looptime changes
+void filter_biquad_coeff(filter_type_t type, filter_biquad *filter, float hz, float q, uint32_t period_us) {
+  if (filter->hz == hz && filter->q == q && filter->sample_period_us == period_us) {
+    return;
+  }
+  filter->hz = hz;
+  filter->q = q;
+  filter->sample_period_us = period_us;
+
+  const float sample_period = period_us * 1e-6f;
+  if (q <= 0.0f) {
+    q = FILTER_DEFAULT_Q;
+  }
+
+  // keep the design below nyquist
+  const float max_hz = 0.45f / sample_period;
+  hz = constrain(hz, 1.0f, max_hz);
+
+  switch (type) {
+  case FILTER_LP_BIQUAD4:
+    // butterworth pole pairs of a 4th order low pass
+    filter->sections = 2;
+    filter_biquad_sos(FILTER_LP_BIQUAD, &filter->sos[0], hz, 0.54119610f, sample_period);
+    filter_biquad_sos(FILTER_LP_BIQUAD, &filter->sos[1], hz, 1.30656296f, sample_period);
+    break;
+
+  case FILTER_LEAD_LAG:
+    filter->sections = 1;
+    filter_lead_lag_sos(&filter->sos[0], hz, constrain(q, 0.1f, max_hz / hz), sample_period);
+    break;
+
+  default:
+    filter->sections = 1;
+    filter_biquad_sos(type, &filter->sos[0], hz, q, sample_period);
+    break;
+  }
+}
+
+// transposed direct form 2, the input products do not depend on the
+// output so they can issue while the first multiply-add is in flight
+static inline float filter_sos_step(const filter_sos_t *sos, float *z, float in) {
+  const float out = sos->b0 * in + z[0];
+  z[0] = sos->b1 * in + z[1] - sos->a1 * out;
+  z[1] = sos->b2 * in - sos->a2 * out;
+  return out;
+}
+
+FAST_CODE float filter_biquad_step(filter_biquad *filter, filter_state_t *state, float in) {
+  float out = filter_sos_step(&filter->sos[0], &state->delay_element[0], in);
+  if (filter->sections > 1) {
+    out = filter_sos_step(&filter->sos[1], &state->delay_element[2], out);
+  }
+  return out;
+}
+
+// scalar kalman filter on a random walk model
+// the measurement noise is estimated from a window of sample to sample differences,
+// so a noisier signal (eg. higher throttle or a frame resonance) is filtered harder.
+// differences are used over innovations, the latter would count stick moves as noise
+#define KALMAN_WINDOW_COEFF (1.0f / 32.0f)
+
+void filter_kalman_init(filter_kalman *filter, filter_state_t *filter_state, uint8_t count, float hz, float q) {
+  filter_kalman_coeff(filter, hz, q, state.looptime_autodetect);
+  filter_init_state(filter_state, count);
+}
+
+void filter_kalman_coeff(filter_kalman *filter, float hz, float q, uint32_t period_us) {
+  if (filter->hz == hz && filter->q == q && filter->sample_period_us == period_us) {
+    return;
+  }
+  filter->hz = hz;
+  filter->q = q;
+  filter->sample_period_us = period_us;
+
+  // q is relative like for the other types, the profile default maps onto the default reference noise
+  const float noise = q > 0.0f ? FILTER_KALMAN_DEFAULT_NOISE * q / FILTER_DEFAULT_Q : FILTER_KALMAN_DEFAULT_NOISE;
+
+  // a steady state gain k satisfies k^2 / (1 - k) = process / measurement noise,
+  // pick the process noise so k equals the pt1 alpha at the reference noise
+  const float rc = 1 / (2 * ORDER1_CORRECTION * M_PI_F * hz);
+  const float sample_period = period_us * 1e-6f;
+  const float alpha = constrain(sample_period / (rc + sample_period), 0.0f, 0.99f);
+
+  filter->process_noise = noise * noise * alpha * alpha / (1.0f - alpha);
+  filter->min_noise = filter->process_noise * 0.01f;
+}
+
+// delay_element[0] estimate, [1] error covariance, [2] windowed difference variance, [3] last input
+FAST_CODE float filter_kalman_step(filter_kalman *filter, filter_state_t *state, float in) {
+  const float diff = in - state->delay_element[3];
+  state->delay_element[3] = in;
+  state->delay_element[2] += KALMAN_WINDOW_COEFF * (diff * diff - state->delay_element[2]);
+
+  // the difference of two samples carries the noise twice
+  float r = state->delay_element[2] * 0.5f;
+  if (r < filter->min_noise) {
+    r = filter->min_noise;
+  }
+
+  const float p = state->delay_element[1] + filter->process_noise;
+  const float k = p / (p + r);
+  state->delay_element[0] += k * (in - state->delay_element[0]);
+  state->delay_element[1] = (1.0f - k) * p;
+
+  return state->delay_element[0];
+}
+
 // 16Hz hpf filter for throttle compensation
 // High pass bessel filter order=1 alpha1=0.016
 void filter_hp_be_init(filter_hp_be *filter) {
@@ -156,7 +329,16 @@ void filter_global_init() {
   filter_lp_sp_init(spfilter, 3);
 }
 
-void filter_init(filter_type_t type, filter_t *filter, filter_state_t *state, uint8_t count, float hz) {
+// the cached hz / q / period of the previous type alias other fields of the
+// new one, poison them so the next coeff call always recalculates
+static void filter_set_type(filter_type_t type, filter_t *filter) {
+  memset(&filter->biquad, 0xff, sizeof(filter_t) - offsetof(filter_t, biquad));
+  filter->type = type;
+}
+
+void filter_init(filter_type_t type, filter_t *filter, filter_state_t *state, uint8_t count, float hz, float q) {
+  filter_set_type(type, filter);
+
   switch (type) {
   case FILTER_LP_PT1:
     filter_lp_pt1_init(&filter->lp_pt1, state, count, hz);
@@ -167,22 +349,53 @@ void filter_init(filter_type_t type, filter_t *filter, filter_state_t *state, ui
   case FILTER_LP_PT3:
     filter_lp_pt3_init(&filter->lp_pt3, state, count, hz);
     break;
+  case FILTER_LP_BIQUAD:
+  case FILTER_LP_BIQUAD4:
+  case FILTER_NOTCH:
+  case FILTER_BANDPASS:
+  case FILTER_LEAD_LAG:
+    filter_biquad_init(type, &filter->biquad, state, count, hz, q);
+    break;
+  case FILTER_KALMAN:
+    filter_kalman_init(&filter->kalman, state, count, hz, q);
+    break;
   default:
     // no filter, do nothing
     break;
   }
 }
 
-void filter_coeff(filter_type_t type, filter_t *filter, float hz) {
+void filter_coeff(filter_type_t type, filter_t *filter, filter_state_t *filter_state, uint8_t count, float hz, float q) {
+  filter_coeff_period(type, filter, filter_state, count, hz, q, state.looptime_autodetect);
+}
+
+// for filters that do not run once per pid loop, eg. the gyro filters with a pid denominator.
+// a type change (eg. from the osd) also clears the state, the delay elements mean something else.
+void filter_coeff_period(filter_type_t type, filter_t *filter, filter_state_t *state, uint8_t count, float hz, float q, uint32_t period_us) {
+  if (filter->type != type) {
+    filter_set_type(type, filter);
+    filter_init_state(state, count);
+  }
+
   switch (type) {
   case FILTER_LP_PT1:
-    filter_lp_pt1_coeff(&filter->lp_pt1, hz);
+    filter_lp_pt1_coeff_period(&filter->lp_pt1, hz, period_us);
     break;
   case FILTER_LP_PT2:
-    filter_lp_pt2_coeff(&filter->lp_pt2, hz);
+    filter_lp_pt2_coeff_period(&filter->lp_pt2, hz, period_us);
     break;
   case FILTER_LP_PT3:
-    filter_lp_pt3_coeff(&filter->lp_pt3, hz);
+    filter_lp_pt3_coeff_period(&filter->lp_pt3, hz, period_us);
+    break;
+  case FILTER_LP_BIQUAD:
+  case FILTER_LP_BIQUAD4:
+  case FILTER_NOTCH:
+  case FILTER_BANDPASS:
+  case FILTER_LEAD_LAG:
+    filter_biquad_coeff(type, &filter->biquad, hz, q, period_us);
+    break;
+  case FILTER_KALMAN:
+    filter_kalman_coeff(&filter->kalman, hz, q, period_us);
     break;
   default:
     // no filter, do nothing
@@ -190,7 +403,36 @@ void filter_coeff(filter_type_t type, filter_t *filter, float hz) {
   }
 }
 
-float filter_step(filter_type_t type, filter_t *filter, filter_state_t *state, float in) {
+// low frequency group delay of the low pass types, zero for everything else
+float filter_delay_us(filter_type_t type, float hz, float q) {
+  if (hz <= 0.0f) {
+    return 0.0f;
+  }
+
+  const float omega = 2.0f * M_PI_F * hz;
+  if (q <= 0.0f) {
+    q = FILTER_DEFAULT_Q;
+  }
+
+  switch (type) {
+  case FILTER_LP_PT1:
+  case FILTER_KALMAN:
+    // the kalman matches a pt1 at its reference noise
+    return 1e6f / (ORDER1_CORRECTION * omega);
+  case FILTER_LP_PT2:
+    return 2.0f * 1e6f / (ORDER2_CORRECTION * omega);
+  case FILTER_LP_PT3:
+    return 3.0f * 1e6f / (ORDER3_CORRECTION * omega);
+  case FILTER_LP_BIQUAD:
+    return 1e6f / (q * omega);
+  case FILTER_LP_BIQUAD4:
+    return 1e6f / (0.54119610f * omega) + 1e6f / (1.30656296f * omega);
+  default:
+    return 0.0f;
+  }
+}
+
+FAST_CODE float filter_step(filter_type_t type, filter_t *filter, filter_state_t *state, float in) {
   switch (type) {
   case FILTER_LP_PT1:
     return filter_lp_pt1_step(&filter->lp_pt1, state, in);
@@ -198,6 +440,14 @@ float filter_step(filter_type_t type, filter_t *filter, filter_state_t *state, f
     return filter_lp_pt2_step(&filter->lp_pt2, state, in);
   case FILTER_LP_PT3:
     return filter_lp_pt3_step(&filter->lp_pt3, state, in);
+  case FILTER_LP_BIQUAD:
+  case FILTER_LP_BIQUAD4:
+  case FILTER_NOTCH:
+  case FILTER_BANDPASS:
+  case FILTER_LEAD_LAG:
+    return filter_biquad_step(&filter->biquad, state, in);
+  case FILTER_KALMAN:
+    return filter_kalman_step(&filter->kalman, state, in);
   default:
     // no filter at all
     return in;
@@ -9,10 +9,21 @@ typedef enum {
   FILTER_LP_PT1,
   FILTER_LP_PT2,
   FILTER_LP_PT3,
+  FILTER_LP_BIQUAD,  // second order low pass, q sets the damping
+  FILTER_LP_BIQUAD4, // fourth order butterworth low pass, two cascaded sections
+  FILTER_NOTCH,      // static notch at the cutoff, q sets the width
+  FILTER_BANDPASS,   // band pass around the cutoff with unity peak gain
+  FILTER_LEAD_LAG,   // zero at the cutoff, pole at cutoff * q (q > 1 lead, q < 1 lag)
+  FILTER_KALMAN,     // adaptive, matches a pt1 at the cutoff when the noise std deviation equals the reference noise
 } __attribute__((__packed__)) filter_type_t;
 
+// used when a biquad is configured without a q
+#define FILTER_DEFAULT_Q 0.70710678f
+// kalman reference noise at q = FILTER_DEFAULT_Q or without a q, ~3deg/s for the gyro
+#define FILTER_KALMAN_DEFAULT_NOISE 0.05f
+
 typedef struct {
-  float delay_element[3];
+  float delay_element[4];
 } filter_state_t;
 
 typedef struct {
@@ -36,10 +47,40 @@ typedef struct {
   float alpha;
 } filter_lp_pt3;
 
-typedef union {
-  filter_lp_pt1 lp_pt1;
-  filter_lp_pt2 lp_pt2;
-  filter_lp_pt3 lp_pt3;
+typedef struct {
+  float b0, b1, b2;
+  float a1, a2;
+} filter_sos_t;
+
+typedef struct {
+  float hz;
+  float q;
+  uint32_t sample_period_us;
+
+  uint8_t sections;
+  filter_sos_t sos[2];
+} filter_biquad;
+
+typedef struct {
+  float hz;
+  float q;
+  uint32_t sample_period_us;
+
+  float process_noise;
+  float min_noise;
+} filter_kalman;
+
+typedef struct {
+  // type the coefficients and state were set up for, the members below share memory
+  filter_type_t type;
+
+  union {
+    filter_lp_pt1 lp_pt1;
+    filter_lp_pt2 lp_pt2;
+    filter_lp_pt3 lp_pt3;
+    filter_biquad biquad;
+    filter_kalman kalman;
+  };
 } filter_t;
 
 typedef struct {
@@ -69,14 +110,24 @@ void filter_lp_pt3_init(filter_lp_pt3 *filter, filter_state_t *state, uint8_t co
 void filter_lp_pt3_coeff(filter_lp_pt3 *filter, float hz);
 float filter_lp_pt3_step(filter_lp_pt3 *filter, filter_state_t *state, float in);
 
+void filter_biquad_init(filter_type_t type, filter_biquad *filter, filter_state_t *state, uint8_t count, float hz, float q);
+void filter_biquad_coeff(filter_type_t type, filter_biquad *filter, float hz, float q, uint32_t period_us);
+float filter_biquad_step(filter_biquad *filter, filter_state_t *state, float in);
+
+void filter_kalman_init(filter_kalman *filter, filter_state_t *state, uint8_t count, float hz, float q);
+void filter_kalman_coeff(filter_kalman *filter, float hz, float q, uint32_t period_us);
+float filter_kalman_step(filter_kalman *filter, filter_state_t *state, float in);
+
 void filter_lp_sp_init(filter_lp_sp *filter, uint8_t count);
 float filter_lp_sp_step(filter_lp_sp *filter, float x);
 
 void filter_hp_be_init(filter_hp_be *filter);
 float filter_hp_be_step(filter_hp_be *filter, float x);
 
-void filter_init(filter_type_t type, filter_t *filter, filter_state_t *state, uint8_t count, float hz);
-void filter_coeff(filter_type_t type, filter_t *filter, float hz);
+void filter_init(filter_type_t type, filter_t *filter, filter_state_t *state, uint8_t count, float hz, float q);
+void filter_coeff(filter_type_t type, filter_t *filter, filter_state_t *state, uint8_t count, float hz, float q);
+void filter_coeff_period(filter_type_t type, filter_t *filter, filter_state_t *state, uint8_t count, float hz, float q, uint32_t period_us);
+float filter_delay_us(filter_type_t type, float hz, float q);
 float filter_step(filter_type_t type, filter_t *filter, filter_state_t *state, float in);
 
 float throttlehpf(float in);
\ No newline at end of file
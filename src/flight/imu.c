@@ -15,8 +15,16 @@
 #include "util/vector.h"
 
 // IMU fusion algo, CHOOSE ONE
+#if !defined(SILVERWARE_IMU) && !defined(QUICKSILVER_IMU) && !defined(QUATERNION_IMU)
 // #define SILVERWARE_IMU
-#define QUICKSILVER_IMU
+// #define QUICKSILVER_IMU
+#define QUATERNION_IMU
+#endif
+
+// update rate of the quaternion estimator, gyro deltas are integrated in between
+#ifndef IMU_RATE_HZ
+#define IMU_RATE_HZ 1000
+#endif
 
 // filter times in seconds
 // time to correct gyro readings using the accelerometer
@@ -37,21 +45,79 @@ static filter_state_t filter_pass1[3];
 static filter_state_t filter_pass2[3];
 #endif
 
+#ifdef QUATERNION_IMU
+// mahony gains, the proportional gain matches the time constants of the other estimators
+#define IMU_KP_GROUND (1.0f / (float)FASTFILTER)
+#define IMU_KP_AIR (1.0f / (float)FILTERTIME)
+#define IMU_KI 0.01f
+#define IMU_KI_LIMIT (5.0f * DEGTORAD)
+
+typedef struct {
+  float w;
+  float x;
+  float y;
+  float z;
+} quat_t;
+
+// rotation from body to earth frame
+static quat_t q = {1.0f, 0.0f, 0.0f, 0.0f};
+static vec3_t error_integral;
+
+// gyro and accel accumulated since the last update
+static vec3_t delta_angle_sum;
+static vec3_t accel_sum;
+static uint32_t sample_count = 0;
+static float sample_time = 0.0f;
+
+static void imu_quat_from_gravity(const vec3_t *g) {
+  const float roll = atan2f(g->axis[1], g->axis[2]);
+  const float pitch = atan2f(-g->axis[0], sqrtf(g->axis[1] * g->axis[1] + g->axis[2] * g->axis[2]));
+
+  const float cr = cosf(roll * 0.5f);
+  const float sr = sinf(roll * 0.5f);
+  const float cp = cosf(pitch * 0.5f);
+  const float sp = sinf(pitch * 0.5f);
+
+  q.w = cr * cp;
+  q.x = sr * cp;
+  q.y = cr * sp;
+  q.z = -sr * sp;
+}
+#endif
+
 void imu_init() {
-  // init the gravity vector with accel values
-  for (int xx = 0; xx < 100; xx++) {
+  // init the gravity vector with accel values, seeded from the first sample
+  sixaxis_read();
+  for (int x = 0; x < 3; x++) {
+    state.GEstG.axis[x] = state.accel_raw.axis[x];
+  }
+
+  for (int xx = 0; xx < 20; xx++) {
+    time_delay_us(1000);
     sixaxis_read();
 
     for (int x = 0; x < 3; x++) {
       lpf(&state.GEstG.axis[x], state.accel_raw.axis[x], 0.85);
     }
-    time_delay_us(1000);
   }
 
 #ifdef QUICKSILVER_IMU
   filter_lp_pt1_init(&filter, filter_pass1, 3, PT1_FILTER_HZ);
   filter_lp_pt1_init(&filter, filter_pass2, 3, PT1_FILTER_HZ);
 #endif
+
+#ifdef QUATERNION_IMU
+  imu_quat_from_gravity(&state.GEstG);
+
+  for (int x = 0; x < 3; x++) {
+    state.accel.axis[x] = state.GEstG.axis[x];
+    error_integral.axis[x] = 0;
+    delta_angle_sum.axis[x] = 0;
+    accel_sum.axis[x] = 0;
+  }
+  sample_count = 0;
+  sample_time = 0.0f;
+#endif
 }
 
 #ifdef SILVERWARE_IMU
@@ -173,4 +239,109 @@ void imu_calc() {
     state.attitude.pitch = atan2approx(state.GEstG.pitch, state.GEstG.yaw);
   }
 }
-#endif
\ No newline at end of file
+#endif
+
+#ifdef QUATERNION_IMU
+static void imu_update(const vec3_t *delta, vec3_t *accel, float dt) {
+  // gyro roll, pitch and yaw rotate the gravity vector around its y, x and z axis
+  vec3_t rot = {
+      .axis = {
+          delta->pitch + error_integral.axis[0] * dt,
+          -delta->roll + error_integral.axis[1] * dt,
+          -delta->yaw + error_integral.axis[2] * dt,
+      },
+  };
+
+  const float accmag = vec3_magnitude(accel);
+  if ((accmag > ACC_MIN * ACC_1G) && (accmag < ACC_MAX * ACC_1G)) {
+    const float inv_accmag = 1.0f / accmag;
+    const float ax = accel->axis[0] * inv_accmag;
+    const float ay = accel->axis[1] * inv_accmag;
+    const float az = accel->axis[2] * inv_accmag;
+
+    // estimated gravity direction, third row of the rotation matrix
+    const float vx = 2.0f * (q.x * q.z - q.w * q.y);
+    const float vy = 2.0f * (q.y * q.z + q.w * q.x);
+    const float vz = q.w * q.w - q.x * q.x - q.y * q.y + q.z * q.z;
+
+    // error is the cross product between measured and estimated gravity
+    const float ex = ay * vz - az * vy;
+    const float ey = az * vx - ax * vz;
+    const float ez = ax * vy - ay * vx;
+
+    // happyhour bartender - quad is ON GROUND and disarmed
+    // lateshift bartender - quad is IN AIR and things are getting wild
+    const float kp = flags.on_ground ? IMU_KP_GROUND : IMU_KP_AIR;
+
+    error_integral.axis[0] = constrain(error_integral.axis[0] + IMU_KI * ex * dt, -IMU_KI_LIMIT, IMU_KI_LIMIT);
+    error_integral.axis[1] = constrain(error_integral.axis[1] + IMU_KI * ey * dt, -IMU_KI_LIMIT, IMU_KI_LIMIT);
+    error_integral.axis[2] = constrain(error_integral.axis[2] + IMU_KI * ez * dt, -IMU_KI_LIMIT, IMU_KI_LIMIT);
+
+    rot.axis[0] += kp * ex * dt;
+    rot.axis[1] += kp * ey * dt;
+    rot.axis[2] += kp * ez * dt;
+  }
+
+  // integrate q' = 0.5 * q * (0, rot)
+  const float hx = 0.5f * rot.axis[0];
+  const float hy = 0.5f * rot.axis[1];
+  const float hz = 0.5f * rot.axis[2];
+
+  const quat_t last = q;
+  q.w += -last.x * hx - last.y * hy - last.z * hz;
+  q.x += last.w * hx + last.y * hz - last.z * hy;
+  q.y += last.w * hy - last.x * hz + last.z * hx;
+  q.z += last.w * hz + last.x * hy - last.y * hx;
+
+  const float inv_norm = Q_rsqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+  q.w *= inv_norm;
+  q.x *= inv_norm;
+  q.y *= inv_norm;
+  q.z *= inv_norm;
+}
+
+void imu_calc() {
+  delta_angle_sum.roll += state.gyro_delta_angle.roll;
+  delta_angle_sum.pitch += state.gyro_delta_angle.pitch;
+  delta_angle_sum.yaw += state.gyro_delta_angle.yaw;
+
+  accel_sum.roll += state.accel_raw.roll;
+  accel_sum.pitch += state.accel_raw.pitch;
+  accel_sum.yaw += state.accel_raw.yaw;
+
+  sample_count++;
+  sample_time += state.looptime;
+
+  if (sample_time < (1.0f / (float)IMU_RATE_HZ)) {
+    return;
+  }
+
+  const float dt = sample_time;
+  const float inv_count = 1.0f / (float)sample_count;
+
+  // average over the update interval, then lowpass at the estimator rate
+  const float filtcoeff = lpfcalc_hz(dt, PT1_FILTER_HZ);
+  for (int x = 0; x < 3; x++) {
+    lpf(&state.accel.axis[x], accel_sum.axis[x] * inv_count, filtcoeff);
+  }
+
+  imu_update(&delta_angle_sum, &state.accel, dt);
+
+  for (int x = 0; x < 3; x++) {
+    delta_angle_sum.axis[x] = 0;
+    accel_sum.axis[x] = 0;
+  }
+  sample_count = 0;
+  sample_time = 0.0f;
+
+  state.GEstG.roll = 2.0f * (q.x * q.z - q.w * q.y) * ACC_1G;
+  state.GEstG.pitch = 2.0f * (q.y * q.z + q.w * q.x) * ACC_1G;
+  state.GEstG.yaw = (q.w * q.w - q.x * q.x - q.y * q.y + q.z * q.z) * ACC_1G;
+
+  state.attitude.roll = atan2approx(state.GEstG.roll, state.GEstG.yaw);
+  state.attitude.pitch = atan2approx(state.GEstG.pitch, state.GEstG.yaw);
+
+  // heading follows the sign of the yaw gyro
+  state.attitude.yaw = -atan2approx(2.0f * (q.w * q.z + q.x * q.y), 1.0f - 2.0f * (q.y * q.y + q.z * q.z));
+}
+#endif
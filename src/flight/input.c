@@ -42,71 +42,90 @@ vec3_t input_stick_vector(float rx_input[]) {
   };
 }
 
-static vec3_t input_get_expo() {
-  vec3_t angle_expo = {
-      .roll = 0,
-      .pitch = 0,
-      .yaw = 0,
-  };
-  vec3_t acro_expo = {
-      .roll = 0,
-      .pitch = 0,
-      .yaw = 0,
-  };
-
-  switch (profile_current_rates()->mode) {
+// rate curves are odd, so the tables only cover the positive half of the stick
+#define INPUT_LUT_SIZE 64
+
+typedef enum {
+  INPUT_EXPO_ACRO,
+  INPUT_EXPO_ANGLE,
+  INPUT_EXPO_MAX,
+} input_expo_t;
+
+typedef struct {
+  rate_t rates;
+  float table[INPUT_EXPO_MAX][3][INPUT_LUT_SIZE + 1];
+} input_rates_lut_t;
+
+typedef struct {
+  float expo;
+  float mid;
+  float table[INPUT_LUT_SIZE + 1];
+} input_throttle_lut_t;
+
+static input_rates_lut_t rates_lut;
+static bool rates_lut_valid = false;
+
+static input_throttle_lut_t throttle_lut;
+static bool throttle_lut_valid = false;
+
+static void input_get_expo(const rate_t *rates, vec3_t *acro_expo, vec3_t *angle_expo) {
+  switch (rates->mode) {
   case RATE_MODE_SILVERWARE:
-    acro_expo = profile_current_rates()->rate[SILVERWARE_ACRO_EXPO];
-    angle_expo = profile_current_rates()->rate[SILVERWARE_ANGLE_EXPO];
+    *acro_expo = rates->rate[SILVERWARE_ACRO_EXPO];
+    *angle_expo = rates->rate[SILVERWARE_ANGLE_EXPO];
     break;
   case RATE_MODE_BETAFLIGHT:
-    acro_expo = profile_current_rates()->rate[BETAFLIGHT_EXPO];
-    angle_expo = profile_current_rates()->rate[BETAFLIGHT_EXPO];
+    *acro_expo = rates->rate[BETAFLIGHT_EXPO];
+    *angle_expo = rates->rate[BETAFLIGHT_EXPO];
     break;
   case RATE_MODE_ACTUAL:
-    acro_expo = profile_current_rates()->rate[ACTUAL_EXPO];
-    angle_expo = profile_current_rates()->rate[ACTUAL_EXPO];
+    *acro_expo = rates->rate[ACTUAL_EXPO];
+    *angle_expo = rates->rate[ACTUAL_EXPO];
+    break;
+  default:
+    *acro_expo = (vec3_t){.roll = 0, .pitch = 0, .yaw = 0};
+    *angle_expo = (vec3_t){.roll = 0, .pitch = 0, .yaw = 0};
     break;
   }
+}
 
-  vec3_t expo;
+static void input_get_expo_tables(input_expo_t expo[3]) {
   if (rx_aux_on(AUX_LEVELMODE)) {
     if (rx_aux_on(AUX_RACEMODE) && !rx_aux_on(AUX_HORIZON)) {
-      expo.roll = angle_expo.roll;
-      expo.pitch = acro_expo.pitch;
-      expo.yaw = angle_expo.yaw;
+      expo[0] = INPUT_EXPO_ANGLE;
+      expo[1] = INPUT_EXPO_ACRO;
+      expo[2] = INPUT_EXPO_ANGLE;
     } else if (rx_aux_on(AUX_HORIZON)) {
-      expo.roll = acro_expo.roll;
-      expo.pitch = acro_expo.pitch;
-      expo.yaw = angle_expo.yaw;
+      expo[0] = INPUT_EXPO_ACRO;
+      expo[1] = INPUT_EXPO_ACRO;
+      expo[2] = INPUT_EXPO_ANGLE;
     } else {
-      expo.roll = angle_expo.roll;
-      expo.pitch = angle_expo.pitch;
-      expo.yaw = angle_expo.yaw;
+      expo[0] = INPUT_EXPO_ANGLE;
+      expo[1] = INPUT_EXPO_ANGLE;
+      expo[2] = INPUT_EXPO_ANGLE;
     }
   } else {
-    expo.roll = acro_expo.roll;
-    expo.pitch = acro_expo.pitch;
-    expo.yaw = acro_expo.yaw;
+    expo[0] = INPUT_EXPO_ACRO;
+    expo[1] = INPUT_EXPO_ACRO;
+    expo[2] = INPUT_EXPO_ACRO;
   }
-  return expo;
 }
 
-static float calc_bf_rates(const uint32_t axis, float rc, float expo) {
+static float calc_bf_rates(const rate_t *rates, const uint32_t axis, float rc, float expo) {
   const float rc_abs = fabs(rc);
 
   if (expo) {
     rc = rc * pow3(rc_abs) * expo + rc * (1 - expo);
   }
 
-  float rc_rate = profile_current_rates()->rate[BETAFLIGHT_RC_RATE].axis[axis];
+  float rc_rate = rates->rate[BETAFLIGHT_RC_RATE].axis[axis];
   if (rc_rate > 2.0f) {
     rc_rate += BF_RC_RATE_INCREMENTAL * (rc_rate - 2.0f);
   }
 
   float angle_rate = 200.0f * rc_rate * rc;
 
-  const float super_rate = profile_current_rates()->rate[BETAFLIGHT_SUPER_RATE].axis[axis];
+  const float super_rate = rates->rate[BETAFLIGHT_SUPER_RATE].axis[axis];
   if (super_rate) {
     const float super_factor = 1.0f / (constrain(1.0f - (rc_abs * super_rate), 0.01f, 1.00f));
     angle_rate *= super_factor;
@@ -115,52 +134,115 @@ static float calc_bf_rates(const uint32_t axis, float rc, float expo) {
   return angle_rate * DEGTORAD;
 }
 
-static float calc_sw_rates(const uint32_t axis, float rc, float expo) {
-  const float max_rate = profile_current_rates()->rate[SILVERWARE_MAX_RATE].axis[axis];
+static float calc_sw_rates(const rate_t *rates, const uint32_t axis, float rc, float expo) {
+  const float max_rate = rates->rate[SILVERWARE_MAX_RATE].axis[axis];
   const float rate_expo = pow3(rc) * expo + rc * (1 - expo);
 
   return rate_expo * max_rate * DEGTORAD;
 }
 
-static float calc_actual_rates(const uint32_t axis, float rc, float expo) {
+static float calc_actual_rates(const rate_t *rates, const uint32_t axis, float rc, float expo) {
   const float rc_abs = fabs(rc);
   const float rate_expo = rc_abs * (pow5(rc) * expo + rc * (1 - expo));
 
-  const float center_sensitivity = profile_current_rates()->rate[ACTUAL_CENTER_SENSITIVITY].axis[axis];
-  const float max_rate = profile_current_rates()->rate[ACTUAL_MAX_RATE].axis[axis];
+  const float center_sensitivity = rates->rate[ACTUAL_CENTER_SENSITIVITY].axis[axis];
+  const float max_rate = rates->rate[ACTUAL_MAX_RATE].axis[axis];
   const float stick_movement = max(0, max_rate - center_sensitivity);
 
   return (rc * center_sensitivity + stick_movement * rate_expo) * DEGTORAD;
 }
 
-vec3_t input_rates_calc() {
-  vec3_t rates;
-  vec3_t expo = input_get_expo();
-
-  switch (profile_current_rates()->mode) {
+static float calc_rates(const rate_t *rates, const uint32_t axis, float rc, float expo) {
+  switch (rates->mode) {
   case RATE_MODE_SILVERWARE:
-    rates.roll = calc_sw_rates(0, state.rx_filtered.roll, expo.roll);
-    rates.pitch = calc_sw_rates(1, state.rx_filtered.pitch, expo.pitch);
-    rates.yaw = calc_sw_rates(2, state.rx_filtered.yaw, expo.yaw);
-    break;
+    return calc_sw_rates(rates, axis, rc, expo);
   case RATE_MODE_BETAFLIGHT:
-    rates.roll = calc_bf_rates(0, state.rx_filtered.roll, expo.roll);
-    rates.pitch = calc_bf_rates(1, state.rx_filtered.pitch, expo.pitch);
-    rates.yaw = calc_bf_rates(2, state.rx_filtered.yaw, expo.yaw);
-    break;
+    return calc_bf_rates(rates, axis, rc, expo);
   case RATE_MODE_ACTUAL:
-    rates.roll = calc_actual_rates(0, state.rx_filtered.roll, expo.roll);
-    rates.pitch = calc_actual_rates(1, state.rx_filtered.pitch, expo.pitch);
-    rates.yaw = calc_actual_rates(2, state.rx_filtered.yaw, expo.yaw);
-    break;
+    return calc_actual_rates(rates, axis, rc, expo);
+  default:
+    return 0;
+  }
+}
+
+static float input_lut_lookup(const float *table, float x) {
+  const float pos = constrain(x, 0.0f, 1.0f) * INPUT_LUT_SIZE;
+
+  uint32_t index = pos;
+  if (index >= INPUT_LUT_SIZE) {
+    index = INPUT_LUT_SIZE - 1;
+  }
+
+  const float frac = pos - index;
+  return table[index] + (table[index + 1] - table[index]) * frac;
+}
+
+static void input_rates_lut_update() {
+  const rate_t *rates = profile_current_rates();
+  if (rates_lut_valid && memcmp(&rates_lut.rates, rates, sizeof(rate_t)) == 0) {
+    return;
+  }
+
+  vec3_t expo[INPUT_EXPO_MAX];
+  input_get_expo(rates, &expo[INPUT_EXPO_ACRO], &expo[INPUT_EXPO_ANGLE]);
+
+  for (uint32_t e = 0; e < INPUT_EXPO_MAX; e++) {
+    for (uint32_t axis = 0; axis < 3; axis++) {
+      for (uint32_t i = 0; i <= INPUT_LUT_SIZE; i++) {
+        const float rc = (float)i / (float)INPUT_LUT_SIZE;
+        rates_lut.table[e][axis][i] = calc_rates(rates, axis, rc, expo[e].axis[axis]);
+      }
+    }
+  }
+
+  memcpy(&rates_lut.rates, rates, sizeof(rate_t));
+  rates_lut_valid = true;
+}
+
+vec3_t input_rates_calc() {
+  input_rates_lut_update();
+
+  input_expo_t expo[3];
+  input_get_expo_tables(expo);
+
+  vec3_t rates;
+  for (uint32_t axis = 0; axis < 3; axis++) {
+    const float rc = state.rx_filtered.axis[axis];
+    const float *table = rates_lut.table[expo[axis]][axis];
+    rates.axis[axis] = rc < 0.0f ? -input_lut_lookup(table, -rc) : input_lut_lookup(table, rc);
   }
 
   return rates;
 }
 
-float input_throttle_calc(float throttle) {
+// unclamped, the table stores the smooth curve and the clamp is applied after the lookup
+// so its kink does not fall between two table points
+static float calc_throttle_curve(float throttle, float expo, float mid) {
   const float n = (throttle * 2.f - 1.f);
+  return (n * n * n * expo + n * (1.f - expo) + 1.f) * mid;
+}
+
+static float calc_throttle(float throttle, float expo, float mid) {
+  return constrain(calc_throttle_curve(throttle, expo, mid), 0.0f, 1.0f);
+}
+
+static void input_throttle_lut_update() {
   const float expo = profile.rate.throttle_expo;
   const float mid = profile.rate.throttle_mid;
-  return constrain((n * n * n * expo + n * (1.f - expo) + 1.f) * mid, 0.0f, 1.0f);
-}
\ No newline at end of file
+  if (throttle_lut_valid && throttle_lut.expo == expo && throttle_lut.mid == mid) {
+    return;
+  }
+
+  for (uint32_t i = 0; i <= INPUT_LUT_SIZE; i++) {
+    throttle_lut.table[i] = calc_throttle_curve((float)i / (float)INPUT_LUT_SIZE, expo, mid);
+  }
+
+  throttle_lut.expo = expo;
+  throttle_lut.mid = mid;
+  throttle_lut_valid = true;
+}
+
+float input_throttle_calc(float throttle) {
+  input_throttle_lut_update();
+  return constrain(input_lut_lookup(throttle_lut.table, throttle), 0.0f, 1.0f);
+}
@@ -1,6 +1,7 @@
 #include "motor.h"
 
 #include <float.h>
+#include <math.h>
 
 #include "core/profile.h"
 #include "core/project.h"
@@ -31,10 +32,59 @@
 #define MIX_THROTTLE_INCREASE_MAX 0.2f
 #endif
 
+#define MOTOR_LUT_SIZE 64
+
+// cell voltage the sag compensation is relative to
+#define SAG_REFERENCE_CELL_VOLTAGE 4.2f
+#define SAG_COMPENSATION_MAX 1.5f
+
+typedef struct {
+  float linearization;
+  float table[MOTOR_LUT_SIZE + 1];
+} motor_thrust_lut_t;
+
+static motor_thrust_lut_t thrust_lut;
+static bool thrust_lut_valid = false;
+
+// calculated once per loop by the mixer, so desaturation and output agree
+static float sag_compensation = 1.0f;
+
 extern profile_t profile;
 
+static uint32_t motor_count() {
+  return constrain(profile.motor.motor_count, 1, MOTOR_PIN_MAX);
+}
+
+// motor rpm scales with voltage, so a sagging pack needs a larger command for the same thrust
+static float motor_sag_compensation() {
+  if (profile.motor.vbat_sag_compensation <= 0.0f || state.lipo_cell_count == 0) {
+    return 1.0f;
+  }
+
+  const float cell_voltage = state.vbat_filtered / (float)state.lipo_cell_count;
+  if (cell_voltage < 1.0f) {
+    // no battery reading
+    return 1.0f;
+  }
+
+  const float ratio = constrain(SAG_REFERENCE_CELL_VOLTAGE / cell_voltage, 1.0f, SAG_COMPENSATION_MAX);
+  return 1.0f + (ratio - 1.0f) * profile.motor.vbat_sag_compensation * 0.01f;
+}
+
+// highest mix value that still reaches the motors unclipped once linearized and sag compensated,
+// the forward thrust model evaluated at the largest usable command
+static float motor_mix_limit(float compensation) {
+  if (compensation <= 1.0f) {
+    return 1.0f;
+  }
+
+  const float cmd = 1.0f / compensation;
+  const float k = constrain(profile.motor.thrust_linearization * 0.01f, 0.0f, 1.0f);
+  return (1.0f - k) * cmd + k * cmd * cmd;
+}
+
 static float motord(float in, int x) {
-  static float lastratexx[4][4];
+  static float lastratexx[MOTOR_PIN_MAX][4];
 
   const float factor = profile.motor.torque_boost;
   const float out = (+0.125f * in + 0.250f * lastratexx[x][0] - 0.250f * lastratexx[x][2] - (0.125f) * lastratexx[x][3]) * factor;
@@ -46,44 +96,63 @@ static float motord(float in, int x) {
   return in + out;
 }
 
-static void motor_brushless_mixer_scale_calc(float throttle, float mix[MOTOR_PIN_MAX]) {
+static void motor_brushless_mixer_scale_calc(float throttle, float limit, float mix[MOTOR_PIN_MAX]) {
   // only enable once really in the air
   if (flags.on_ground || !flags.in_air) {
     return;
   }
 
-  float min = FLT_MAX;
-  float max = FLT_MIN;
+  const uint32_t count = motor_count();
 
-  for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
-    if (mix[i] < min) {
-      min = mix[i];
+  // each motor sees the throttle times its weight, so the bounds are taken per unit of throttle.
+  // motors without a throttle weight cannot be helped by moving the throttle and are left to the output clamp
+  float min = FLT_MAX;
+  for (uint32_t i = 0; i < count; i++) {
+    const float weight = profile.motor.mixer[i].throttle;
+    if (weight > 0.0f && mix[i] / weight < min) {
+      min = mix[i] / weight;
     }
-    if (mix[i] > max) {
-      max = mix[i];
+  }
+  if (min == FLT_MAX) {
+    return;
+  }
+
+  // desaturate into the headroom left after sag compensation,
+  // the motor furthest above the one pinned at zero decides the scale
+  float range = 0.0f;
+  for (uint32_t i = 0; i < count; i++) {
+    const float weight = profile.motor.mixer[i].throttle;
+    if (weight > 0.0f && mix[i] - min * weight > range) {
+      range = mix[i] - min * weight;
     }
   }
+  const float scale = range > limit ? limit / range : 1.0f;
 
-  const float range = max - min;
-  const float scale = range > 1.0f ? 1.0f / range : 1.0f;
+  float throttle_max = FLT_MAX;
+  for (uint32_t i = 0; i < count; i++) {
+    const float weight = profile.motor.mixer[i].throttle;
+    if (weight > 0.0f && (limit - mix[i] * scale) / weight < throttle_max) {
+      throttle_max = (limit - mix[i] * scale) / weight;
+    }
+  }
 
-  const float scaled_min = min * scale;
-  const float scaled_max = max * scale;
-  const float scaled_throttle = constrain(throttle, -scaled_min, 1.0f - scaled_max);
+  const float scaled_throttle = constrain(throttle, -min * scale, throttle_max);
 
-  for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
-    mix[i] = mix[i] * scale + scaled_throttle;
+  for (uint32_t i = 0; i < count; i++) {
+    mix[i] = mix[i] * scale + scaled_throttle * profile.motor.mixer[i].throttle;
   }
 }
 
-static void motor_brushed_mixer_scale_calc(float throttle, float mix[MOTOR_PIN_MAX]) {
+static void motor_brushed_mixer_scale_calc(float throttle, float limit, float mix[MOTOR_PIN_MAX]) {
   // throttle reduction
   float overthrottle = 0;
   float underthrottle = 0.001f;
   static float overthrottlefilt = 0;
 
-  for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
-    mix[i] += throttle;
+  const uint32_t count = motor_count();
+
+  for (uint32_t i = 0; i < count; i++) {
+    mix[i] += throttle * profile.motor.mixer[i].throttle;
 
     if (mix[i] > overthrottle)
       overthrottle = mix[i];
@@ -91,7 +160,7 @@ static void motor_brushed_mixer_scale_calc(float throttle, float mix[MOTOR_PIN_M
       underthrottle = mix[i];
   }
 
-  overthrottle -= MIX_MOTOR_MAX;
+  overthrottle -= MIX_MOTOR_MAX * limit;
 
   if (overthrottle > (float)MIX_THROTTLE_REDUCTION_MAX)
     overthrottle = (float)MIX_THROTTLE_REDUCTION_MAX;
@@ -116,7 +185,7 @@ static void motor_brushed_mixer_scale_calc(float throttle, float mix[MOTOR_PIN_M
 
   if (overthrottle > 0) { // exceeding max motor thrust
     float temp = overthrottle;
-    for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
+    for (uint32_t i = 0; i < count; i++) {
       mix[i] -= temp;
     }
   }
@@ -125,7 +194,7 @@ static void motor_brushed_mixer_scale_calc(float throttle, float mix[MOTOR_PIN_M
   if (flags.in_air == 1) {
     float underthrottle = 0;
 
-    for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
+    for (uint32_t i = 0; i < count; i++) {
       if (mix[i] < underthrottle)
         underthrottle = mix[i];
     }
@@ -135,84 +204,111 @@ static void motor_brushed_mixer_scale_calc(float throttle, float mix[MOTOR_PIN_M
       underthrottle = -(float)MIX_THROTTLE_INCREASE_MAX;
 
     if (underthrottle < 0.0f) {
-      for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++)
+      for (uint32_t i = 0; i < count; i++)
         mix[i] -= underthrottle;
     }
   }
 }
 
-static void motor_mixer_scale_calc(float throttle, float mix[MOTOR_PIN_MAX]) {
+static void motor_mixer_scale_calc(float throttle, float limit, float mix[MOTOR_PIN_MAX]) {
   if (target.brushless) {
-    return motor_brushless_mixer_scale_calc(throttle, mix);
+    return motor_brushless_mixer_scale_calc(throttle, limit, mix);
   }
-  return motor_brushed_mixer_scale_calc(throttle, mix);
+  return motor_brushed_mixer_scale_calc(throttle, limit, mix);
 }
 
 void motor_test_calc(bool motortest_usb, float mix[MOTOR_PIN_MAX]) {
+  sag_compensation = motor_sag_compensation();
+
   if (motortest_usb) {
     // set mix according to values we got via usb
-    mix[MOTOR_FR] = motor_test.value[MOTOR_FR];
-    mix[MOTOR_FL] = motor_test.value[MOTOR_FL];
-    mix[MOTOR_BR] = motor_test.value[MOTOR_BR];
-    mix[MOTOR_BL] = motor_test.value[MOTOR_BL];
-  } else {
-    // set mix according to sticks
-    if (state.rx_filtered.roll < -0.5f || state.rx_filtered.pitch < -0.5f) {
-      mix[MOTOR_FR] = 0;
-    } else {
-      mix[MOTOR_FR] = state.throttle;
-    }
-
-    if (state.rx_filtered.roll > 0.5f || state.rx_filtered.pitch < -0.5f) {
-      mix[MOTOR_FL] = 0;
-    } else {
-      mix[MOTOR_FL] = state.throttle;
+    for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
+      mix[i] = motor_test.value[i];
     }
+    return;
+  }
 
-    if (state.rx_filtered.roll < -0.5f || state.rx_filtered.pitch > 0.5f) {
-      mix[MOTOR_BR] = 0;
-    } else {
-      mix[MOTOR_BR] = state.throttle;
-    }
+  // set mix according to sticks, a motor is cut when the stick points towards its side of the frame
+  for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
+    const vec4_t *weights = &profile.motor.mixer[i];
 
-    if (state.rx_filtered.roll > 0.5f || state.rx_filtered.pitch > 0.5f) {
-      mix[MOTOR_BL] = 0;
+    const bool roll_cut = (weights->roll > 0.0f && state.rx_filtered.roll > 0.5f) || (weights->roll < 0.0f && state.rx_filtered.roll < -0.5f);
+    const bool pitch_cut = (weights->pitch > 0.0f && state.rx_filtered.pitch > 0.5f) || (weights->pitch < 0.0f && state.rx_filtered.pitch < -0.5f);
+    if (roll_cut || pitch_cut) {
+      mix[i] = 0;
     } else {
-      mix[MOTOR_BL] = state.throttle;
+      mix[i] = state.throttle;
     }
   }
 }
 
-void motor_mixer_calc(float mix[MOTOR_PIN_MAX]) {
+FAST_CODE void motor_mixer_calc(float mix[MOTOR_PIN_MAX]) {
   const float yaw = profile.motor.invert_yaw ? -state.pidoutput.yaw : state.pidoutput.yaw;
+  const uint32_t count = motor_count();
 
-#ifndef MOTOR_PLUS_CONFIGURATION
-  // normal mode, we set mix according to pidoutput
-  mix[MOTOR_FR] = -state.pidoutput.roll - state.pidoutput.pitch + yaw; // FR
-  mix[MOTOR_FL] = +state.pidoutput.roll - state.pidoutput.pitch - yaw; // FL
-  mix[MOTOR_BR] = -state.pidoutput.roll + state.pidoutput.pitch - yaw; // BR
-  mix[MOTOR_BL] = +state.pidoutput.roll + state.pidoutput.pitch + yaw; // BL
-#else
-  // plus mode, we set mix according to pidoutput
-  mix[MOTOR_FR] = -state.pidoutput.pitch + yaw; // FRONT
-  mix[MOTOR_FL] = +state.pidoutput.roll - yaw;  // LEFT
-  mix[MOTOR_BR] = -state.pidoutput.roll - yaw;  // RIGHT
-  mix[MOTOR_BL] = +state.pidoutput.pitch + yaw; // BACK
-#endif
+  // mix = mixer * pidoutput, throttle is added by the scale step below
+  for (uint32_t i = 0; i < count; i++) {
+    const vec4_t *weights = &profile.motor.mixer[i];
+    mix[i] = weights->roll * state.pidoutput.roll + weights->pitch * state.pidoutput.pitch + weights->yaw * yaw;
+  }
+  for (uint32_t i = count; i < MOTOR_PIN_MAX; i++) {
+    mix[i] = 0;
+  }
 
   if (profile.motor.torque_boost > 0.0f) {
-    for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
+    for (uint32_t i = 0; i < count; i++) {
       mix[i] = motord(mix[i], i);
     }
   }
 
-  motor_mixer_scale_calc(state.throttle, mix);
+  sag_compensation = motor_sag_compensation();
+  motor_mixer_scale_calc(state.throttle, motor_mix_limit(sag_compensation), mix);
 }
 
 //********************************MOTOR OUTPUT***********************************************************
-void motor_output_calc(float mix[MOTOR_PIN_MAX]) {
+// inverse of thrust = (1 - k) * cmd + k * cmd^2
+static float motor_thrust_inverse(float thrust, float k) {
+  if (k <= 0.0f) {
+    return thrust;
+  }
+  const float b = 1.0f - k;
+  return (sqrtf(b * b + 4.0f * k * thrust) - b) / (2.0f * k);
+}
+
+// only rebuilt when the profile changes, the loop just interpolates
+static void motor_thrust_lut_update() {
+  const float linearization = profile.motor.thrust_linearization;
+  if (thrust_lut_valid && thrust_lut.linearization == linearization) {
+    return;
+  }
+
+  const float k = constrain(linearization * 0.01f, 0.0f, 1.0f);
+  for (uint32_t i = 0; i <= MOTOR_LUT_SIZE; i++) {
+    thrust_lut.table[i] = motor_thrust_inverse((float)i / (float)MOTOR_LUT_SIZE, k);
+  }
+
+  thrust_lut.linearization = linearization;
+  thrust_lut_valid = true;
+}
+
+static float motor_thrust_lookup(float x) {
+  const float pos = constrain(x, 0.0f, 1.0f) * MOTOR_LUT_SIZE;
+
+  uint32_t index = pos;
+  if (index >= MOTOR_LUT_SIZE) {
+    index = MOTOR_LUT_SIZE - 1;
+  }
+
+  const float frac = pos - index;
+  return thrust_lut.table[index] + (thrust_lut.table[index + 1] - thrust_lut.table[index]) * frac;
+}
+
+FAST_CODE void motor_output_calc(float mix[MOTOR_PIN_MAX]) {
   state.thrsum = 0; // reset throttle sum for voltage monitoring logic in main loop
 
+  motor_thrust_lut_update();
+  const bool linearize = profile.motor.thrust_linearization > 0.0f;
+
   // only apply digital idle if we are armed and not in motor test
   float motor_min_value = 0;
   if (!flags.on_ground && flags.arm_state && !flags.motortest_override) {
@@ -220,11 +316,17 @@ void motor_output_calc(float mix[MOTOR_PIN_MAX]) {
     motor_min_value = 0.0001f + (float)profile.motor.digital_idle * 0.01f;
   }
 
+  const uint32_t count = motor_count();
+
   // Begin for-loop to send motor commands
-  for (uint32_t i = 0; i < MOTOR_PIN_MAX; i++) {
+  for (uint32_t i = 0; i < count; i++) {
     if (!flags.motortest_override) {
       // use values as supplied in motor test mode
       mix[i] = constrain(mix[i], 0, 1);
+      if (linearize) {
+        mix[i] = motor_thrust_lookup(mix[i]);
+      }
+      mix[i] = constrain(mix[i] * sag_compensation, 0, 1);
       mix[i] = mapf(mix[i], 0.0f, 1.0f, motor_min_value, profile.motor.motor_limit * 0.01f);
     }
 
@@ -234,6 +336,13 @@ void motor_output_calc(float mix[MOTOR_PIN_MAX]) {
     state.thrsum += mix[i];
   }
 
+  // outputs not used by the mixer stay off
+  for (uint32_t i = count; i < MOTOR_PIN_MAX; i++) {
+#ifndef NOMOTORS
+    motor_set(i, MOTOR_OFF);
+#endif
+  }
+
   // calculate throttle sum for voltage monitoring logic in main loop
-  state.thrsum = state.thrsum / MOTOR_PIN_MAX;
+  state.thrsum = state.thrsum / count;
 }
@@ -39,16 +39,47 @@ static const float pid_scales[PID_SIZE][PID_SIZE] = {
     {1.0f / 120.0f, 1.0f / 120.0f, 1.0f / 120.0f}, // kd
 };
 
-static float lasterror[PID_SIZE] = {0, 0, 0};
-static float lasterror2[PID_SIZE] = {0, 0, 0};
+// everything pid_calc needs that only depends on the profile, looptime or aux state
+typedef struct {
+  uint32_t profile_generation;
+  uint8_t pid_profile;
+  uint8_t stick_boost_profile;
+  uint16_t looptime_autodetect;
+  float rx_filter_hz;
+} pid_controller_key_t;
 
-static float lastrate[PID_SIZE] = {0, 0, 0};
-static float lastsetpoint[PID_SIZE] = {0, 0, 0};
+typedef struct {
+  pid_controller_key_t key;
 
-static float ierror[PID_SIZE] = {0, 0, 0};
+  float p_error_gain[PID_SIZE]; // kp * setpoint weight
+  float p_gyro_gain[PID_SIZE];  // kp * (1 - setpoint weight)
+  float ki[PID_SIZE];
+  float kd[PID_SIZE];
 
-static filter_t filter[FILTER_MAX_SLOTS];
-static filter_state_t filter_state[FILTER_MAX_SLOTS][3];
+  float out_limit[PID_SIZE];
+  float integral_limit[PID_SIZE];
+
+  float stick_accelerator[PID_SIZE];
+  float stick_feedforward[PID_SIZE];
+  float transition_gain[PID_SIZE];
+  float transition_offset[PID_SIZE];
+
+  bool rx_filter_enable;
+} pid_controller_t;
+
+FAST_RAM static pid_controller_t controller;
+static bool controller_valid = false;
+
+FAST_RAM static float lasterror[PID_SIZE] = {0, 0, 0};
+FAST_RAM static float lasterror2[PID_SIZE] = {0, 0, 0};
+
+FAST_RAM static float lastrate[PID_SIZE] = {0, 0, 0};
+FAST_RAM static float lastsetpoint[PID_SIZE] = {0, 0, 0};
+
+FAST_RAM static float ierror[PID_SIZE] = {0, 0, 0};
+
+FAST_RAM static filter_t filter[FILTER_MAX_SLOTS];
+FAST_RAM static filter_state_t filter_state[FILTER_MAX_SLOTS][3];
 
 static filter_lp_pt1 dynamic_filter;
 static filter_state_t dynamic_filter_state[3];
@@ -57,10 +88,12 @@ static filter_lp_pt1 rx_filter;
 static filter_state_t rx_filter_state[3];
 
 void pid_init() {
+  controller_valid = false;
+
   filter_lp_pt1_init(&rx_filter, rx_filter_state, 3, state.rx_filter_hz);
 
   for (uint8_t i = 0; i < FILTER_MAX_SLOTS; i++) {
-    filter_init(profile.filter.dterm[i].type, &filter[i], filter_state[i], 3, profile.filter.dterm[i].cutoff_freq);
+    filter_init(profile.filter.dterm[i].type, &filter[i], filter_state[i], 3, profile.filter.dterm[i].cutoff_freq, profile.filter.dterm[i].q);
   }
 
   if (profile.filter.dterm_dynamic_enable) {
@@ -71,11 +104,11 @@ void pid_init() {
 
 // (iwindup = 0  windup is not allowed)   (iwindup = 1 windup is allowed)
 static inline float pid_compute_iterm_windup(uint8_t x, float pid_output) {
-  const float *out_limit = target.brushless ? out_limit_brushless : out_limit_brushed;
-  if ((pid_output >= out_limit[x]) && (state.error.axis[x] > 0)) {
+  const float out_limit = controller.out_limit[x];
+  if ((pid_output >= out_limit) && (state.error.axis[x] > 0)) {
     return 0.0f;
   }
-  if ((pid_output <= -out_limit[x]) && (state.error.axis[x] < 0)) {
+  if ((pid_output <= -out_limit) && (state.error.axis[x] < 0)) {
     return 0.0f;
   }
 
@@ -152,9 +185,67 @@ static inline float pid_tda_compensation() {
   return constrain(tda_compensation, profile.pid.throttle_dterm_attenuation.tda_percent, 1.0f);
 }
 
+static void pid_compile(const pid_controller_key_t *key) {
+  const pid_rate_t *rates = &profile.pid.pid_rates[key->pid_profile];
+  const stick_rate_t *stick_rates = &profile.pid.stick_rates[key->stick_boost_profile];
+
+  const float *out_limit = target.brushless ? out_limit_brushless : out_limit_brushed;
+  const float *setpoint_weigth = target.brushless ? setpoint_weigth_brushless : setpoint_weigth_brushed;
+  const float *integral_limit = target.brushless ? integral_limit_brushless : integral_limit_brushed;
+
+  for (uint8_t x = 0; x < PID_SIZE; x++) {
+    const float kp = rates->kp.axis[x] * pid_scales[0][x];
+    controller.p_error_gain[x] = kp * setpoint_weigth[x];
+    controller.p_gyro_gain[x] = kp * (1.0f - setpoint_weigth[x]);
+    controller.ki[x] = rates->ki.axis[x] * pid_scales[1][x];
+    controller.kd[x] = rates->kd.axis[x] * pid_scales[2][x];
+
+    controller.out_limit[x] = out_limit[x];
+    controller.integral_limit[x] = integral_limit[x];
+
+    const float accelerator = stick_rates->accelerator.axis[x];
+    const float transition = stick_rates->transition.axis[x];
+    controller.stick_accelerator[x] = accelerator;
+    controller.stick_feedforward[x] = stick_rates->feedforward.axis[x] * pid_scales[2][x];
+    controller.transition_gain[x] = accelerator < 1 ? transition : transition / accelerator;
+    controller.transition_offset[x] = 1 - transition;
+  }
+
+  controller.rx_filter_enable = key->rx_filter_hz > 0.1f;
+
+  filter_lp_pt1_coeff(&rx_filter, key->rx_filter_hz);
+  filter_coeff(profile.filter.dterm[0].type, &filter[0], filter_state[0], 3, profile.filter.dterm[0].cutoff_freq, profile.filter.dterm[0].q);
+  filter_coeff(profile.filter.dterm[1].type, &filter[1], filter_state[1], 3, profile.filter.dterm[1].cutoff_freq, profile.filter.dterm[1].q);
+
+  controller.key = *key;
+  controller_valid = true;
+}
+
+// recompiled when the profile was edited (osd menu, quic, flash load) or an aux or looptime input changed
+static void pid_update_controller() {
+  const pid_controller_key_t key = {
+      .profile_generation = profile_generation,
+      .pid_profile = profile.pid.pid_profile,
+      .stick_boost_profile = rx_aux_on(AUX_STICK_BOOST_PROFILE) ? STICK_PROFILE_ON : STICK_PROFILE_OFF,
+      .looptime_autodetect = state.looptime_autodetect,
+      .rx_filter_hz = state.rx_filter_hz,
+  };
+
+  if (controller_valid &&
+      controller.key.profile_generation == key.profile_generation &&
+      controller.key.pid_profile == key.pid_profile &&
+      controller.key.stick_boost_profile == key.stick_boost_profile &&
+      controller.key.looptime_autodetect == key.looptime_autodetect &&
+      controller.key.rx_filter_hz == key.rx_filter_hz) {
+    return;
+  }
+
+  pid_compile(&key);
+}
+
 // input: error[] = setpoint - gyro
 // output: state.pidoutput.axis[] = change required from motors
-void pid_calc() {
+FAST_CODE void pid_calc() {
   // rotates errors, originally by joelucid
 
   // rotation around x axis:
@@ -169,20 +260,11 @@ void pid_calc() {
   ierror[0] -= ierror[1] * state.gyro_delta_angle.axis[2];
   ierror[1] += ierror[0] * state.gyro_delta_angle.axis[2];
 
-  filter_lp_pt1_coeff(&rx_filter, state.rx_filter_hz);
-  filter_coeff(profile.filter.dterm[0].type, &filter[0], profile.filter.dterm[0].cutoff_freq);
-  filter_coeff(profile.filter.dterm[1].type, &filter[1], profile.filter.dterm[1].cutoff_freq);
+  pid_update_controller();
 
   static vec3_t pid_output = {.roll = 0, .pitch = 0, .yaw = 0};
   const float v_compensation = pid_voltage_compensation();
   const float tda_compensation = pid_tda_compensation();
-  const float *out_limit = target.brushless ? out_limit_brushless : out_limit_brushed;
-  const float *setpoint_weigth = target.brushless ? setpoint_weigth_brushless : setpoint_weigth_brushed;
-  const float *integral_limit = target.brushless ? integral_limit_brushless : integral_limit_brushed;
-
-  const uint8_t stick_boost_profile = rx_aux_on(AUX_STICK_BOOST_PROFILE) ? STICK_PROFILE_ON : STICK_PROFILE_OFF;
-  const float *stick_accelerator = profile.pid.stick_rates[stick_boost_profile].accelerator.axis;
-  const float *stick_transition = profile.pid.stick_rates[stick_boost_profile].transition.axis;
 
   if (profile.filter.dterm_dynamic_enable) {
     float dynamic_throttle = state.throttle + state.throttle * (1 - state.throttle) * DTERM_DYNAMIC_EXPO;
@@ -194,13 +276,8 @@ void pid_calc() {
 
 #pragma GCC unroll 3
   for (uint8_t x = 0; x < PID_SIZE; x++) {
-    const float current_kp = profile_current_pid_rates()->kp.axis[x] * pid_scales[0][x];
-    const float current_ki = profile_current_pid_rates()->ki.axis[x] * pid_scales[1][x];
-    const float current_kd = profile_current_pid_rates()->kd.axis[x] * pid_scales[2][x];
-
     // P term
-    state.pid_p_term.axis[x] = state.error.axis[x] * (setpoint_weigth[x]) * current_kp;
-    state.pid_p_term.axis[x] += -(1.0f - setpoint_weigth[x]) * current_kp * state.gyro.axis[x];
+    state.pid_p_term.axis[x] = state.error.axis[x] * controller.p_error_gain[x] - controller.p_gyro_gain[x] * state.gyro.axis[x];
 
     // Pid Voltage Comp applied to P term only
     state.pid_p_term.axis[x] *= v_compensation;
@@ -213,34 +290,35 @@ void pid_calc() {
     }
     // SIMPSON_RULE_INTEGRAL
     // assuming similar time intervals
-    ierror[x] = ierror[x] + 0.166666f * (lasterror2[x] + 4 * lasterror[x] + state.error.axis[x]) * current_ki * iterm_windup * state.looptime;
-    ierror[x] = constrain(ierror[x], -integral_limit[x], integral_limit[x]);
+    ierror[x] = ierror[x] + 0.166666f * (lasterror2[x] + 4 * lasterror[x] + state.error.axis[x]) * controller.ki[x] * iterm_windup * state.looptime;
+    ierror[x] = constrain(ierror[x], -controller.integral_limit[x], controller.integral_limit[x]);
     lasterror2[x] = lasterror[x];
     lasterror[x] = state.error.axis[x];
 
     state.pid_i_term.axis[x] = ierror[x];
 
     // D term
-    float transition_setpoint_weight = 0;
-    if (stick_accelerator[x] < 1) {
-      transition_setpoint_weight = (fabsf(state.rx_filtered.axis[x]) * stick_transition[x]) + (1 - stick_transition[x]);
-    } else {
-      transition_setpoint_weight = (fabsf(state.rx_filtered.axis[x]) * (stick_transition[x] / stick_accelerator[x])) + (1 - stick_transition[x]);
-    }
+    const float transition_setpoint_weight = fabsf(state.rx_filtered.axis[x]) * controller.transition_gain[x] + controller.transition_offset[x];
 
-    float setpoint_derivative = (state.setpoint.axis[x] - lastsetpoint[x]) * current_kd * state.timefactor;
-    if (state.rx_filter_hz > 0.1f) {
-      setpoint_derivative = filter_lp_pt1_step(&rx_filter, &rx_filter_state[x], setpoint_derivative);
+    float setpoint_delta = (state.setpoint.axis[x] - lastsetpoint[x]) * state.timefactor;
+    if (controller.rx_filter_enable) {
+      setpoint_delta = filter_lp_pt1_step(&rx_filter, &rx_filter_state[x], setpoint_delta);
     }
     lastsetpoint[x] = state.setpoint.axis[x];
 
-    const float gyro_derivative = (state.gyro.axis[x] - lastrate[x]) * current_kd * state.timefactor * tda_compensation;
+    const float setpoint_derivative = setpoint_delta * controller.kd[x];
+
+    const float gyro_derivative = (state.gyro.axis[x] - lastrate[x]) * controller.kd[x] * state.timefactor * tda_compensation;
     lastrate[x] = state.gyro.axis[x];
 
-    const float dterm = (setpoint_derivative * stick_accelerator[x] * transition_setpoint_weight) - (gyro_derivative);
+    const float dterm = (setpoint_derivative * controller.stick_accelerator[x] * transition_setpoint_weight) - (gyro_derivative);
     state.pid_d_term.axis[x] = pid_filter_dterm(x, dterm);
 
-    state.pidoutput.axis[x] = pid_output.axis[x] = state.pid_p_term.axis[x] + state.pid_i_term.axis[x] + state.pid_d_term.axis[x];
-    state.pidoutput.axis[x] = constrain(state.pidoutput.axis[x], -out_limit[x], out_limit[x]);
+    // FF term
+    // the setpoint is interpolated between rx frames, so its derivative is smooth enough to feed straight through
+    state.pid_ff_term.axis[x] = setpoint_delta * controller.stick_feedforward[x];
+
+    state.pidoutput.axis[x] = pid_output.axis[x] = state.pid_p_term.axis[x] + state.pid_i_term.axis[x] + state.pid_d_term.axis[x] + state.pid_ff_term.axis[x];
+    state.pidoutput.axis[x] = constrain(state.pidoutput.axis[x], -controller.out_limit[x], controller.out_limit[x]);
   }
 }
@@ -22,6 +22,9 @@
 #define WAIT_TIME 15e6
 #define GLOW_TIME 62500
 
+// max difference between the stored and the current gyro temperature in degC
+#define GYRO_CAL_TEMP_TOLERANCE 3.0f
+
 #define GYRO_BIAS_LIMIT 800
 #define ACCEL_BIAS_LIMIT 800
 
@@ -33,26 +36,87 @@
 
 #ifdef USE_GYRO
 
-static filter_t filter[FILTER_MAX_SLOTS];
-static filter_state_t filter_state[FILTER_MAX_SLOTS][3];
+FAST_RAM static filter_t filter[FILTER_MAX_SLOTS];
+FAST_RAM static filter_state_t filter_state[FILTER_MAX_SLOTS][3];
 
 float gyrocal[3];
 
+// still samples left to refine a restored calibration with
+static uint32_t gyro_cal_refine_counter = 0;
+
 bool sixaxis_init() {
   const gyro_types_t id = gyro_spi_init();
 
   target_info.gyro_id = id;
+  if (gyro_spi_count() > 1) {
+    target_info.gyro2_id = gyro_spi_type(1);
+  }
 
   for (uint8_t i = 0; i < FILTER_MAX_SLOTS; i++) {
-    filter_init(profile.filter.gyro[i].type, &filter[i], filter_state[i], 3, profile.filter.gyro[i].cutoff_freq);
+    filter_init(profile.filter.gyro[i].type, &filter[i], filter_state[i], 3, profile.filter.gyro[i].cutoff_freq, profile.filter.gyro[i].q);
   }
 
   return id != GYRO_TYPE_INVALID;
 }
 
-void sixaxis_read() {
+static bool test_gyro_move(const gyro_data_t *last_data, const gyro_data_t *data) {
+  bool did_move = false;
+  for (uint8_t i = 0; i < 3; i++) {
+    const float delta = fabsf(fabsf(last_data->gyro.axis[i] * GYRO_RANGE) - fabsf(data->gyro.axis[i] * GYRO_RANGE));
+    if (delta > 0.3f) {
+      did_move = true;
+      break;
+    }
+  }
+  return did_move;
+}
+
+static void sixaxis_gyro_cal_store(float temp) {
+  for (uint8_t i = 0; i < 3; i++) {
+    flash_storage.gyrocal[i] = gyrocal[i];
+  }
+  flash_storage.gyrocal_temp = temp * 10;
+  flash_storage.gyrocal_valid = FLASH_GYROCAL_VALID;
+}
+
+// keeps converging a restored bias at the 1khz rate of the full calibration,
+// but only while the craft sits still and has not been armed yet
+static void sixaxis_gyro_cal_refine(const gyro_data_t *data) {
+  static gyro_data_t last_data;
+  static uint32_t last_time = 0;
+
+  if (flags.arm_state) {
+    gyro_cal_refine_counter = 0;
+    return;
+  }
+
+  const uint32_t now = time_micros();
+  if ((now - last_time) < 1000) {
+    return;
+  }
+  last_time = now;
+
+  const bool did_move = test_gyro_move(&last_data, data);
+  last_data = *data;
+  if (did_move) {
+    return;
+  }
+
+  for (uint8_t i = 0; i < 3; i++) {
+    lpf(&gyrocal[i], data->gyro.axis[i], lpfcalc(1000, 0.5 * 1e6));
+  }
+  if (--gyro_cal_refine_counter == 0) {
+    sixaxis_gyro_cal_store(data->temp);
+  }
+}
+
+FAST_CODE void sixaxis_read() {
   const gyro_data_t data = gyro_spi_read();
 
+  if (gyro_cal_refine_counter) {
+    sixaxis_gyro_cal_refine(&data);
+  }
+
   // remove bias and reduce to state.accel_raw in G
   state.accel_raw.roll = (data.accel.roll - flash_storage.accelcal[0]) * (1 / 2048.0f);
   state.accel_raw.pitch = (data.accel.pitch - flash_storage.accelcal[1]) * (1 / 2048.0f);
@@ -64,6 +128,10 @@ void sixaxis_read() {
 
   state.gyro_temp = data.temp;
 
+  for (uint8_t i = 0; i < gyro_spi_count(); i++) {
+    state.gyro_noise[i] = gyro_spi_noise(i) * GYRO_RANGE;
+  }
+
   float temp = 0;
 
   if (profile.motor.gyro_orientation & GYRO_ROTATE_90_CW) {
@@ -122,8 +190,8 @@ void sixaxis_read() {
     state.gyro_raw.yaw = -state.gyro_raw.yaw;
   }
 
-  filter_coeff(profile.filter.gyro[0].type, &filter[0], profile.filter.gyro[0].cutoff_freq);
-  filter_coeff(profile.filter.gyro[1].type, &filter[1], profile.filter.gyro[1].cutoff_freq);
+  filter_coeff_period(profile.filter.gyro[0].type, &filter[0], filter_state[0], 3, profile.filter.gyro[0].cutoff_freq, profile.filter.gyro[0].q, state.gyro_looptime_autodetect);
+  filter_coeff_period(profile.filter.gyro[1].type, &filter[1], filter_state[1], 3, profile.filter.gyro[1].cutoff_freq, profile.filter.gyro[1].q, state.gyro_looptime_autodetect);
 
   state.gyro.roll = state.gyro_raw.roll = state.gyro_raw.roll * GYRO_RANGE * DEGTORAD;
   state.gyro.pitch = state.gyro_raw.pitch = -state.gyro_raw.pitch * GYRO_RANGE * DEGTORAD;
@@ -140,18 +208,6 @@ void sixaxis_read() {
   state.gyro_delta_angle.yaw = state.gyro.yaw * state.looptime;
 }
 
-static bool test_gyro_move(const gyro_data_t *last_data, const gyro_data_t *data) {
-  bool did_move = false;
-  for (uint8_t i = 0; i < 3; i++) {
-    const float delta = fabsf(fabsf(last_data->gyro.axis[i] * GYRO_RANGE) - fabsf(data->gyro.axis[i] * GYRO_RANGE));
-    if (delta > 0.3f) {
-      did_move = true;
-      break;
-    }
-  }
-  return did_move;
-}
-
 // returns true if it's already still, i.e. no move since the first loops
 static bool sixaxis_wait_for_still(uint32_t timeout) {
   uint8_t move_counter = 15;
@@ -193,6 +249,7 @@ void sixaxis_gyro_cal() {
     time_delay_ms(200);
   }
   gyro_spi_calibrate();
+  gyro_cal_refine_counter = 0;
 
   uint8_t brightness = 0;
   led_pwm(brightness, 1000);
@@ -217,6 +274,7 @@ void sixaxis_gyro_cal() {
         lpf(&gyrocal[i], data.gyro.axis[i], lpfcalc(1000, 0.5 * 1e6));
       }
       if (--cal_counter <= 0) {
+        sixaxis_gyro_cal_store(data.temp);
         break;
       }
     }
@@ -229,6 +287,45 @@ void sixaxis_gyro_cal() {
   }
 }
 
+static bool sixaxis_gyro_cal_stored(float temp) {
+  if (!gyro_spi_has_temp()) {
+    // without a temperature there is no telling if the bias still fits
+    return false;
+  }
+  if (flash_storage.gyrocal_valid != FLASH_GYROCAL_VALID) {
+    return false;
+  }
+  if (fabsf(flash_storage.gyrocal_temp * 0.1f - temp) > GYRO_CAL_TEMP_TOLERANCE) {
+    return false;
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    if (!isfinite(flash_storage.gyrocal[i]) || fabsf(flash_storage.gyrocal[i]) > GYRO_BIAS_LIMIT) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// reuses the stored bias if the craft is already still at a similar temperature
+// and refines it in the background, otherwise runs the full calibration.
+// a new bias only lives in the ram copy of flash_storage, a sector erase at boot would
+// stall for seconds and put the profile at risk, it reaches flash with the next settings save.
+void sixaxis_gyro_cal_boot() {
+  if (sixaxis_wait_for_still(WAIT_TIME / 15)) {
+    const gyro_data_t data = gyro_spi_read();
+    if (sixaxis_gyro_cal_stored(data.temp)) {
+      gyro_spi_calibrate();
+
+      for (uint8_t i = 0; i < 3; i++) {
+        gyrocal[i] = flash_storage.gyrocal[i];
+      }
+      gyro_cal_refine_counter = CAL_TIME / 1000;
+      return;
+    }
+  }
+  sixaxis_gyro_cal();
+}
+
 void sixaxis_acc_cal() {
   flash_storage.accelcal[2] = 2048;
   for (int y = 0; y < 500; y++) {
@@ -250,6 +347,7 @@ bool sixaxis_init() { return false; }
 void sixaxis_read() {}
 
 void sixaxis_gyro_cal() {}
+void sixaxis_gyro_cal_boot() {}
 void sixaxis_acc_cal() {}
 
 #endif
\ No newline at end of file
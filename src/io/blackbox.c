@@ -71,6 +71,13 @@ cbor_result_t cbor_encode_blackbox_t(cbor_value_t *enc, const blackbox_t *b, con
     CBOR_CHECK_ERROR(res = cbor_encode_int16_t(enc, &b->debug[3]));
   }
 
+  if (field_flags & (1 << BBOX_FIELD_LATENCY)) {
+    CBOR_CHECK_ERROR(res = cbor_encode_array(enc, LATENCY_STAGE_MAX - 1));
+    for (uint32_t i = 0; i < LATENCY_STAGE_MAX - 1; i++) {
+      CBOR_CHECK_ERROR(res = cbor_encode_uint16_t(enc, &b->latency[i]));
+    }
+  }
+
   CBOR_CHECK_ERROR(res = cbor_encode_end_indefinite(enc));
 
   return res;
@@ -105,7 +112,7 @@ uint8_t blackbox_update() {
     blackbox_enabled = 0;
     return 0;
   } else if ((flags.arm_state && flags.turtle_ready == 0 && rx_aux_on(AUX_BLACKBOX)) && blackbox_enabled == 0) {
-    if (blackbox_device_restart(profile.blackbox.field_flags, blackbox_rate_div(), state.looptime_autodetect)) {
+    if (blackbox_device_restart(profile.blackbox.field_flags, blackbox_rate_div(), state.looptime_autodetect, state.gyro_looptime_autodetect)) {
       blackbox_rate = blackbox_rate_div();
       blackbox_enabled = 1;
       blackbox.loop = 0;
@@ -142,10 +149,16 @@ uint8_t blackbox_update() {
   vec3_compress(&blackbox.accel_filter, &state.accel, BLACKBOX_SCALE);
   vec3_compress(&blackbox.accel_raw, &state.accel_raw, BLACKBOX_SCALE);
 
-  vec4_compress(&blackbox.motor, &state.motor_mix, BLACKBOX_SCALE);
+  // the log format carries four motors, on hex and octo frames the remaining outputs are not recorded
+  vec4_t motor = {{state.motor_mix[0], state.motor_mix[1], state.motor_mix[2], state.motor_mix[3]}};
+  vec4_compress(&blackbox.motor, &motor, BLACKBOX_SCALE);
 
   blackbox.cpu_load = state.cpu_load;
 
+  for (uint32_t i = 0; i < LATENCY_STAGE_MAX - 1; i++) {
+    blackbox.latency[i] = min(latency_counters[i + 1].current, UINT16_MAX);
+  }
+
   blackbox_device_write(profile.blackbox.field_flags, &blackbox);
 
   // tell the rest of the code that flash is occuping the spi bus
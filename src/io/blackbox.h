@@ -1,5 +1,6 @@
 #pragma once
 
+#include "core/latency.h"
 #include "core/profile.h"
 
 #define BLACKBOX_SCALE 1000
@@ -21,11 +22,13 @@ typedef struct {
   compact_vec3_t gyro_raw;
   compact_vec3_t gyro_filter;
 
-  compact_vec4_t motor;
+  compact_vec4_t motor; // first four motors only
 
   uint16_t cpu_load;
 
   int16_t debug[4];
+
+  uint16_t latency[LATENCY_STAGE_MAX - 1];
 } blackbox_t;
 
 // Blackbox fields (should align with above structure)
@@ -44,6 +47,7 @@ typedef enum {
   BBOX_FIELD_MOTOR,
   BBOX_FIELD_CPU_LOAD,
   BBOX_FIELD_DEBUG,
+  BBOX_FIELD_LATENCY,
 
   BBOX_FIELD_MAX,
 } blackbox_field_t;
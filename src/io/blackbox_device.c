@@ -4,6 +4,7 @@
 
 #include "core/looptime.h"
 #include "core/project.h"
+#include "driver/dma.h"
 #include "io/blackbox_device_flash.h"
 #include "io/blackbox_device_sdcard.h"
 #include "util/cbor_helper.h"
@@ -57,10 +58,53 @@ ring_buffer_t blackbox_encode_buffer = {
     .tail = 0,
     .size = BLACKBOX_ENCODE_BUFFER_SIZE,
 };
-uint8_t blackbox_write_buffer[BLACKBOX_WRITE_BUFFER_SIZE];
+// sd card sectors are read straight into it
+uint8_t blackbox_write_buffer[BLACKBOX_WRITE_BUFFER_SIZE] DMA_CACHE_ALIGNED;
 
 static blackbox_device_vtable_t *dev = NULL;
 
+// header layout before the gyro looptime was recorded per file
+#define BLACKBOX_HEADER_MAGIC_V1 0xdeadbeef
+
+typedef struct {
+  uint32_t field_flags;
+  uint32_t looptime;
+  uint8_t blackbox_rate;
+  uint32_t start;
+  uint32_t size;
+} blackbox_device_file_v1_t;
+
+typedef struct {
+  uint32_t magic;
+  uint8_t file_num;
+  blackbox_device_file_v1_t files[BLACKBOX_DEVICE_MAX_FILES];
+} blackbox_device_header_v1_t;
+
+// converts an older header read into blackbox_device_header in place,
+// files recorded before the split gyro loop ran the gyro at the pid rate
+bool blackbox_device_header_migrate() {
+  if (blackbox_device_header.magic != BLACKBOX_HEADER_MAGIC_V1) {
+    return false;
+  }
+
+  blackbox_device_header_v1_t v1;
+  memcpy(&v1, &blackbox_device_header, sizeof(blackbox_device_header_v1_t));
+
+  blackbox_device_header.magic = BLACKBOX_HEADER_MAGIC;
+  blackbox_device_header.file_num = min(v1.file_num, BLACKBOX_DEVICE_MAX_FILES);
+  for (uint32_t i = 0; i < blackbox_device_header.file_num; i++) {
+    blackbox_device_file_t *file = &blackbox_device_header.files[i];
+    file->field_flags = v1.files[i].field_flags;
+    file->looptime = v1.files[i].looptime;
+    file->gyro_looptime = v1.files[i].looptime;
+    file->blackbox_rate = v1.files[i].blackbox_rate;
+    file->start = v1.files[i].start;
+    file->size = v1.files[i].size;
+  }
+
+  return true;
+}
+
 blackbox_device_file_t *blackbox_current_file() {
   return &blackbox_device_header.files[blackbox_device_header.file_num - 1];
 }
@@ -117,7 +161,7 @@ void blackbox_device_reset() {
   looptime_reset();
 }
 
-bool blackbox_device_restart(uint32_t field_flags, uint32_t blackbox_rate, uint32_t looptime) {
+bool blackbox_device_restart(uint32_t field_flags, uint32_t blackbox_rate, uint32_t looptime, uint32_t gyro_looptime) {
   if (dev == NULL) {
     return false;
   }
@@ -137,6 +181,7 @@ bool blackbox_device_restart(uint32_t field_flags, uint32_t blackbox_rate, uint3
 
   blackbox_device_header.files[blackbox_device_header.file_num].field_flags = field_flags;
   blackbox_device_header.files[blackbox_device_header.file_num].looptime = looptime;
+  blackbox_device_header.files[blackbox_device_header.file_num].gyro_looptime = gyro_looptime;
   blackbox_device_header.files[blackbox_device_header.file_num].blackbox_rate = blackbox_rate;
   blackbox_device_header.files[blackbox_device_header.file_num].size = 0;
   blackbox_device_header.files[blackbox_device_header.file_num].start = offset;
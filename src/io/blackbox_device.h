@@ -5,7 +5,7 @@
 #include "io/blackbox.h"
 #include "util/ring_buffer.h"
 
-#define BLACKBOX_HEADER_MAGIC 0xdeadbeef
+#define BLACKBOX_HEADER_MAGIC 0xdeadbef0
 
 // max size for a given entry
 #define BLACKBOX_MAX_SIZE 255
@@ -44,6 +44,7 @@ typedef struct {
 typedef struct {
   uint32_t field_flags;
   uint32_t looptime;
+  uint32_t gyro_looptime;
   uint8_t blackbox_rate;
   uint32_t start;
   uint32_t size;
@@ -52,6 +53,7 @@ typedef struct {
 #define BLACKBOX_DEVICE_FILE_MEMBERS \
   MEMBER(field_flags, uint32_t)      \
   MEMBER(looptime, uint32_t)         \
+  MEMBER(gyro_looptime, uint32_t)    \
   MEMBER(blackbox_rate, uint8_t)     \
   MEMBER(start, uint32_t)            \
   MEMBER(size, uint32_t)
@@ -84,9 +86,10 @@ blackbox_device_result_t blackbox_device_update();
 uint32_t blackbox_device_usage();
 
 blackbox_device_file_t *blackbox_current_file();
+bool blackbox_device_header_migrate();
 
 void blackbox_device_reset();
-bool blackbox_device_restart(uint32_t field_flags, uint32_t blackbox_rate, uint32_t looptime);
+bool blackbox_device_restart(uint32_t field_flags, uint32_t blackbox_rate, uint32_t looptime, uint32_t gyro_looptime);
 void blackbox_device_finish();
 
 void blackbox_device_read(const uint32_t file_index, const uint32_t offset, uint8_t *buffer, const uint32_t size);
@@ -54,6 +54,10 @@ flash_do_more:
     }
 
     m25p16_read_addr(M25P16_READ_DATA_BYTES, 0x0, (uint8_t *)&blackbox_device_header, sizeof(blackbox_device_header_t));
+    if (blackbox_device_header_migrate()) {
+      state = STATE_ERASE_HEADER;
+      break;
+    }
     if (blackbox_device_header.magic != BLACKBOX_HEADER_MAGIC) {
       blackbox_device_header.magic = BLACKBOX_HEADER_MAGIC;
       blackbox_device_header.file_num = 0;
@@ -3,9 +3,12 @@
 #include <string.h>
 
 #include "core/project.h"
+#include "driver/dma.h"
 #include "driver/spi_sdcard.h"
+#include "util/util.h"
 
-#define FLUSH_INTERVAL 8
+// sectors to pre-erase when opening a write session
+#define PRE_ERASE_COUNT 64
 #define FILES_SECTOR_OFFSET 1
 #define PAGE_SIZE SDCARD_PAGE_SIZE
 
@@ -29,6 +32,27 @@ typedef enum {
 static blackbox_device_state_t state = STATE_DETECT;
 static uint8_t should_flush = 0;
 
+// filled while the card is still busy with the previous sector
+static uint8_t write_page_buffer[PAGE_SIZE] DMA_CACHE_ALIGNED;
+
+static uint8_t *write_page = blackbox_write_buffer;
+static uint8_t *next_page = write_page_buffer;
+static uint32_t next_size = 0;
+
+// the card rejected write_page, it is written again once the session is reopened
+static uint8_t retry_page = 0;
+
+static uint32_t blackbox_device_sdcard_fill(uint8_t *page) {
+  const uint32_t available = ring_buffer_available(&blackbox_encode_buffer);
+  if (available < PAGE_SIZE && (should_flush == 0 || available == 0)) {
+    return 0;
+  }
+
+  const uint32_t size = min(available, PAGE_SIZE);
+  ring_buffer_read_multi(&blackbox_encode_buffer, page, size);
+  return size;
+}
+
 void blackbox_device_sdcard_init() {
   sdcard_init();
 
@@ -43,7 +67,14 @@ blackbox_device_result_t blackbox_device_sdcard_update() {
 
   sdcard_status_t sdcard_status = sdcard_update();
   if (sdcard_status != SDCARD_IDLE) {
-    return BLACKBOX_DEVICE_WAIT;
+    if (state < STATE_START_WRITE || state > STATE_FINISH_WRITE) {
+      return BLACKBOX_DEVICE_WAIT;
+    }
+    // the card is busy with write_page, stage the next one meanwhile and keep logging
+    if (state == STATE_CONTINUE_WRITE && next_size == 0) {
+      next_size = blackbox_device_sdcard_fill(next_page);
+    }
+    return BLACKBOX_DEVICE_WRITE;
   }
 
 sdcard_do_more:
@@ -58,6 +89,10 @@ sdcard_do_more:
     if (sdcard_read_pages(blackbox_write_buffer, 0, 1)) {
       memcpy((uint8_t *)&blackbox_device_header, blackbox_write_buffer, sizeof(blackbox_device_header_t));
 
+      if (blackbox_device_header_migrate()) {
+        state = STATE_ERASE_HEADER;
+        break;
+      }
       if (blackbox_device_header.magic != BLACKBOX_HEADER_MAGIC) {
         blackbox_device_header.magic = BLACKBOX_HEADER_MAGIC;
         blackbox_device_header.file_num = 0;
@@ -90,50 +125,60 @@ sdcard_do_more:
 
   case STATE_START_WRITE: {
     offset = (blackbox_current_file()->start + blackbox_current_file()->size) / PAGE_SIZE;
-    if (sdcard_write_pages_start(offset, FLUSH_INTERVAL)) {
+    if (sdcard_write_pages_start(offset, PRE_ERASE_COUNT)) {
       state = STATE_FILL_WRITE_BUFFER;
     }
     return BLACKBOX_DEVICE_WRITE;
   }
 
   case STATE_FILL_WRITE_BUFFER: {
-    write_size = PAGE_SIZE;
-    if (to_write < PAGE_SIZE) {
-      if (should_flush == 0) {
-        break;
-      }
-      if (to_write == 0) {
+    // the session stays open until a flush, the card is only released once
+    if (retry_page) {
+      retry_page = 0;
+    } else if (next_size) {
+      uint8_t *page = write_page;
+      write_page = next_page;
+      next_page = page;
+
+      write_size = next_size;
+      next_size = 0;
+    } else {
+      write_size = blackbox_device_sdcard_fill(write_page);
+    }
+
+    if (write_size == 0) {
+      if (should_flush == 1) {
         state = STATE_FINISH_WRITE;
         goto sdcard_do_more;
       }
-
-      write_size = to_write;
+      break;
     }
 
-    ring_buffer_read_multi(&blackbox_encode_buffer, blackbox_write_buffer, write_size);
     state = STATE_CONTINUE_WRITE;
-    break;
+    goto sdcard_do_more;
   }
 
   case STATE_CONTINUE_WRITE: {
-    static uint32_t counter = 0;
-    if (sdcard_write_pages_continue(blackbox_write_buffer)) {
+    if (sdcard_write_pages_rejected()) {
+      // the file only grows by sectors the card accepted
+      retry_page = 1;
+      state = STATE_FINISH_WRITE;
+      goto sdcard_do_more;
+    }
+    if (next_size == 0) {
+      next_size = blackbox_device_sdcard_fill(next_page);
+    }
+    if (sdcard_write_pages_continue(write_page)) {
       blackbox_current_file()->size += write_size;
-
-      counter++;
-      if (counter == FLUSH_INTERVAL) {
-        counter = 0;
-        state = STATE_FINISH_WRITE;
-      } else {
-        state = STATE_FILL_WRITE_BUFFER;
-      }
+      state = STATE_FILL_WRITE_BUFFER;
+      goto sdcard_do_more;
     }
     return BLACKBOX_DEVICE_WRITE;
   }
 
   case STATE_FINISH_WRITE: {
     if (sdcard_write_pages_finish()) {
-      state = STATE_IDLE;
+      state = retry_page ? STATE_START_WRITE : STATE_IDLE;
     }
     return BLACKBOX_DEVICE_WRITE;
   }
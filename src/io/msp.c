@@ -166,7 +166,7 @@ static void msp_process_serial_cmd(msp_t *msp, msp_magic_t magic, uint16_t cmd,
     break;
   }
   case MSP_MOTOR: {
-    // we always have 4 motors, but blheli expects 8
+    // blheli always expects 8 motors
     // these are pwm values
     uint16_t data[8];
     memset(data, 0, 8 * sizeof(uint16_t));
@@ -263,7 +263,7 @@ static void msp_process_serial_cmd(msp_t *msp, msp_magic_t magic, uint16_t cmd,
 
     default:
     case MSP_PASSTHROUGH_ESC_4WAY: {
-      uint8_t data[1] = {MOTOR_PIN_MAX};
+      uint8_t data[1] = {constrain(profile.motor.motor_count, 1, MOTOR_PIN_MAX)};
       msp_send_reply(msp, magic, cmd, data, 1);
 
       motor_test.active = 0;
@@ -558,10 +558,7 @@ msp_status_t msp_process_serial(msp_t *msp, uint8_t data) {
       return MSP_EOF;
     }
 
-    uint8_t chksum = size ^ cmd;
-    for (uint8_t i = 0; i < size; i++) {
-      chksum ^= msp->buffer[MSP_HEADER_LEN + i];
-    }
+    const uint8_t chksum = crc_xor_data(size ^ cmd, msp->buffer + MSP_HEADER_LEN, size);
 
     if (msp->buffer[MSP_HEADER_LEN + size] != chksum) {
       msp->buffer_offset = 0;
@@ -6,11 +6,14 @@
 
 #include "core/debug.h"
 #include "core/flash.h"
+#include "core/latency.h"
+#include "core/memory.h"
 #include "core/profile.h"
 #include "driver/motor.h"
 #include "driver/serial.h"
 #include "driver/serial_4way.h"
 #include "driver/spi_max7456.h"
+#include "driver/spi_sdcard.h"
 #include "driver/usb.h"
 #include "flight/control.h"
 #include "flight/sixaxis.h"
@@ -161,7 +164,7 @@ static void get_quic(quic_t *quic, cbor_value_t *dec) {
     quic_send(quic, QUIC_CMD_GET, QUIC_FLAG_STREAMING, encode_buffer, cbor_encoder_len(&enc));
 
     const uint8_t count = serial_4way_init();
-    time_delay_ms(500);
+    serial_4way_wait_ready(SERIAL_4WAY_READY_TIMEOUT_MS);
 
     for (uint8_t i = 0; i < count; i++) {
       blheli_settings_t settings;
@@ -215,6 +218,31 @@ static void get_quic(quic_t *quic, cbor_value_t *dec) {
     quic_send(quic, QUIC_CMD_GET, QUIC_FLAG_NONE, encode_buffer, cbor_encoder_len(&enc));
     break;
   }
+  case QUIC_VAL_LATENCY: {
+    res = cbor_encode_latency_counters(&enc);
+    check_cbor_error(QUIC_CMD_GET);
+
+    quic_send(quic, QUIC_CMD_GET, QUIC_FLAG_NONE, encode_buffer, cbor_encoder_len(&enc));
+    break;
+  }
+  case QUIC_VAL_MEMORY: {
+    res = cbor_encode_memory_stats(&enc);
+    check_cbor_error(QUIC_CMD_GET);
+
+    quic_send(quic, QUIC_CMD_GET, QUIC_FLAG_NONE, encode_buffer, cbor_encoder_len(&enc));
+    break;
+  }
+  case QUIC_VAL_MOTOR_MIXER_PRESETS: {
+    res = cbor_encode_array(&enc, motor_mixer_presets_count);
+    check_cbor_error(QUIC_CMD_GET);
+    for (uint32_t i = 0; i < motor_mixer_presets_count; i++) {
+      res = cbor_encode_motor_mixer_preset_t(&enc, &motor_mixer_presets[i]);
+      check_cbor_error(QUIC_CMD_GET);
+    }
+
+    quic_send(quic, QUIC_CMD_GET, QUIC_FLAG_NONE, encode_buffer, cbor_encoder_len(&enc));
+    break;
+  }
   default:
     quic_errorf(QUIC_CMD_GET, "INVALID VALUE %d", value);
     break;
@@ -237,6 +265,7 @@ static void set_quic(quic_t *quic, cbor_value_t *dec) {
   switch (value) {
   case QUIC_VAL_PROFILE: {
     res = cbor_decode_profile_t(dec, &profile);
+    profile_generation++;
     check_cbor_error(QUIC_CMD_SET);
 
     flash_save();
@@ -267,7 +296,7 @@ static void set_quic(quic_t *quic, cbor_value_t *dec) {
   }
   case QUIC_VAL_BLHEL_SETTINGS: {
     uint8_t count = serial_4way_init();
-    time_delay_ms(500);
+    serial_4way_wait_ready(SERIAL_4WAY_READY_TIMEOUT_MS);
 
     for (uint8_t i = 0; i < count; i++) {
       blheli_settings_t settings;
@@ -362,6 +391,15 @@ static void process_blackbox(quic_t *quic, cbor_value_t *dec) {
       check_cbor_error(QUIC_CMD_BLACKBOX);
     }
 
+#ifdef USE_SDCARD
+    if (target_spi_device_valid(&target.sdcard)) {
+      res = cbor_encode_str(&enc, "sdcard");
+      check_cbor_error(QUIC_CMD_BLACKBOX);
+      res = cbor_encode_sdcard_stats_t(&enc, &sdcard_stats);
+      check_cbor_error(QUIC_CMD_BLACKBOX);
+    }
+#endif
+
     res = cbor_encode_end_indefinite(&enc);
     check_cbor_error(QUIC_CMD_BLACKBOX);
 
@@ -443,7 +481,7 @@ static void process_motor_test(quic_t *quic, cbor_value_t *dec) {
     break;
 
   case QUIC_MOTOR_TEST_SET_VALUE: {
-    float values[MOTOR_PIN_MAX];
+    float values[MOTOR_PIN_MAX] = {0};
     res = cbor_decode_float_array(dec, values, MOTOR_PIN_MAX);
     check_cbor_error(QUIC_CMD_MOTOR);
 
@@ -6,10 +6,10 @@
 #include "flight/control.h"
 #include "util/util.h"
 
-// normal flight rgb colour - LED switch ON
+// normal flight rgb colour - armed
 #define RGB_VALUE_INFLIGHT_ON RGB(255, 255, 255)
 
-// normal flight rgb colour - LED switch OFF
+// normal flight rgb colour - disarmed
 #define RGB_VALUE_INFLIGHT_OFF RGB(0, 0, 0)
 
 //  colour before bind
@@ -25,10 +25,10 @@
 #define RGB_FILTER_TIME FILTERCALC(1000 * DOWNSAMPLE, RGB_FILTER_TIME_MICROSECONDS)
 #define RGB(r, g, b) ((((int)g & 0xff) << 16) | (((int)r & 0xff) << 8) | ((int)b & 0xff))
 
-#if (RGB_LED_NUMBER > 0)
+#ifdef USE_RGB_LED
 
 // array with individual led brightnesses
-int rgb_led_value[RGB_LED_NUMBER];
+int rgb_led_value[RGB_LED_MAX];
 // loop count for downsampling
 int rgb_loopcount = 0;
 // rgb low pass filter variables
@@ -49,11 +49,11 @@ void rgb_led_set_all(int rgb) {
 
   int temp = RGB(r_filt, g_filt, b_filt);
 
-  for (int i = 0; i < RGB_LED_NUMBER; i++)
+  for (int i = 0; i < RGB_LED_MAX; i++)
     rgb_led_value[i] = temp;
 
 #else
-  for (int i = 0; i < RGB_LED_NUMBER; i++)
+  for (int i = 0; i < RGB_LED_MAX; i++)
     rgb_led_value[i] = rgb;
 #endif
 }
@@ -82,7 +82,7 @@ int kr_dir = 0;
 void rgb_knight_rider() {
   if (kr_dir) {
     kr_position += KR_SPEED;
-    if (kr_position > RGB_LED_NUMBER - 1)
+    if (kr_position > RGB_LED_MAX - 1)
       kr_dir = !kr_dir;
   } else {
     kr_position -= KR_SPEED;
@@ -91,7 +91,7 @@ void rgb_knight_rider() {
   }
 
   // calculate led value
-  for (int i = 0; i < RGB_LED_NUMBER; i++) {
+  for (int i = 0; i < RGB_LED_MAX; i++) {
     float led_bright = fabsf((float)i - kr_position);
     if (led_bright > 1.0f)
       led_bright = 1.0f;
@@ -105,14 +105,14 @@ void rgb_knight_rider() {
 // 2 led flasher
 void rgb_ledflash_twin(int color1, int color2, uint32_t period) {
   if (time_micros() % period > (period / 2)) {
-    for (int i = 0; i < RGB_LED_NUMBER; i++) {
+    for (int i = 0; i < RGB_LED_MAX; i++) {
       if ((i / 2) * 2 == i)
         rgb_led_set_one(i, color1);
       else
         rgb_led_set_one(i, color2);
     }
   } else {
-    for (int i = 0; i < RGB_LED_NUMBER; i++) {
+    for (int i = 0; i < RGB_LED_MAX; i++) {
       if ((i / 2) * 2 == i)
         rgb_led_set_one(i, color2);
       else
@@ -143,9 +143,8 @@ void rgb_led_lvc() {
           rgb_ledflash(RGB(0, 128, 0), RGB(0, 0, 128), 500000, 8);
           // rgb_led_set_all( RGB( 0 , 128 , 128 ) );
         } else {
-
-          if (rx_aux_on(AUX_LEDS_ON))
-
+          // there is no dedicated led switch, follow the arming state
+          if (flags.arm_state)
             rgb_led_set_all(RGB_VALUE_INFLIGHT_ON);
           else
             rgb_led_set_all(RGB_VALUE_INFLIGHT_OFF);
@@ -153,15 +152,8 @@ void rgb_led_lvc() {
       }
     }
 
-#ifdef RGB_LED_DMA
-    // send dma start signal
-    rgb_send(0);
-#else
-    // send data to leds
-    for (int i = 0; i < RGB_LED_NUMBER; i++) {
-      rgb_send(rgb_led_value[i]);
-    }
-#endif
+    // hand the new values to the dma driver
+    rgb_send();
   }
 }
 
@@ -51,11 +51,7 @@ void usb_msp_send(msp_magic_t magic, uint8_t direction, uint16_t cmd, const uint
 
     memcpy(frame + MSP_HEADER_LEN, data, len);
 
-    uint8_t chksum = len;
-    for (uint8_t i = 4; i < (size - 1); i++) {
-      chksum ^= frame[i];
-    }
-    frame[len + MSP_HEADER_LEN] = chksum;
+    frame[len + MSP_HEADER_LEN] = crc_xor_data(len, frame + 4, len + 1);
 
     usb_serial_write(frame, size);
   }
@@ -3,6 +3,7 @@
 #include "core/flash.h"
 #include "core/profile.h"
 #include "driver/adc.h"
+#include "driver/time.h"
 #include "flight/control.h"
 #include "util/util.h"
 
@@ -13,14 +14,22 @@
 // the lowest vbatt is ever allowed to go
 #define VBATTLOW_ABS 2.7f
 
+#define VBAT_INIT_SAMPLES 500
+#define VBAT_INIT_TIMEOUT_MS 10
+
 extern profile_t profile;
 
 void vbat_init() {
-  int count = 0;
-  while (count < 5000) {
+  // seed the filter with the first conversion instead of converging from zero
+  const uint32_t start = time_millis();
+  do {
+    state.vbat = adc_read(ADC_CHAN_VBAT);
+  } while (state.vbat == 0 && (time_millis() - start) < VBAT_INIT_TIMEOUT_MS);
+  state.vbat_filtered = state.vbat;
+
+  for (int count = 0; count < VBAT_INIT_SAMPLES; count++) {
     state.vbat = adc_read(ADC_CHAN_VBAT);
     lpf(&state.vbat_filtered, state.vbat, 0.9968f);
-    count++;
   }
 
   if (profile.voltage.lipo_cell_count == 0) {
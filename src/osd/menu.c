@@ -2,6 +2,7 @@
 
 #include <string.h>
 
+#include "core/profile.h"
 #include "driver/osd.h"
 #include "osd/render.h"
 #include "util/util.h"
@@ -51,6 +52,9 @@ static void osd_menu_had_change() {
   osd_state.selection_increase = 0;
   osd_state.selection_decrease = 0;
 
+  // most adjustable values live in the profile
+  profile_generation++;
+
   osd_state.screen_phase = OSD_PHASE_REFRESH;
 }
 
@@ -4,6 +4,7 @@
 
 #include "core/flash.h"
 #include "core/looptime.h"
+#include "core/memory.h"
 #include "core/profile.h"
 #include "driver/osd.h"
 #include "flight/control.h"
@@ -65,6 +66,7 @@ static const char *osd_element_labels[] = {
     "THROTTLE",
     "VTX",
     "CURRENT DRAW",
+    "MEMORY",
 };
 
 static const char *aux_channel_labels[] = {
@@ -471,6 +473,18 @@ static void osd_display_regular() {
     break;
   }
 
+  case OSD_MEMORY: {
+    // stack high-water mark and dma pool peak in bytes
+    osd_start(osd_attr(el), el->pos_x, el->pos_y);
+    osd_write_str("STK");
+    osd_write_uint(memory_stats.stack_peak, 6);
+    osd_write_str(" DMA");
+    osd_write_uint(memory_stats.dma_pool_peak, 5);
+
+    osd_state.element++;
+    break;
+  }
+
   case OSD_ELEMENT_MAX: {
     // end of regular display - display_trigger counter sticks here till it wraps
     static uint8_t display_trigger = 0;
@@ -758,11 +772,17 @@ void osd_display() {
         " PT1",
         " PT2",
         " PT3",
+        " BQ2",
+        " BQ4",
+        "NTCH",
+        "BAND",
+        "LDLG",
+        "KALM",
     };
 
     osd_menu_select(4, 4, "PASS 1 TYPE");
     if (osd_menu_select_enum(18, 4, profile.filter.gyro[0].type, filter_type_labels)) {
-      profile.filter.gyro[0].type = osd_menu_adjust_int(profile.filter.gyro[0].type, 1, 0, FILTER_LP_PT3);
+      profile.filter.gyro[0].type = osd_menu_adjust_int(profile.filter.gyro[0].type, 1, 0, FILTER_KALMAN);
       osd_state.reboot_fc_requested = 1;
     }
 
@@ -771,17 +791,27 @@ void osd_display() {
       profile.filter.gyro[0].cutoff_freq = osd_menu_adjust_float(profile.filter.gyro[0].cutoff_freq, 10, 50, 500);
     }
 
-    osd_menu_select(4, 6, "PASS 2 TYPE");
-    if (osd_menu_select_enum(18, 6, profile.filter.gyro[1].type, filter_type_labels)) {
-      profile.filter.gyro[1].type = osd_menu_adjust_int(profile.filter.gyro[1].type, 1, 0, FILTER_LP_PT3);
+    osd_menu_select(4, 6, "PASS 1 Q");
+    if (osd_menu_select_float(18, 6, profile.filter.gyro[0].q, 5, 2)) {
+      profile.filter.gyro[0].q = osd_menu_adjust_float(profile.filter.gyro[0].q, 0.05, 0, 10);
+    }
+
+    osd_menu_select(4, 7, "PASS 2 TYPE");
+    if (osd_menu_select_enum(18, 7, profile.filter.gyro[1].type, filter_type_labels)) {
+      profile.filter.gyro[1].type = osd_menu_adjust_int(profile.filter.gyro[1].type, 1, 0, FILTER_KALMAN);
       osd_state.reboot_fc_requested = 1;
     }
 
-    osd_menu_select(4, 7, "PASS 2 FREQ");
-    if (osd_menu_select_float(18, 7, profile.filter.gyro[1].cutoff_freq, 4, 0)) {
+    osd_menu_select(4, 8, "PASS 2 FREQ");
+    if (osd_menu_select_float(18, 8, profile.filter.gyro[1].cutoff_freq, 4, 0)) {
       profile.filter.gyro[1].cutoff_freq = osd_menu_adjust_float(profile.filter.gyro[1].cutoff_freq, 10, 50, 500);
     }
 
+    osd_menu_select(4, 9, "PASS 2 Q");
+    if (osd_menu_select_float(18, 9, profile.filter.gyro[1].q, 5, 2)) {
+      profile.filter.gyro[1].q = osd_menu_adjust_float(profile.filter.gyro[1].q, 0.05, 0, 10);
+    }
+
     osd_menu_select_save_and_exit(4);
     osd_menu_finish();
     break;
@@ -796,11 +826,17 @@ void osd_display() {
         " PT1",
         " PT2",
         " PT3",
+        " BQ2",
+        " BQ4",
+        "NTCH",
+        "BAND",
+        "LDLG",
+        "KALM",
     };
 
     osd_menu_select(4, 3, "PASS 1 TYPE");
     if (osd_menu_select_enum(18, 3, profile.filter.dterm[0].type, filter_type_labels)) {
-      profile.filter.dterm[0].type = osd_menu_adjust_int(profile.filter.dterm[0].type, 1, 0, FILTER_LP_PT2);
+      profile.filter.dterm[0].type = osd_menu_adjust_int(profile.filter.dterm[0].type, 1, 0, FILTER_KALMAN);
       osd_state.reboot_fc_requested = 1;
     }
 
@@ -809,30 +845,40 @@ void osd_display() {
       profile.filter.dterm[0].cutoff_freq = osd_menu_adjust_float(profile.filter.dterm[0].cutoff_freq, 10, 50, 500);
     }
 
-    osd_menu_select(4, 5, "PASS 2 TYPE");
-    if (osd_menu_select_enum(18, 5, profile.filter.dterm[1].type, filter_type_labels)) {
-      profile.filter.dterm[1].type = osd_menu_adjust_int(profile.filter.dterm[1].type, 1, 0, FILTER_LP_PT2);
+    osd_menu_select(4, 5, "PASS 1 Q");
+    if (osd_menu_select_float(18, 5, profile.filter.dterm[0].q, 5, 2)) {
+      profile.filter.dterm[0].q = osd_menu_adjust_float(profile.filter.dterm[0].q, 0.05, 0, 10);
+    }
+
+    osd_menu_select(4, 6, "PASS 2 TYPE");
+    if (osd_menu_select_enum(18, 6, profile.filter.dterm[1].type, filter_type_labels)) {
+      profile.filter.dterm[1].type = osd_menu_adjust_int(profile.filter.dterm[1].type, 1, 0, FILTER_KALMAN);
       osd_state.reboot_fc_requested = 1;
     }
 
-    osd_menu_select(4, 6, "PASS 2 FREQ");
-    if (osd_menu_select_float(18, 6, profile.filter.dterm[1].cutoff_freq, 4, 0)) {
+    osd_menu_select(4, 7, "PASS 2 FREQ");
+    if (osd_menu_select_float(18, 7, profile.filter.dterm[1].cutoff_freq, 4, 0)) {
       profile.filter.dterm[1].cutoff_freq = osd_menu_adjust_float(profile.filter.dterm[1].cutoff_freq, 10, 50, 500);
     }
 
-    osd_menu_select(4, 7, "DYNAMIC");
-    if (osd_menu_select_enum(18, 7, profile.filter.dterm_dynamic_enable, filter_type_labels)) {
+    osd_menu_select(4, 8, "PASS 2 Q");
+    if (osd_menu_select_float(18, 8, profile.filter.dterm[1].q, 5, 2)) {
+      profile.filter.dterm[1].q = osd_menu_adjust_float(profile.filter.dterm[1].q, 0.05, 0, 10);
+    }
+
+    osd_menu_select(4, 9, "DYNAMIC");
+    if (osd_menu_select_enum(18, 9, profile.filter.dterm_dynamic_enable, filter_type_labels)) {
       profile.filter.dterm_dynamic_enable = osd_menu_adjust_int(profile.filter.dterm_dynamic_enable, 1, 0, FILTER_LP_PT1);
       osd_state.reboot_fc_requested = 1;
     }
 
-    osd_menu_select(4, 8, "FREQ MIN");
-    if (osd_menu_select_float(18, 8, profile.filter.dterm_dynamic_min, 4, 0)) {
+    osd_menu_select(4, 10, "FREQ MIN");
+    if (osd_menu_select_float(18, 10, profile.filter.dterm_dynamic_min, 4, 0)) {
       profile.filter.dterm_dynamic_min = osd_menu_adjust_float(profile.filter.dterm_dynamic_min, 10, 50, 500);
     }
 
-    osd_menu_select(4, 9, "FREQ MAX");
-    if (osd_menu_select_float(18, 9, profile.filter.dterm_dynamic_max, 4, 0)) {
+    osd_menu_select(4, 11, "FREQ MAX");
+    if (osd_menu_select_float(18, 11, profile.filter.dterm_dynamic_max, 4, 0)) {
       profile.filter.dterm_dynamic_max = osd_menu_adjust_float(profile.filter.dterm_dynamic_max, 10, 50, 500);
     }
 
@@ -976,7 +1022,12 @@ void osd_display() {
       rates->transition = osd_menu_adjust_vec3(rates->transition, 0.01, -1.0, 1.0);
     }
 
-    osd_menu_select_save_and_exit(7);
+    osd_menu_select(2, 8, "FEEDFORWARD");
+    if (osd_menu_select_vec3(13, 8, rates->feedforward, 5, 0)) {
+      rates->feedforward = osd_menu_adjust_vec3(rates->feedforward, 1.0, 0.0, 100.0);
+    }
+
+    osd_menu_select_save_and_exit(9);
     osd_menu_finish();
     break;
   }
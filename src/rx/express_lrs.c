@@ -18,9 +18,6 @@
 
 #if defined(USE_RX_SPI_EXPRESS_LRS)
 
-#define ELRS_CRC14_POLY 0x2E57 // 0x372B
-#define ELRS_CRC16_POLY 0x3D65 // 0x9eb2
-
 #define MSP_SET_RX_CONFIG 45
 #define MSP_BUFFER_SIZE 128
 
@@ -62,12 +59,12 @@ extern void fhss_randomize(int32_t seed);
 extern uint8_t fhss_get_index();
 extern void fhss_set_index(const uint8_t value);
 extern uint32_t fhss_get_sync_freq();
-extern uint32_t fhss_next_freq();
+extern const uint8_t *fhss_next_freq_image();
 extern void fhss_reset();
 extern uint8_t fhss_min_lq_for_chaos();
 extern uint32_t fhss_rf_mode_cycle_interval();
 
-extern void elrs_crc_init(uint8_t bits, uint16_t poly);
+extern void elrs_crc_init(uint8_t bits);
 extern uint16_t elrs_crc_calc(const volatile uint8_t *data, uint8_t len, uint16_t crc);
 
 extern expresslrs_mod_settings_t *current_air_rate_config();
@@ -136,9 +133,9 @@ static void elrs_set_switch_mode(const elrs_switch_mode_t mode, uint8_t packet_s
   is_full_res = packet_size == OTA8_PACKET_SIZE;
 
   if (is_full_res) {
-    elrs_crc_init(16, ELRS_CRC16_POLY);
+    elrs_crc_init(16);
   } else {
-    elrs_crc_init(14, ELRS_CRC14_POLY);
+    elrs_crc_init(14);
   }
 
   bind_storage.elrs.switch_mode = mode;
@@ -159,13 +156,10 @@ static bool elrs_hop() {
     return false;
   }
 
-  elrs_set_frequency(fhss_next_freq());
+  const uint8_t tlm_mod = (ota_nonce + 1) % tlm_denom;
+  elrs_hop_frequency(fhss_next_freq_image(), tlm_mod != 0 || tlm_denom == 1);
   already_hop = true;
 
-  const uint8_t tlm_mod = (ota_nonce + 1) % tlm_denom;
-  if (tlm_mod != 0 || tlm_denom == 1) {
-    elrs_enter_rx(rx_spi_packet);
-  }
   return true;
 }
 
@@ -158,7 +158,7 @@ typedef struct {
 
 bool elrs_radio_init();
 
-void elrs_set_frequency(int32_t freq);
+void elrs_hop_frequency(const uint8_t *freq_image, bool enter_rx);
 void elrs_set_rate(uint8_t index, int32_t freq, bool invert_iq, uint32_t flrc_sync_word, uint16_t flrc_crc_seed);
 
 void elrs_enter_rx(volatile uint8_t *packet);
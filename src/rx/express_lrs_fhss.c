@@ -40,6 +40,23 @@ static uint32_t freq_spread;
 static uint8_t fhss_sequence[256];
 static uint32_t fhss_rng_seed = 0;
 
+// SET_RFFREQUENCY payload per channel, so hopping is just a lookup
+static uint8_t fhss_freq_images[256][3];
+
+static uint32_t fhss_get_freq(const uint8_t index) {
+  return config->freq_start + (freq_spread * index / FREQ_SPREAD_SCALE) - freq_correction;
+}
+
+// rebuilt whenever the channel spread or frequency correction changes
+static void fhss_update_freq_images() {
+  for (uint32_t i = 0; i < config->freq_count; i++) {
+    const uint32_t freq = fhss_get_freq(i);
+    fhss_freq_images[i][0] = (freq >> 16) & 0xFF;
+    fhss_freq_images[i][1] = (freq >> 8) & 0xFF;
+    fhss_freq_images[i][2] = freq & 0xFF;
+  }
+}
+
 static uint8_t fhss_rng_max(const uint8_t max) {
   const uint32_t m = 2147483648;
   const uint32_t a = 214013;
@@ -82,6 +99,8 @@ void fhss_randomize(int32_t seed) {
       fhss_sequence[offset + rand] = temp;
     }
   }
+
+  fhss_update_freq_images();
 }
 
 void fhss_set_index(const uint8_t value) {
@@ -92,17 +111,16 @@ uint8_t fhss_get_index() {
   return fhss_index;
 }
 
-static uint32_t fhss_get_freq(const uint8_t index) {
-  return config->freq_start + (freq_spread * index / FREQ_SPREAD_SCALE) - freq_correction;
-}
-
 uint32_t fhss_get_sync_freq() {
   return fhss_get_freq(fhss_sync_index);
 }
 
-uint32_t fhss_next_freq() {
-  fhss_index = (fhss_index + 1) % fhss_sequence_count;
-  return fhss_get_freq(fhss_sequence[fhss_index]);
+const uint8_t *fhss_next_freq_image() {
+  fhss_index++;
+  if (fhss_index >= fhss_sequence_count) {
+    fhss_index = 0;
+  }
+  return fhss_freq_images[fhss_sequence[fhss_index]];
 }
 
 int32_t fhss_update_freq_correction(bool value) {
@@ -115,11 +133,13 @@ int32_t fhss_update_freq_correction(bool value) {
       freq_correction += 1; // FREQ_STEP units
     }
   }
+  fhss_update_freq_images();
   return freq_correction;
 }
 
 void fhss_reset() {
   freq_correction = 0;
+  fhss_update_freq_images();
 }
 
 uint8_t fhss_min_lq_for_chaos() {
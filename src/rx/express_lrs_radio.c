@@ -97,8 +97,8 @@ bool elrs_radio_init() {
   return true;
 }
 
-void elrs_set_frequency(int32_t freq) {
-  sx128x_set_frequency(freq);
+void elrs_hop_frequency(const uint8_t *freq_image, bool enter_rx) {
+  sx128x_hop_async(freq_image, enter_rx);
 }
 
 void elrs_set_rate(uint8_t index, int32_t freq, bool invert_iq, uint32_t flrc_sync_word, uint16_t flrc_crc_seed) {
@@ -1,16 +1,13 @@
 #include "rx/express_lrs.h"
 
 #include "core/project.h"
+#include "util/crc.h"
 
 #if defined(USE_RX_SPI_EXPRESS_LRS)
 
-#define ELRS_CRC_POLY 0x07 // 0x83
-
 #define ELRS_LQ_N 100
 #define ELRS_LQ_SIZE ((ELRS_LQ_N + 31) / 32)
 
-#define CRC_LENGTH 256
-
 typedef struct {
   uint8_t val;
   uint8_t byte;
@@ -29,37 +26,18 @@ typedef struct {
 
 static elrs_snr_mean_t snr_mean;
 
-static uint16_t crc_tab[CRC_LENGTH];
-static uint8_t crc_bits = 0;
-static uint16_t crc_poly = 0;
-static uint16_t crc_bitmask = 0;
-
-void elrs_crc_init(uint8_t bits, uint16_t poly) {
-  if (crc_poly == poly && crc_bits == bits) {
-    return;
-  }
+static uint8_t crc_bits = 14;
 
-  crc_poly = poly;
+// tables for both polynomials live in util/crc.c, just remember which one to use
+void elrs_crc_init(uint8_t bits) {
   crc_bits = bits;
-  crc_bitmask = (1 << crc_bits) - 1;
-
-  uint16_t crc = 0;
-  const uint16_t highbit = 1 << (crc_bits - 1);
-
-  for (uint16_t i = 0; i < CRC_LENGTH; i++) {
-    crc = i << (bits - 8);
-    for (uint8_t j = 0; j < 8; j++) {
-      crc = (crc << 1) ^ ((crc & highbit) ? poly : 0);
-    }
-    crc_tab[i] = crc;
-  }
 }
 
 uint16_t elrs_crc_calc(const volatile uint8_t *data, uint8_t len, uint16_t crc) {
-  while (len--) {
-    crc = (crc << 8) ^ crc_tab[((crc >> (crc_bits - 8)) ^ (uint16_t)*data++) & 0x00FF];
+  if (crc_bits == 16) {
+    return crc16_elrs_data(crc, data, len);
   }
-  return crc & crc_bitmask;
+  return crc14_elrs_data(crc, data, len);
 }
 
 void elrs_lpf_init(elrs_lpf_t *lpf, int32_t beta) {
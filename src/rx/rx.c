@@ -3,6 +3,7 @@
 #include <math.h>
 
 #include "core/flash.h"
+#include "core/latency.h"
 #include "core/profile.h"
 #include "core/project.h"
 #include "driver/serial.h"
@@ -13,6 +14,10 @@
 
 #define RX_FITER_SAMPLE_TIME (5000)
 
+// frame intervals outside of this range are dropouts or bursts, not the link rate
+#define RX_FRAME_INTERVAL_MIN_US 1000
+#define RX_FRAME_INTERVAL_MAX_US 100000
+
 extern profile_t profile;
 
 uint8_t failsafe_siglost = 0;
@@ -23,7 +28,13 @@ static uint32_t frames_per_second = 0;
 static uint32_t frames_missed = 0;
 static uint32_t frames_received = 0;
 
-static filter_lp_pt2 rx_filter;
+static float frame_interval_us = 0;
+
+static uint32_t interp_start_us = 0;
+static float interp_frame[4];
+static float interp_slope[4];
+
+static filter_t rx_filter;
 static filter_state_t rx_filter_state[4];
 
 void rx_lqi_lost_packet() {
@@ -39,8 +50,19 @@ void rx_lqi_lost_packet() {
 }
 
 void rx_lqi_got_packet() {
+  const uint32_t time = time_micros();
+  const uint32_t delta = time - last_frame_time_us;
+  if (delta >= RX_FRAME_INTERVAL_MIN_US && delta <= RX_FRAME_INTERVAL_MAX_US) {
+    if (frame_interval_us == 0) {
+      frame_interval_us = delta;
+    } else {
+      lpf(&frame_interval_us, delta, 0.9f);
+    }
+  }
+
   frames_received++;
-  last_frame_time_us = time_micros();
+  last_frame_time_us = time;
+  latency_stamp(LATENCY_STAGE_ARRIVAL);
 
   frame_missed_time_us = 0;
   failsafe_siglost = 0;
@@ -76,26 +98,57 @@ void rx_lqi_update_direct(float rssi) {
   state.rx_rssi = constrain(rssi, 0.f, 100.f);
 }
 
-static void rx_apply_smoothing() {
-  if (state.rx_filter_hz <= 0.1f) {
-    state.rx_filtered.roll = state.rx.roll = constrain(state.rx.roll, -1.0, 1.0);
-    state.rx_filtered.pitch = state.rx.pitch = constrain(state.rx.pitch, -1.0, 1.0);
-    state.rx_filtered.yaw = state.rx.yaw = constrain(state.rx.yaw, -1.0, 1.0);
-    state.rx_filtered.throttle = state.rx.throttle = constrain(state.rx.throttle, 0.0, 1.0);
+// called once per decoded frame, the new sticks are used right away and the
+// slope between the last two frames carries them forward until the next one
+static void rx_interpolation_frame() {
+  const uint32_t time = time_micros();
+  const uint32_t delta = time - interp_start_us;
+
+  for (uint32_t i = 0; i < 4; i++) {
+    // no usable previous frame after startup or a dropout, hold until the next one
+    if (interp_start_us == 0 || delta < RX_FRAME_INTERVAL_MIN_US || delta > RX_FRAME_INTERVAL_MAX_US) {
+      interp_slope[i] = 0;
+    } else {
+      interp_slope[i] = (state.rx.axis[i] - interp_frame[i]) / delta;
+    }
+    interp_frame[i] = state.rx.axis[i];
+  }
+  interp_start_us = time;
+}
+
+static void rx_apply_interpolation() {
+  if (frame_interval_us == 0) {
+    state.rx_interpolated = state.rx;
     return;
   }
 
-  filter_lp_pt2_coeff(&rx_filter, state.rx_filter_hz);
+  // never extrapolate past one frame, a late frame holds instead of running away
+  const float dt = constrain((float)(time_micros() - interp_start_us), 0.0f, frame_interval_us);
+  state.rx_interpolated.roll = constrain(interp_frame[0] + interp_slope[0] * dt, -1.0f, 1.0f);
+  state.rx_interpolated.pitch = constrain(interp_frame[1] + interp_slope[1] * dt, -1.0f, 1.0f);
+  state.rx_interpolated.yaw = constrain(interp_frame[2] + interp_slope[2] * dt, -1.0f, 1.0f);
+  state.rx_interpolated.throttle = constrain(interp_frame[3] + interp_slope[3] * dt, 0.0f, 1.0f);
+}
 
+static void rx_apply_smoothing() {
   state.rx.roll = constrain(state.rx.roll, -1.0, 1.0);
   state.rx.pitch = constrain(state.rx.pitch, -1.0, 1.0);
   state.rx.yaw = constrain(state.rx.yaw, -1.0, 1.0);
   state.rx.throttle = constrain(state.rx.throttle, 0.0, 1.0);
 
-  state.rx_filtered.roll = constrain(filter_lp_pt2_step(&rx_filter, &rx_filter_state[0], state.rx.roll), -1.0, 1.0);
-  state.rx_filtered.pitch = constrain(filter_lp_pt2_step(&rx_filter, &rx_filter_state[1], state.rx.pitch), -1.0, 1.0);
-  state.rx_filtered.yaw = constrain(filter_lp_pt2_step(&rx_filter, &rx_filter_state[2], state.rx.yaw), -1.0, 1.0);
-  state.rx_filtered.throttle = constrain(filter_lp_pt2_step(&rx_filter, &rx_filter_state[3], state.rx.throttle), 0.0, 1.0);
+  rx_apply_interpolation();
+
+  if (state.rx_filter_hz <= 0.1f) {
+    state.rx_filtered = state.rx_interpolated;
+    return;
+  }
+
+  filter_coeff(RX_SMOOTHING_TYPE, &rx_filter, rx_filter_state, 4, state.rx_filter_hz, FILTER_DEFAULT_Q);
+
+  state.rx_filtered.roll = constrain(filter_step(RX_SMOOTHING_TYPE, &rx_filter, &rx_filter_state[0], state.rx_interpolated.roll), -1.0, 1.0);
+  state.rx_filtered.pitch = constrain(filter_step(RX_SMOOTHING_TYPE, &rx_filter, &rx_filter_state[1], state.rx_interpolated.pitch), -1.0, 1.0);
+  state.rx_filtered.yaw = constrain(filter_step(RX_SMOOTHING_TYPE, &rx_filter, &rx_filter_state[2], state.rx_interpolated.yaw), -1.0, 1.0);
+  state.rx_filtered.throttle = constrain(filter_step(RX_SMOOTHING_TYPE, &rx_filter, &rx_filter_state[3], state.rx_interpolated.throttle), 0.0, 1.0);
 }
 
 static float rx_apply_deadband(float val) {
@@ -125,7 +178,7 @@ static void rx_init_state() {
 #ifdef GESTURE_AUX_START_ON
   state.aux[AUX_CHANNEL_GESTURE] = 1;
 #endif
-  filter_lp_pt2_init(&rx_filter, rx_filter_state, 4, state.rx_filter_hz);
+  filter_init(RX_SMOOTHING_TYPE, &rx_filter, rx_filter_state, 4, state.rx_filter_hz, FILTER_DEFAULT_Q);
 }
 
 void rx_init() {
@@ -279,7 +332,6 @@ bool rx_check() {
 
 void rx_update() {
   static uint32_t rx_filter_start = 0;
-  static uint32_t rx_filter_counter = 0;
 
   if (rx_check()) {
     rx_apply_stick_scale();
@@ -288,19 +340,31 @@ void rx_update() {
     state.rx.pitch = rx_apply_deadband(state.rx.pitch);
     state.rx.yaw = rx_apply_deadband(state.rx.yaw);
 
-    rx_filter_counter += 1;
+    rx_interpolation_frame();
+    latency_stamp(LATENCY_STAGE_DECODE);
   }
 
-  const uint32_t rx_filter_delta = (time_millis() - rx_filter_start);
-  if (rx_filter_delta > RX_FITER_SAMPLE_TIME) {
-    const float sample_hz = (float)rx_filter_counter / ((float)rx_filter_delta / 1000.0f);
+  if ((time_millis() - rx_filter_start) > RX_FITER_SAMPLE_TIME) {
+    // only re-derived every few seconds, the pid controller recompiles on every change
+    if (frame_interval_us > 0) {
+      state.rx_frame_hz = rintf(1e6f / frame_interval_us);
+      state.rx_filter_hz = rintf(state.rx_frame_hz * 0.45f);
+    } else {
+      state.rx_frame_hz = 0;
+      state.rx_filter_hz = 0;
+    }
+
+    // extrapolation adds no delay, only the group delay of the smoothing filter remains
+    state.rx_setpoint_delay_us = 0;
+    if (state.rx_filter_hz > 0.1f) {
+      state.rx_setpoint_delay_us += filter_delay_us(RX_SMOOTHING_TYPE, state.rx_filter_hz, FILTER_DEFAULT_Q);
+    }
 
-    state.rx_filter_hz = rintf(sample_hz * 0.45f);
     rx_filter_start = time_millis();
-    rx_filter_counter = 0;
   }
 
   rx_apply_smoothing();
+  latency_stamp(LATENCY_STAGE_SMOOTHING);
 }
 
 void rx_stop() {
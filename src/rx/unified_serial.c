@@ -6,6 +6,7 @@
 
 #include "core/debug.h"
 #include "core/flash.h"
+#include "core/latency.h"
 #include "core/profile.h"
 #include "core/project.h"
 #include "driver/serial.h"
@@ -214,5 +215,15 @@ bool rx_serial_check() {
     flags.rx_ready = 1;
   }
 
+  if (status == PACKET_CHANNELS_RECEIVED) {
+    // the frame ended with the last byte the isr saw, unless the next one is already
+    // coming in, then it ended at the idle gap in front of that
+    if (serial_bytes_available(&serial_rx) == 0) {
+      latency_stamp_at(LATENCY_STAGE_ARRIVAL, serial_rx.rx_cycles);
+    } else {
+      latency_stamp_at(LATENCY_STAGE_ARRIVAL, serial_rx.rx_frame_cycles);
+    }
+  }
+
   return status == PACKET_CHANNELS_RECEIVED;
 }
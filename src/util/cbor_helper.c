@@ -31,10 +31,18 @@ cbor_result_t cbor_decode_float_array(cbor_value_t *enc, float *array, uint32_t
   cbor_container_t container;
   CBOR_CHECK_ERROR(cbor_result_t res = cbor_decode_array(enc, &container))
 
-  for (uint32_t i = 0; i < size; i++) {
+  // shorter arrays leave the remaining elements untouched, the size is asked
+  // every iteration as indefinite arrays only know it once the break is reached
+  uint32_t i = 0;
+  for (; i < size && i < cbor_decode_array_size(enc, &container); i++) {
     CBOR_CHECK_ERROR(res = cbor_decode_float(enc, &array[i]));
   }
 
+  // longer ones are skipped so the decoder stays in place for whatever follows
+  for (; i < cbor_decode_array_size(enc, &container); i++) {
+    CBOR_CHECK_ERROR(res = cbor_decode_skip(enc));
+  }
+
   return res;
 }
 
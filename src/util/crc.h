@@ -3,4 +3,14 @@
 #include <stdint.h>
 
 uint8_t crc8_dvb_s2_calc(uint8_t crc, const uint8_t input);
-uint8_t crc8_dvb_s2_data(uint8_t crc, const uint8_t *data, const uint32_t size);
\ No newline at end of file
+uint8_t crc8_dvb_s2_data(uint8_t crc, const uint8_t *data, const uint32_t size);
+
+uint16_t crc16_xmodem_calc(uint16_t crc, const uint8_t input);
+uint16_t crc16_xmodem_data(uint16_t crc, const uint8_t *data, const uint32_t size);
+
+uint16_t crc14_elrs_data(uint16_t crc, const volatile uint8_t *data, const uint32_t size);
+uint16_t crc16_elrs_data(uint16_t crc, const volatile uint8_t *data, const uint32_t size);
+
+uint16_t crc16_frsky_data(uint16_t crc, const uint8_t *data, const uint32_t size);
+
+uint8_t crc_xor_data(uint8_t chksum, const uint8_t *data, const uint32_t size);
\ No newline at end of file
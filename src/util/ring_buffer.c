@@ -9,6 +9,13 @@ uint32_t ring_buffer_free(ring_buffer_t *c) {
   return (c->tail - c->head);
 }
 
+static void ring_buffer_update_peak(ring_buffer_t *c) {
+  const uint32_t used = ring_buffer_available(c);
+  if (used > c->peak) {
+    c->peak = used;
+  }
+}
+
 uint8_t ring_buffer_write(ring_buffer_t *c, uint8_t data) {
   const uint32_t next = (c->head + 1) % c->size;
   if (next == c->tail)
@@ -16,6 +23,7 @@ uint8_t ring_buffer_write(ring_buffer_t *c, uint8_t data) {
 
   c->buffer[c->head] = data;
   c->head = next;
+  ring_buffer_update_peak(c);
   return 1;
 }
 
@@ -23,12 +31,14 @@ uint32_t ring_buffer_write_multi(ring_buffer_t *c, const uint8_t *data, const ui
   for (uint32_t i = 0; i < len; i++) {
     const uint32_t next = (c->head + 1) % c->size;
     if (next == c->tail) {
+      ring_buffer_update_peak(c);
       return i;
     }
 
     c->buffer[c->head] = data[i];
     c->head = next;
   }
+  ring_buffer_update_peak(c);
   return len;
 }
 
@@ -9,6 +9,7 @@ typedef struct {
   volatile uint32_t head;
   volatile uint32_t tail;
   const uint32_t size;
+  uint32_t peak; // highest fill level seen by a write
 } ring_buffer_t;
 
 uint32_t ring_buffer_free(ring_buffer_t *c);
@@ -102,15 +102,18 @@ float atan2approx(float y, float x) {
 // from http://en.wikipedia.org/wiki/Fast_inverse_square_root
 // originally from quake3 code
 float Q_rsqrt(float number) {
-  long i;
+  // 32bit on every target and on the host replay build
+  union {
+    float f;
+    int32_t i;
+  } bits;
   float x2, y;
   const float threehalfs = 1.5F;
 
   x2 = number * 0.5F;
-  y = number;
-  i = *(long *)&y;
-  i = 0x5f3759df - (i >> 1);
-  y = *(float *)&i;
+  bits.f = number;
+  bits.i = 0x5f3759df - (bits.i >> 1);
+  y = bits.f;
   y = y * (threehalfs - (x2 * y * y)); // 1st iteration
   y = y * (threehalfs - (x2 * y * y)); // 2nd iteration, this can be removed
                                        //	y  = y * ( threehalfs - ( x2 * y * y ) );   // 3nd iteration, this can be removed
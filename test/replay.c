@@ -0,0 +1,502 @@
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "core/profile.h"
+#include "driver/motor.h"
+#include "flight/control.h"
+#include "flight/filter.h"
+#include "flight/imu.h"
+#include "flight/input.h"
+#include "flight/motor.h"
+#include "flight/pid.h"
+#include "flight/sixaxis.h"
+#include "io/blackbox.h"
+#include "util/cbor_helper.h"
+
+// host replay of a recorded blackbox file through the gyro filter slots, the attitude estimator
+// and the rates -> pid -> mixer stages of the control loop.
+// input is a raw blackbox file as stored on the flash, one cbor record after another.
+// the control stages run on the config.h defaults, quad x and the first pid preset
+//
+// usage: replay [-f field_flags] [-l looptime_us] [-r blackbox_rate] [-1 type:hz:q] [-2 type:hz:q] [-c type:hz:q] file
+
+#define MAX_LAG_SAMPLES 64
+
+control_state_t state;
+control_flags_t flags;
+profile_t profile;
+uint32_t profile_generation;
+target_t target;
+motor_test_t motor_test;
+
+static rate_t rates = {
+    .mode = RATE_MODE_SILVERWARE,
+    .rate = {
+        {{MAX_RATE, MAX_RATE, MAX_RATEYAW}},
+        {{ACRO_EXPO_ROLL, ACRO_EXPO_PITCH, ACRO_EXPO_YAW}},
+        {{ANGLE_EXPO_ROLL, ANGLE_EXPO_PITCH, ANGLE_EXPO_YAW}},
+    },
+};
+
+typedef struct {
+  filter_type_t type;
+  float hz;
+  float q;
+} replay_slot_t;
+
+typedef struct {
+  const char *name;
+  replay_slot_t slots[2];
+
+  filter_t filter[2];
+  filter_state_t filter_state[2][3];
+
+  float *out;
+  uint64_t ns;
+} replay_chain_t;
+
+static blackbox_t *records = NULL;
+static uint32_t record_count = 0;
+static uint32_t record_cursor = 0;
+
+static const char *filter_names[] = {
+    [FILTER_NONE] = "none",
+    [FILTER_LP_PT1] = "pt1",
+    [FILTER_LP_PT2] = "pt2",
+    [FILTER_LP_PT3] = "pt3",
+    [FILTER_LP_BIQUAD] = "biquad",
+    [FILTER_LP_BIQUAD4] = "biquad4",
+    [FILTER_NOTCH] = "notch",
+    [FILTER_BANDPASS] = "bandpass",
+    [FILTER_LEAD_LAG] = "leadlag",
+    [FILTER_KALMAN] = "kalman",
+};
+
+static uint64_t now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void parse_slot(const char *arg, replay_slot_t *slot) {
+  char name[16] = {0};
+  slot->hz = 0;
+  slot->q = 0;
+  sscanf(arg, "%15[^:]:%f:%f", name, &slot->hz, &slot->q);
+
+  for (uint32_t i = 0; i < sizeof(filter_names) / sizeof(filter_names[0]); i++) {
+    if (strcmp(name, filter_names[i]) == 0) {
+      slot->type = i;
+      return;
+    }
+  }
+
+  fprintf(stderr, "unknown filter type %s\n", name);
+  exit(1);
+}
+
+static cbor_result_t cbor_decode_blackbox_t(cbor_value_t *dec, blackbox_t *b, const uint32_t field_flags) {
+  cbor_result_t res = CBOR_OK;
+
+  cbor_container_t array;
+  CBOR_CHECK_ERROR(res = cbor_decode_array(dec, &array));
+
+  CBOR_CHECK_ERROR(res = cbor_decode_uint32_t(dec, &b->loop));
+  CBOR_CHECK_ERROR(res = cbor_decode_uint32_t(dec, &b->time));
+
+  if (field_flags & (1 << BBOX_FIELD_PID_P_TERM)) {
+    CBOR_CHECK_ERROR(res = cbor_decode_compact_vec3_t(dec, &b->pid_p_term));
+  }
+  if (field_flags & (1 << BBOX_FIELD_PID_I_TERM)) {
+    CBOR_CHECK_ERROR(res = cbor_decode_compact_vec3_t(dec, &b->pid_i_term));
+  }
+  if (field_flags & (1 << BBOX_FIELD_PID_D_TERM)) {
+    CBOR_CHECK_ERROR(res = cbor_decode_compact_vec3_t(dec, &b->pid_d_term));
+  }
+  if (field_flags & (1 << BBOX_FIELD_RX)) {
+    CBOR_CHECK_ERROR(res = cbor_decode_compact_vec4_t(dec, &b->rx));
+  }
+  if (field_flags & (1 << BBOX_FIELD_SETPOINT)) {
+    CBOR_CHECK_ERROR(res = cbor_decode_compact_vec4_t(dec, &b->setpoint));
+  }
+  if (field_flags & (1 << BBOX_FIELD_ACCEL_RAW)) {
+    CBOR_CHECK_ERROR(res = cbor_decode_compact_vec3_t(dec, &b->accel_raw));
+  }
+  if (field_flags & (1 << BBOX_FIELD_ACCEL_FILTER)) {
+    CBOR_CHECK_ERROR(res = cbor_decode_compact_vec3_t(dec, &b->accel_filter));
+  }
+  if (field_flags & (1 << BBOX_FIELD_GYRO_RAW)) {
+    CBOR_CHECK_ERROR(res = cbor_decode_compact_vec3_t(dec, &b->gyro_raw));
+  }
+  if (field_flags & (1 << BBOX_FIELD_GYRO_FILTER)) {
+    CBOR_CHECK_ERROR(res = cbor_decode_compact_vec3_t(dec, &b->gyro_filter));
+  }
+
+  // motor, cpu load, debug and latency are regenerated or not needed
+  while (cbor_decode_array_size(dec, &array) != 0) {
+    CBOR_CHECK_ERROR(res = cbor_decode_skip(dec));
+  }
+
+  return res;
+}
+
+static uint32_t load_records(const char *path, uint32_t field_flags) {
+  FILE *f = fopen(path, "rb");
+  if (f == NULL) {
+    perror(path);
+    exit(1);
+  }
+
+  fseek(f, 0, SEEK_END);
+  const long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  uint8_t *data = malloc(size);
+  if (fread(data, 1, size, f) != (size_t)size) {
+    perror(path);
+    exit(1);
+  }
+  fclose(f);
+
+  // every record is at least a few bytes, this is an upper bound
+  records = calloc(size / 4 + 1, sizeof(blackbox_t));
+
+  cbor_value_t dec;
+  cbor_decoder_init(&dec, data, size);
+
+  uint32_t count = 0;
+  while (dec.curr < dec.end) {
+    if (cbor_decode_blackbox_t(&dec, &records[count], field_flags) < CBOR_OK) {
+      // a truncated last record is expected when the quad lost power
+      break;
+    }
+    count++;
+  }
+
+  free(data);
+  return count;
+}
+
+static void record_to_state(const blackbox_t *b) {
+  for (uint32_t i = 0; i < 3; i++) {
+    state.gyro_raw.axis[i] = b->gyro_raw.axis[i] / (float)BLACKBOX_SCALE;
+    state.accel_raw.axis[i] = b->accel_raw.axis[i] / (float)BLACKBOX_SCALE;
+  }
+}
+
+// imu_init pulls its samples through sixaxis_read, feed it from the log instead
+void sixaxis_read() {
+  if (record_cursor < record_count) {
+    record_to_state(&records[record_cursor++]);
+  }
+}
+
+void time_delay_us(uint32_t us) {}
+
+rate_t *profile_current_rates() {
+  return &rates;
+}
+
+// the mixer output is the last replayed stage, nothing drives the motors
+void motor_set(motor_position_t pos, float pwm) {}
+
+static void chain_init(replay_chain_t *chain) {
+  for (uint32_t i = 0; i < 2; i++) {
+    filter_init(chain->slots[i].type, &chain->filter[i], chain->filter_state[i], 3, chain->slots[i].hz, chain->slots[i].q);
+  }
+  chain->out = calloc(record_count * 3, sizeof(float));
+  chain->ns = 0;
+}
+
+static void chain_run(replay_chain_t *chain) {
+  const uint64_t start = now_ns();
+  for (uint32_t n = 0; n < record_count; n++) {
+    for (uint32_t i = 0; i < 3; i++) {
+      float v = records[n].gyro_raw.axis[i] / (float)BLACKBOX_SCALE;
+      v = filter_step(chain->slots[0].type, &chain->filter[0], &chain->filter_state[0][i], v);
+      v = filter_step(chain->slots[1].type, &chain->filter[1], &chain->filter_state[1][i], v);
+      chain->out[n * 3 + i] = v;
+    }
+  }
+  chain->ns = now_ns() - start;
+}
+
+// lag in samples at which the output best matches the raw input
+static uint32_t chain_lag(const replay_chain_t *chain, uint32_t axis) {
+  uint32_t best_lag = 0;
+  double best = -INFINITY;
+  for (uint32_t lag = 0; lag < MAX_LAG_SAMPLES && lag < record_count; lag++) {
+    double sum = 0;
+    for (uint32_t n = lag; n < record_count; n++) {
+      sum += chain->out[n * 3 + axis] * (records[n - lag].gyro_raw.axis[axis] / (double)BLACKBOX_SCALE);
+    }
+    sum /= (record_count - lag);
+    if (sum > best) {
+      best = sum;
+      best_lag = lag;
+    }
+  }
+  return best_lag;
+}
+
+// rms of the sample to sample difference, a proxy for the noise left in the signal
+static double chain_noise(const replay_chain_t *chain, uint32_t axis) {
+  double sum = 0;
+  for (uint32_t n = 1; n < record_count; n++) {
+    const double d = chain->out[n * 3 + axis] - chain->out[(n - 1) * 3 + axis];
+    sum += d * d;
+  }
+  return sqrt(sum / (record_count - 1));
+}
+
+static double raw_noise(uint32_t axis) {
+  double sum = 0;
+  for (uint32_t n = 1; n < record_count; n++) {
+    const double d = (records[n].gyro_raw.axis[axis] - records[n - 1].gyro_raw.axis[axis]) / (double)BLACKBOX_SCALE;
+    sum += d * d;
+  }
+  return sqrt(sum / (record_count - 1));
+}
+
+static void chain_report(const replay_chain_t *chain, float sample_us) {
+  printf("%s: %s:%g:%g -> %s:%g:%g, %.1f ns/sample\n", chain->name,
+         filter_names[chain->slots[0].type], chain->slots[0].hz, chain->slots[0].q,
+         filter_names[chain->slots[1].type], chain->slots[1].hz, chain->slots[1].q,
+         (double)chain->ns / record_count);
+
+  static const char *axis_names[] = {"roll", "pitch", "yaw"};
+  for (uint32_t i = 0; i < 3; i++) {
+    printf("  %-5s noise %.1f%% of raw, delay %.0fus\n", axis_names[i],
+           100.0 * chain_noise(chain, i) / fmax(raw_noise(i), 1e-9), chain_lag(chain, i) * sample_us);
+  }
+}
+
+// regenerated chain against the gyro_filter the quad logged, only matches when no dynamic filters ran
+static void chain_compare_logged(const replay_chain_t *chain) {
+  double sum = 0;
+  for (uint32_t n = 0; n < record_count; n++) {
+    for (uint32_t i = 0; i < 3; i++) {
+      const double d = chain->out[n * 3 + i] - records[n].gyro_filter.axis[i] / (double)BLACKBOX_SCALE;
+      sum += d * d;
+    }
+  }
+  printf("  rms error against logged gyro_filter %.4f rad/s\n", sqrt(sum / (record_count * 3)));
+}
+
+static void imu_replay(const replay_chain_t *chain, float looptime) {
+  // blackbox only records while armed
+  flags.on_ground = 0;
+
+  // the loop rate estimator only updates the attitude in horizon
+  profile.receiver.aux[AUX_HORIZON] = AUX_CHANNEL_ON;
+  state.aux[AUX_CHANNEL_ON] = 1;
+  state.looptime = looptime;
+
+  record_cursor = 0;
+  imu_init();
+
+  uint64_t ns = 0;
+  uint32_t samples = 0;
+  double error_sum = 0;
+
+  for (uint32_t n = record_cursor; n < record_count; n++) {
+    record_to_state(&records[n]);
+    for (uint32_t i = 0; i < 3; i++) {
+      state.gyro.axis[i] = chain->out[n * 3 + i];
+      state.gyro_delta_angle.axis[i] = state.gyro.axis[i] * state.looptime;
+    }
+
+    const uint64_t start = now_ns();
+    imu_calc();
+    ns += now_ns() - start;
+
+    // gravity estimate against the accel whenever the accel is a clean 1g reference
+    const float accmag = vec3_magnitude(&state.accel_raw);
+    if (accmag > 0.95f && accmag < 1.05f) {
+      const double dot = (state.GEstG.roll * state.accel_raw.roll + state.GEstG.pitch * state.accel_raw.pitch + state.GEstG.yaw * state.accel_raw.yaw) / (vec3_magnitude(&state.GEstG) * accmag);
+      const double angle = acos(fmin(fmax(dot, -1.0), 1.0));
+      error_sum += angle * angle;
+      samples++;
+    }
+  }
+
+  printf("imu: %.1f ns/loop\n", (double)ns / (record_count - record_cursor));
+  if (samples) {
+    printf("  rms gravity error %.2f deg over %u quiet samples\n", sqrt(error_sum / samples) / DEGTORAD, samples);
+  }
+  printf("  final attitude roll %.1f pitch %.1f yaw %.1f deg\n", state.attitude.roll, state.attitude.pitch, state.attitude.yaw);
+}
+
+static void control_defaults() {
+  target.brushless = 1;
+
+  profile.pid.pid_rates[PID_PROFILE_1] = (pid_rate_t){
+      .kp = {{54, 54, 56}},
+      .ki = {{70, 70, 70}},
+      .kd = {{33, 33, 4}},
+  };
+  profile.pid.throttle_dterm_attenuation = (throttle_dterm_attenuation_t){
+#ifdef THROTTLE_D_ATTENUATION
+      .tda_active = THROTTLE_D_ATTENUATION_ACTIVE,
+#endif
+      .tda_breakpoint = TDA_BREAKPOINT,
+      .tda_percent = TDA_PERCENT,
+  };
+
+  profile.filter.dterm[0] = (profile_filter_parameter_t){DTERM_PASS1_TYPE, DTERM_PASS1_FREQ, DTERM_PASS1_Q};
+  profile.filter.dterm[1] = (profile_filter_parameter_t){DTERM_PASS2_TYPE, DTERM_PASS2_FREQ, DTERM_PASS2_Q};
+#ifdef DTERM_DYNAMIC_LPF
+  profile.filter.dterm_dynamic_enable = 1;
+#endif
+  profile.filter.dterm_dynamic_min = DTERM_DYNAMIC_FREQ_MIN;
+  profile.filter.dterm_dynamic_max = DTERM_DYNAMIC_FREQ_MAX;
+
+  profile.motor.motor_limit = MOTOR_LIMIT;
+  profile.motor.motor_count = 4;
+  profile.motor.mixer[0] = (vec4_t){{+1.0f, +1.0f, +1.0f, 1.0f}};
+  profile.motor.mixer[1] = (vec4_t){{+1.0f, -1.0f, -1.0f, 1.0f}};
+  profile.motor.mixer[2] = (vec4_t){{-1.0f, +1.0f, -1.0f, 1.0f}};
+  profile.motor.mixer[3] = (vec4_t){{-1.0f, -1.0f, +1.0f, 1.0f}};
+}
+
+// acro only: sticks -> rates -> pid -> mixer, each stage timed on its own
+static void control_replay(const replay_chain_t *chain, float looptime, uint32_t field_flags) {
+  control_defaults();
+
+  flags.arm_state = 1;
+  flags.in_air = 1;
+  state.looptime = looptime;
+  state.timefactor = 0.0032f / looptime;
+  pid_init();
+
+  uint64_t ns_rates = 0;
+  uint64_t ns_pid = 0;
+  uint64_t ns_mixer = 0;
+  double setpoint_error = 0;
+
+  for (uint32_t n = 0; n < record_count; n++) {
+    const blackbox_t *b = &records[n];
+    for (uint32_t i = 0; i < 4; i++) {
+      state.rx_filtered.axis[i] = b->rx.axis[i] / (float)BLACKBOX_SCALE;
+    }
+    for (uint32_t i = 0; i < 3; i++) {
+      state.gyro.axis[i] = chain->out[n * 3 + i];
+      state.gyro_delta_angle.axis[i] = state.gyro.axis[i] * looptime;
+    }
+    state.throttle = state.rx_filtered.throttle;
+
+    uint64_t start = now_ns();
+    state.setpoint = input_rates_calc();
+    ns_rates += now_ns() - start;
+
+    for (uint32_t i = 0; i < 3; i++) {
+      state.error.axis[i] = state.setpoint.axis[i] - state.gyro.axis[i];
+      const double d = state.setpoint.axis[i] - b->setpoint.axis[i] / (double)BLACKBOX_SCALE;
+      setpoint_error += d * d;
+    }
+
+    start = now_ns();
+    pid_calc();
+    ns_pid += now_ns() - start;
+
+    float mix[MOTOR_PIN_MAX];
+    start = now_ns();
+    motor_mixer_calc(mix);
+    ns_mixer += now_ns() - start;
+  }
+
+  printf("control: rates %.1f ns/loop, pid %.1f ns/loop, mixer %.1f ns/loop\n",
+         (double)ns_rates / record_count, (double)ns_pid / record_count, (double)ns_mixer / record_count);
+  if (field_flags & (1 << BBOX_FIELD_SETPOINT)) {
+    // only matches when the quad flew acro on the default rates
+    printf("  rms error against logged setpoint %.4f rad/s\n", sqrt(setpoint_error / (record_count * 3)));
+  }
+}
+
+int main(int argc, char **argv) {
+  uint32_t field_flags = UINT32_MAX;
+  uint32_t looptime_us = 250;
+  uint32_t blackbox_rate = 1;
+
+  replay_chain_t gyro = {
+      .name = "gyro",
+      .slots = {
+          {FILTER_LP_PT3, 100, 0},
+          {FILTER_NONE, 0, 0},
+      },
+  };
+  replay_chain_t compare = {
+      .name = "compare",
+  };
+  bool has_compare = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "f:l:r:1:2:c:")) != -1) {
+    switch (opt) {
+    case 'f':
+      field_flags = strtoul(optarg, NULL, 0);
+      break;
+    case 'l':
+      looptime_us = strtoul(optarg, NULL, 0);
+      break;
+    case 'r':
+      blackbox_rate = strtoul(optarg, NULL, 0);
+      break;
+    case '1':
+      parse_slot(optarg, &gyro.slots[0]);
+      break;
+    case '2':
+      parse_slot(optarg, &gyro.slots[1]);
+      break;
+    case 'c':
+      parse_slot(optarg, &compare.slots[0]);
+      has_compare = true;
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-f field_flags] [-l looptime_us] [-r blackbox_rate] [-1 type:hz:q] [-2 type:hz:q] [-c type:hz:q] file\n", argv[0]);
+      return 1;
+    }
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "no blackbox file given\n");
+    return 1;
+  }
+
+  record_count = load_records(argv[optind], field_flags);
+  if (record_count == 0) {
+    fprintf(stderr, "no records decoded\n");
+    return 1;
+  }
+
+  // filters run at the rate the samples were recorded at
+  const uint32_t sample_us = looptime_us * blackbox_rate;
+  state.looptime_autodetect = sample_us;
+  printf("%u records, %.1fs at %uus\n", record_count, record_count * sample_us * 1e-6, sample_us);
+
+  chain_init(&gyro);
+  chain_run(&gyro);
+  chain_report(&gyro, sample_us);
+  if (field_flags & (1 << BBOX_FIELD_GYRO_FILTER)) {
+    chain_compare_logged(&gyro);
+  }
+
+  if (has_compare) {
+    chain_init(&compare);
+    chain_run(&compare);
+    chain_report(&compare, sample_us);
+  }
+
+  if (field_flags & (1 << BBOX_FIELD_RX)) {
+    control_replay(&gyro, sample_us * 1e-6f, field_flags);
+  }
+
+  if (field_flags & (1 << BBOX_FIELD_ACCEL_RAW)) {
+    imu_replay(&gyro, sample_us * 1e-6f);
+  }
+
+  return 0;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+// host stand-in for the firmware profile, the replay tool passes settings on the command line
+
+#include <stdint.h>
+
+#include "core/project.h"
+#include "flight/filter.h"
+#include "rx/rx.h"
+#include "util/vector.h"
+
+typedef enum {
+  RATE_MODE_SILVERWARE,
+  RATE_MODE_BETAFLIGHT,
+  RATE_MODE_ACTUAL,
+} __attribute__((__packed__)) rate_modes_t;
+
+typedef enum {
+  SILVERWARE_MAX_RATE,
+  SILVERWARE_ACRO_EXPO,
+  SILVERWARE_ANGLE_EXPO,
+} __attribute__((__packed__)) silverware_rates_t;
+
+typedef enum {
+  BETAFLIGHT_RC_RATE,
+  BETAFLIGHT_SUPER_RATE,
+  BETAFLIGHT_EXPO,
+} __attribute__((__packed__)) betaflight_rates_t;
+
+typedef enum {
+  ACTUAL_CENTER_SENSITIVITY,
+  ACTUAL_MAX_RATE,
+  ACTUAL_EXPO,
+} __attribute__((__packed__)) actual_rates_t;
+
+typedef struct {
+  rate_modes_t mode;
+  vec3_t rate[3];
+} rate_t;
+
+typedef struct {
+  float level_max_angle;
+  float throttle_mid;
+  float throttle_expo;
+} profile_rate_t;
+
+typedef struct {
+  vec3_t kp;
+  vec3_t ki;
+  vec3_t kd;
+} pid_rate_t;
+
+typedef enum {
+  PID_PROFILE_1,
+  PID_PROFILE_2,
+  PID_PROFILE_MAX
+} __attribute__((__packed__)) pid_profile_t;
+
+typedef struct {
+  vec3_t accelerator;
+  vec3_t transition;
+  vec3_t feedforward;
+} stick_rate_t;
+
+typedef enum {
+  STICK_PROFILE_OFF,
+  STICK_PROFILE_ON,
+  STICK_PROFILE_MAX
+} __attribute__((__packed__)) stick_profile_t;
+
+typedef enum {
+  THROTTLE_D_ATTENTUATION_NONE,
+  THROTTLE_D_ATTENUATION_ACTIVE,
+  THROTTLE_D_ATTENUATION_MAX,
+} __attribute__((__packed__)) tda_active_t;
+
+typedef struct {
+  tda_active_t tda_active;
+  float tda_breakpoint;
+  float tda_percent;
+} throttle_dterm_attenuation_t;
+
+typedef struct {
+  pid_profile_t pid_profile;
+  pid_rate_t pid_rates[PID_PROFILE_MAX];
+  stick_profile_t stick_profile;
+  stick_rate_t stick_rates[STICK_PROFILE_MAX];
+  throttle_dterm_attenuation_t throttle_dterm_attenuation;
+} profile_pid_t;
+
+typedef enum {
+  PID_VOLTAGE_COMPENSATION_NONE,
+  PID_VOLTAGE_COMPENSATION_ACTIVE,
+} __attribute__((__packed__)) pid_voltage_compensation_t;
+
+typedef struct {
+  pid_voltage_compensation_t pid_voltage_compensation;
+} profile_voltage_t;
+
+typedef struct {
+  filter_type_t type;
+  float cutoff_freq;
+  float q;
+} profile_filter_parameter_t;
+
+typedef struct {
+  profile_filter_parameter_t gyro[FILTER_MAX_SLOTS];
+  profile_filter_parameter_t dterm[FILTER_MAX_SLOTS];
+  uint8_t dterm_dynamic_enable;
+  float dterm_dynamic_min;
+  float dterm_dynamic_max;
+} profile_filter_t;
+
+typedef struct {
+  aux_channel_t aux[AUX_FUNCTION_MAX];
+} profile_receiver_t;
+
+typedef struct {
+  float digital_idle;
+  float motor_limit;
+  uint8_t invert_yaw;
+  float torque_boost;
+  float thrust_linearization;
+  float vbat_sag_compensation;
+  uint8_t motor_count;
+  vec4_t mixer[MOTOR_PIN_MAX];
+} profile_motor_t;
+
+typedef struct {
+  profile_motor_t motor;
+  profile_rate_t rate;
+  profile_pid_t pid;
+  profile_filter_t filter;
+  profile_voltage_t voltage;
+  profile_receiver_t receiver;
+} profile_t;
+
+extern profile_t profile;
+extern uint32_t profile_generation;
+
+rate_t *profile_current_rates();
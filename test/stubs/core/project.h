@@ -0,0 +1,16 @@
+#pragma once
+
+// host stand-in for the firmware project header, no memory sections off target
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "config/config.h"
+#include "core/target.h"
+
+#define FAST_RAM
+#define FAST_CODE
+#define DMA_RAM
+
+// only read by get_chip_uid, which is never called on the host
+#define UID_BASE 0
@@ -0,0 +1,23 @@
+#pragma once
+
+// host stand-in for the target description, only what the tested modules read
+
+#include <stdint.h>
+
+typedef enum {
+  MOTOR_PIN0,
+  MOTOR_PIN1,
+  MOTOR_PIN2,
+  MOTOR_PIN3,
+  MOTOR_PIN4,
+  MOTOR_PIN5,
+  MOTOR_PIN6,
+  MOTOR_PIN7,
+  MOTOR_PIN_MAX
+} __attribute__((__packed__)) motor_pin_t;
+
+typedef struct {
+  uint8_t brushless;
+} target_t;
+
+extern target_t target;
@@ -0,0 +1,61 @@
+#pragma once
+
+// host stand-in for the firmware control state, only what the tested modules read
+
+#include <stdint.h>
+
+#include "core/project.h"
+#include "rx/rx.h"
+#include "util/vector.h"
+
+typedef struct {
+  uint8_t arm_state;
+  uint8_t on_ground;
+  uint8_t in_air;
+  uint8_t motortest_override;
+} control_flags_t;
+
+extern control_flags_t flags;
+
+typedef struct {
+  float looptime;
+  float timefactor;
+  uint8_t aux[AUX_CHANNEL_MAX];
+
+  uint8_t lipo_cell_count;
+  float vbat_filtered;
+  float vbat_filtered_decay;
+
+  vec4_t rx_filtered;
+  float rx_filter_hz;
+  float throttle;
+  float thrsum;
+  uint16_t looptime_autodetect;
+
+  vec3_t accel_raw;
+  vec3_t accel;
+
+  vec3_t gyro_raw;
+  vec3_t gyro;
+  vec3_t gyro_delta_angle;
+
+  vec3_t GEstG;
+  vec3_t attitude;
+
+  vec3_t setpoint;
+  vec3_t error;
+
+  vec3_t pid_p_term;
+  vec3_t pid_i_term;
+  vec3_t pid_d_term;
+  vec3_t pid_ff_term;
+  vec3_t pidoutput;
+} control_state_t;
+
+typedef struct {
+  uint8_t active;
+  float value[MOTOR_PIN_MAX];
+} motor_test_t;
+
+extern control_state_t state;
+extern motor_test_t motor_test;
@@ -0,0 +1,3 @@
+#pragma once
+
+// host stand-in, the usb configurator is not built for the host
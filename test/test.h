@@ -0,0 +1,52 @@
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// minimal host test helpers, every test_*.c builds into its own binary
+
+static int test_failures = 0;
+
+#define TEST_CHECK(cond)                                               \
+  do {                                                                 \
+    if (!(cond)) {                                                     \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      test_failures++;                                                 \
+    }                                                                  \
+  } while (0)
+
+#define TEST_CHECK_EQ(a, b)                                                                              \
+  do {                                                                                                   \
+    const long long _a = (long long)(a);                                                                 \
+    const long long _b = (long long)(b);                                                                 \
+    if (_a != _b) {                                                                                      \
+      printf("%s:%d: %s == %s failed: 0x%llx != 0x%llx\n", __FILE__, __LINE__, #a, #b, _a, _b);          \
+      test_failures++;                                                                                   \
+    }                                                                                                    \
+  } while (0)
+
+#define TEST_CHECK_NEAR(a, b, tol)                                                                   \
+  do {                                                                                               \
+    const double _a = (double)(a);                                                                   \
+    const double _b = (double)(b);                                                                   \
+    if (!(fabs(_a - _b) <= (tol))) {                                                                 \
+      printf("%s:%d: %s ~ %s failed: %g != %g (tol %g)\n", __FILE__, __LINE__, #a, #b, _a, _b, tol); \
+      test_failures++;                                                                               \
+    }                                                                                                \
+  } while (0)
+
+#define TEST_RUN(fn)   \
+  do {                 \
+    printf("%s\n", #fn); \
+    fn();              \
+  } while (0)
+
+#define TEST_EXIT()                                 \
+  do {                                              \
+    if (test_failures) {                            \
+      printf("%d check(s) failed\n", test_failures); \
+      return 1;                                     \
+    }                                               \
+    return 0;                                       \
+  } while (0)
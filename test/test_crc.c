@@ -0,0 +1,126 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "test.h"
+#include "util/crc.h"
+
+static const uint8_t check_input[] = "123456789";
+
+static bool hw_enabled = false;
+static uint32_t hw_calls = 0;
+
+// bitwise msb first crc, the same generator the runtime tables were built from before
+static uint32_t crc_reference(uint8_t bits, uint32_t poly, uint32_t crc, const uint8_t *data, uint32_t size) {
+  const uint32_t highbit = 1u << (bits - 1);
+  const uint32_t mask = bits == 32 ? 0xFFFFFFFF : (1u << bits) - 1;
+
+  for (uint32_t i = 0; i < size; i++) {
+    crc ^= (uint32_t)data[i] << (bits - 8);
+    for (uint32_t j = 0; j < 8; j++) {
+      crc = (crc & highbit) ? (crc << 1) ^ poly : crc << 1;
+    }
+    crc &= mask;
+  }
+  return crc;
+}
+
+// frsky d16 applies the reflected ccitt table msb first
+static uint16_t crc_frsky_reference(uint16_t crc, const uint8_t *data, uint32_t size) {
+  uint16_t tab[256];
+  for (uint32_t i = 0; i < 256; i++) {
+    uint16_t v = i;
+    for (uint32_t j = 0; j < 8; j++) {
+      v = (v & 1) ? (v >> 1) ^ 0x8408 : v >> 1;
+    }
+    tab[i] = v;
+  }
+
+  for (uint32_t i = 0; i < size; i++) {
+    crc = (crc << 8) ^ tab[((crc >> 8) ^ data[i]) & 0xFF];
+  }
+  return crc;
+}
+
+// stands in for the peripheral, computes the same crc the unit would
+bool crc_hw_calc(uint8_t bits, uint32_t poly, uint32_t *crc, const uint8_t *data, uint32_t size) {
+  if (!hw_enabled) {
+    return false;
+  }
+  hw_calls++;
+  *crc = crc_reference(bits, poly, *crc, data, size);
+  return true;
+}
+
+static void fill_random(uint8_t *data, uint32_t size, uint32_t seed) {
+  for (uint32_t i = 0; i < size; i++) {
+    seed = seed * 1103515245 + 12345;
+    data[i] = seed >> 16;
+  }
+}
+
+static void test_check_values() {
+  TEST_CHECK_EQ(crc8_dvb_s2_data(0, check_input, 9), 0xBC);
+  TEST_CHECK_EQ(crc16_xmodem_data(0, check_input, 9), 0x31C3);
+  TEST_CHECK_EQ(crc_xor_data(0, check_input, 9), 0x31);
+
+  // one byte through the frsky table is the table entry itself
+  const uint8_t one = 1;
+  TEST_CHECK_EQ(crc16_frsky_data(0, &one, 1), 0x1189);
+}
+
+// every length crosses the slice-by-4 and byte tail boundaries, and the hardware threshold
+static void test_software_paths() {
+  uint8_t data[300];
+  fill_random(data, sizeof(data), 1);
+
+  hw_enabled = false;
+  for (uint32_t size = 0; size < sizeof(data); size++) {
+    const uint8_t seed8 = size * 7;
+    const uint16_t seed16 = size * 0x1357;
+
+    TEST_CHECK_EQ(crc8_dvb_s2_data(seed8, data, size), crc_reference(8, 0xD5, seed8, data, size));
+    TEST_CHECK_EQ(crc16_xmodem_data(seed16, data, size), crc_reference(16, 0x1021, seed16, data, size));
+    TEST_CHECK_EQ(crc14_elrs_data(seed16 & 0x3FFF, data, size), crc_reference(14, 0x2E57, seed16 & 0x3FFF, data, size));
+    TEST_CHECK_EQ(crc16_elrs_data(seed16, data, size), crc_reference(16, 0x3D65, seed16, data, size));
+    TEST_CHECK_EQ(crc16_frsky_data(seed16, data, size), crc_frsky_reference(seed16, data, size));
+  }
+}
+
+static void test_byte_calc_matches_data() {
+  uint8_t data[64];
+  fill_random(data, sizeof(data), 2);
+
+  hw_enabled = false;
+  uint8_t crc8 = 0;
+  uint16_t crc16 = 0;
+  for (uint32_t i = 0; i < sizeof(data); i++) {
+    crc8 = crc8_dvb_s2_calc(crc8, data[i]);
+    crc16 = crc16_xmodem_calc(crc16, data[i]);
+  }
+  TEST_CHECK_EQ(crc8, crc8_dvb_s2_data(0, data, sizeof(data)));
+  TEST_CHECK_EQ(crc16, crc16_xmodem_data(0, data, sizeof(data)));
+}
+
+// short buffers stay in software, long ones go to the unit and must give the same result
+static void test_hardware_paths() {
+  uint8_t data[256];
+  fill_random(data, sizeof(data), 3);
+
+  hw_enabled = true;
+  hw_calls = 0;
+  TEST_CHECK_EQ(crc16_xmodem_data(0, data, 16), crc_reference(16, 0x1021, 0, data, 16));
+  TEST_CHECK_EQ(hw_calls, 0);
+
+  TEST_CHECK_EQ(crc8_dvb_s2_data(0x5A, data, sizeof(data)), crc_reference(8, 0xD5, 0x5A, data, sizeof(data)));
+  TEST_CHECK_EQ(crc16_xmodem_data(0x1234, data, sizeof(data)), crc_reference(16, 0x1021, 0x1234, data, sizeof(data)));
+  TEST_CHECK_EQ(hw_calls, 2);
+  hw_enabled = false;
+}
+
+int main() {
+  TEST_RUN(test_check_values);
+  TEST_RUN(test_software_paths);
+  TEST_RUN(test_byte_calc_matches_data);
+  TEST_RUN(test_hardware_paths);
+  TEST_EXIT();
+}
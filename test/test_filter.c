@@ -0,0 +1,168 @@
+#include <math.h>
+#include <string.h>
+
+#include "flight/control.h"
+#include "flight/filter.h"
+#include "test.h"
+
+#define PERIOD_US 125
+#define SAMPLE_HZ (1e6 / PERIOD_US)
+
+control_state_t state = {
+    .looptime_autodetect = PERIOD_US,
+};
+
+// steady state amplitude of a unit sine at hz
+static double filter_gain(filter_type_t type, float cutoff, float q, double hz) {
+  filter_t filter;
+  filter_state_t filter_state;
+  filter_init(type, &filter, &filter_state, 1, cutoff, q);
+
+  const uint32_t settle = SAMPLE_HZ;
+  const uint32_t measure = SAMPLE_HZ / 2;
+
+  double peak = 0;
+  for (uint32_t i = 0; i < settle + measure; i++) {
+    const double in = sin(2.0 * M_PI * hz * i / SAMPLE_HZ);
+    const double out = filter_step(type, &filter, &filter_state, in);
+    if (i >= settle && fabs(out) > peak) {
+      peak = fabs(out);
+    }
+  }
+  return peak;
+}
+
+static void test_lp_biquad_response() {
+  TEST_CHECK_NEAR(filter_gain(FILTER_LP_BIQUAD, 100, FILTER_DEFAULT_Q, 10), 1.0, 0.01);
+  TEST_CHECK_NEAR(filter_gain(FILTER_LP_BIQUAD, 100, FILTER_DEFAULT_Q, 100), M_SQRT1_2, 0.01);
+  // -40db per decade
+  TEST_CHECK_NEAR(filter_gain(FILTER_LP_BIQUAD, 100, FILTER_DEFAULT_Q, 1000), 0.01, 0.003);
+}
+
+static void test_lp_biquad4_response() {
+  TEST_CHECK_NEAR(filter_gain(FILTER_LP_BIQUAD4, 100, 0, 10), 1.0, 0.01);
+  TEST_CHECK_NEAR(filter_gain(FILTER_LP_BIQUAD4, 100, 0, 100), M_SQRT1_2, 0.01);
+  // -80db per decade, far below the 2nd order section
+  TEST_CHECK(filter_gain(FILTER_LP_BIQUAD4, 100, 0, 1000) < 0.0005);
+}
+
+static void test_notch_response() {
+  TEST_CHECK(filter_gain(FILTER_NOTCH, 200, 5, 200) < 0.01);
+  TEST_CHECK_NEAR(filter_gain(FILTER_NOTCH, 200, 5, 20), 1.0, 0.01);
+  TEST_CHECK_NEAR(filter_gain(FILTER_NOTCH, 200, 5, 1000), 1.0, 0.02);
+}
+
+static void test_bandpass_response() {
+  TEST_CHECK_NEAR(filter_gain(FILTER_BANDPASS, 200, 2, 200), 1.0, 0.01);
+  TEST_CHECK(filter_gain(FILTER_BANDPASS, 200, 2, 20) < 0.1);
+  TEST_CHECK(filter_gain(FILTER_BANDPASS, 200, 2, 2000) < 0.1);
+}
+
+static void test_lead_lag_response() {
+  // lead with the pole a decade above the zero, unity at dc, ~10x at high frequencies
+  TEST_CHECK_NEAR(filter_gain(FILTER_LEAD_LAG, 20, 10, 1), 1.0, 0.02);
+  TEST_CHECK(filter_gain(FILTER_LEAD_LAG, 20, 10, 1000) > 7.0);
+}
+
+static void test_pt1_response() {
+  TEST_CHECK_NEAR(filter_gain(FILTER_LP_PT1, 100, 0, 100), M_SQRT1_2, 0.02);
+}
+
+// approximately gaussian, deterministic so the bounds hold on every run
+static double noise_sample(uint32_t *seed) {
+  double sum = 0;
+  for (uint32_t i = 0; i < 12; i++) {
+    *seed = *seed * 1103515245 + 12345;
+    sum += (*seed >> 8) / (double)(1 << 24);
+  }
+  return sum - 6.0;
+}
+
+// output std deviation for white noise of the given std deviation
+static double filter_noise_out(filter_type_t type, float cutoff, float q, double noise) {
+  filter_t filter;
+  filter_state_t filter_state;
+  filter_init(type, &filter, &filter_state, 1, cutoff, q);
+
+  uint32_t seed = 1;
+  double sum = 0;
+  const uint32_t settle = 1000;
+  const uint32_t measure = SAMPLE_HZ;
+  for (uint32_t i = 0; i < settle + measure; i++) {
+    const double out = filter_step(type, &filter, &filter_state, noise * noise_sample(&seed));
+    if (i >= settle) {
+      sum += out * out;
+    }
+  }
+  return sqrt(sum / measure);
+}
+
+// the profile default q lands on the default reference noise, not on 0.707 rad/s
+static void test_kalman_default_q() {
+  filter_t with_q;
+  filter_t without_q;
+  filter_state_t filter_state;
+  filter_init(FILTER_KALMAN, &with_q, &filter_state, 1, 100, FILTER_DEFAULT_Q);
+  filter_init(FILTER_KALMAN, &without_q, &filter_state, 1, 100, 0);
+  TEST_CHECK_NEAR(with_q.kalman.process_noise, without_q.kalman.process_noise, without_q.kalman.process_noise * 1e-4);
+}
+
+// at the reference noise the kalman filters about as hard as the pt1, above it harder
+static void test_kalman_adapts() {
+  const double pt1_ref = filter_noise_out(FILTER_LP_PT1, 100, 0, FILTER_KALMAN_DEFAULT_NOISE);
+  const double kalman_ref = filter_noise_out(FILTER_KALMAN, 100, FILTER_DEFAULT_Q, FILTER_KALMAN_DEFAULT_NOISE);
+  TEST_CHECK_NEAR(kalman_ref / pt1_ref, 1.0, 0.3);
+
+  const double pt1_loud = filter_noise_out(FILTER_LP_PT1, 100, 0, 10 * FILTER_KALMAN_DEFAULT_NOISE);
+  const double kalman_loud = filter_noise_out(FILTER_KALMAN, 100, FILTER_DEFAULT_Q, 10 * FILTER_KALMAN_DEFAULT_NOISE);
+  TEST_CHECK(kalman_loud < 0.5 * pt1_loud);
+}
+
+// switching the type of a slot at the same cutoff must not keep the old coefficients
+static void test_type_switch() {
+  filter_t filter;
+  filter_state_t filter_state;
+
+  filter_init(FILTER_NOTCH, &filter, &filter_state, 1, 100, FILTER_DEFAULT_Q);
+  filter_coeff(FILTER_LP_BIQUAD4, &filter, &filter_state, 1, 100, FILTER_DEFAULT_Q);
+  TEST_CHECK_EQ(filter.type, FILTER_LP_BIQUAD4);
+  TEST_CHECK_EQ(filter.biquad.sections, 2);
+
+  filter_t reference;
+  filter_state_t reference_state;
+  filter_init(FILTER_KALMAN, &reference, &reference_state, 1, 100, FILTER_DEFAULT_Q);
+
+  // biquad -> kalman shares the hz / q / period layout
+  filter_init(FILTER_LP_BIQUAD, &filter, &filter_state, 1, 100, FILTER_DEFAULT_Q);
+  for (uint32_t i = 0; i < 100; i++) {
+    filter_step(FILTER_LP_BIQUAD, &filter, &filter_state, 1.0f);
+  }
+  filter_coeff(FILTER_KALMAN, &filter, &filter_state, 1, 100, FILTER_DEFAULT_Q);
+  TEST_CHECK_EQ(filter.type, FILTER_KALMAN);
+  TEST_CHECK(filter.kalman.process_noise == reference.kalman.process_noise);
+  TEST_CHECK(filter.kalman.min_noise == reference.kalman.min_noise);
+
+  // state is cleared on the switch
+  for (uint32_t i = 0; i < 4; i++) {
+    TEST_CHECK(filter_state.delay_element[i] == 0.0f);
+  }
+
+  // pt1 -> pt2 at the same cutoff uses the pt2 correction
+  filter_init(FILTER_LP_PT1, &filter, &filter_state, 1, 100, 0);
+  const float pt1_alpha = filter.lp_pt1.alpha;
+  filter_coeff(FILTER_LP_PT2, &filter, &filter_state, 1, 100, 0);
+  TEST_CHECK(filter.lp_pt2.alpha != pt1_alpha);
+}
+
+int main() {
+  TEST_RUN(test_lp_biquad_response);
+  TEST_RUN(test_lp_biquad4_response);
+  TEST_RUN(test_notch_response);
+  TEST_RUN(test_bandpass_response);
+  TEST_RUN(test_lead_lag_response);
+  TEST_RUN(test_pt1_response);
+  TEST_RUN(test_kalman_default_q);
+  TEST_RUN(test_kalman_adapts);
+  TEST_RUN(test_type_switch);
+  TEST_EXIT();
+}
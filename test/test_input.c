@@ -0,0 +1,117 @@
+#include "test.h"
+
+// built together with the module so the analytic curves are the ones the tables are made from
+#include "flight/input.c"
+
+control_state_t state;
+profile_t profile;
+
+static rate_t rates;
+
+rate_t *profile_current_rates() {
+  return &rates;
+}
+
+static void set_rates(rate_modes_t mode, vec3_t a, vec3_t b, vec3_t c) {
+  rates.mode = mode;
+  rates.rate[0] = a;
+  rates.rate[1] = b;
+  rates.rate[2] = c;
+}
+
+// worst case table error over the whole stick range in deg/s, acro expo
+static double rates_max_error() {
+  vec3_t acro_expo, angle_expo;
+  input_get_expo(&rates, &acro_expo, &angle_expo);
+
+  double error = 0;
+  for (int32_t i = -1000; i <= 1000; i++) {
+    const float rc = i / 1000.0f;
+    state.rx_filtered.roll = rc;
+    state.rx_filtered.pitch = rc;
+    state.rx_filtered.yaw = rc;
+
+    const vec3_t out = input_rates_calc();
+    for (uint32_t axis = 0; axis < 3; axis++) {
+      const float expected = calc_rates(&rates, axis, rc, acro_expo.axis[axis]);
+      error = fmax(error, fabs(out.axis[axis] - expected) / DEGTORAD);
+    }
+  }
+  return error;
+}
+
+static void test_silverware_bounds() {
+  set_rates(RATE_MODE_SILVERWARE, (vec3_t){{860, 860, 500}}, (vec3_t){{0.8f, 0.8f, 0.6f}}, (vec3_t){{0.55f, 0.0f, 0.55f}});
+  TEST_CHECK(rates_max_error() < 0.5);
+}
+
+static void test_betaflight_bounds() {
+  set_rates(RATE_MODE_BETAFLIGHT, (vec3_t){{1.0f, 1.0f, 1.0f}}, (vec3_t){{0.7f, 0.7f, 0.7f}}, (vec3_t){{0.0f, 0.0f, 0.0f}});
+  TEST_CHECK(rates_max_error() < 0.5);
+
+  // an aggressive super rate is where the curve bends hardest towards full stick
+  set_rates(RATE_MODE_BETAFLIGHT, (vec3_t){{1.2f, 1.2f, 1.2f}}, (vec3_t){{0.8f, 0.8f, 0.8f}}, (vec3_t){{0.3f, 0.3f, 0.3f}});
+  TEST_CHECK(rates_max_error() < 2.0);
+}
+
+static void test_actual_bounds() {
+  set_rates(RATE_MODE_ACTUAL, (vec3_t){{70, 70, 70}}, (vec3_t){{670, 670, 670}}, (vec3_t){{0.0f, 0.0f, 0.0f}});
+  TEST_CHECK(rates_max_error() < 0.5);
+
+  set_rates(RATE_MODE_ACTUAL, (vec3_t){{200, 200, 200}}, (vec3_t){{1000, 1000, 1000}}, (vec3_t){{0.7f, 0.7f, 0.7f}});
+  TEST_CHECK(rates_max_error() < 1.0);
+}
+
+// the curves are odd and the table is mirrored, full stick hits the analytic end point
+static void test_rates_symmetric() {
+  set_rates(RATE_MODE_BETAFLIGHT, (vec3_t){{1.0f, 1.0f, 1.0f}}, (vec3_t){{0.7f, 0.7f, 0.7f}}, (vec3_t){{0.2f, 0.2f, 0.2f}});
+
+  state.rx_filtered.roll = 1.0f;
+  const float full = input_rates_calc().roll;
+  TEST_CHECK_NEAR(full, calc_rates(&rates, 0, 1.0f, 0.2f), 1e-3);
+
+  state.rx_filtered.roll = -1.0f;
+  TEST_CHECK(input_rates_calc().roll == -full);
+
+  state.rx_filtered.roll = 0.0f;
+  TEST_CHECK(input_rates_calc().roll == 0.0f);
+}
+
+// editing the active rates rebuilds the tables on the next call
+static void test_rates_rebuild() {
+  set_rates(RATE_MODE_ACTUAL, (vec3_t){{70, 70, 70}}, (vec3_t){{670, 670, 670}}, (vec3_t){{0.0f, 0.0f, 0.0f}});
+  state.rx_filtered.roll = 1.0f;
+  TEST_CHECK_NEAR(input_rates_calc().roll / DEGTORAD, 670, 0.01);
+
+  rates.rate[ACTUAL_MAX_RATE].roll = 900;
+  TEST_CHECK_NEAR(input_rates_calc().roll / DEGTORAD, 900, 0.01);
+}
+
+static void test_throttle_bounds() {
+  const float expos[] = {0.0f, 0.3f, 0.8f};
+  const float mids[] = {0.3f, 0.5f, 0.7f};
+
+  for (uint32_t e = 0; e < 3; e++) {
+    for (uint32_t m = 0; m < 3; m++) {
+      profile.rate.throttle_expo = expos[e];
+      profile.rate.throttle_mid = mids[m];
+
+      double error = 0;
+      for (uint32_t i = 0; i <= 1000; i++) {
+        const float throttle = i / 1000.0f;
+        error = fmax(error, fabs(input_throttle_calc(throttle) - calc_throttle(throttle, expos[e], mids[m])));
+      }
+      TEST_CHECK(error < 0.001);
+    }
+  }
+}
+
+int main() {
+  TEST_RUN(test_silverware_bounds);
+  TEST_RUN(test_betaflight_bounds);
+  TEST_RUN(test_actual_bounds);
+  TEST_RUN(test_rates_symmetric);
+  TEST_RUN(test_rates_rebuild);
+  TEST_RUN(test_throttle_bounds);
+  TEST_EXIT();
+}
@@ -0,0 +1,310 @@
+#include <string.h>
+
+#include "core/profile.h"
+#include "driver/motor.h"
+#include "flight/control.h"
+#include "flight/motor.h"
+#include "test.h"
+
+control_state_t state;
+control_flags_t flags;
+profile_t profile;
+target_t target;
+motor_test_t motor_test;
+
+static float motor_outputs[MOTOR_PIN_MAX];
+
+void motor_set(motor_position_t pos, float pwm) {
+  motor_outputs[pos] = pwm;
+}
+
+typedef struct {
+  const char *name;
+  uint8_t motor_count;
+  vec4_t mixer[MOTOR_PIN_MAX];
+} test_frame_t;
+
+// same matrices as the profile presets
+static const test_frame_t frames[] = {
+    {
+        .name = "quad x",
+        .motor_count = 4,
+        .mixer = {
+            {{+1.0f, +1.0f, +1.0f, 1.0f}},
+            {{+1.0f, -1.0f, -1.0f, 1.0f}},
+            {{-1.0f, +1.0f, -1.0f, 1.0f}},
+            {{-1.0f, -1.0f, +1.0f, 1.0f}},
+        },
+    },
+    {
+        .name = "quad +",
+        .motor_count = 4,
+        .mixer = {
+            {{+0.0f, +1.0f, +1.0f, 1.0f}},
+            {{+1.0f, +0.0f, -1.0f, 1.0f}},
+            {{-1.0f, +0.0f, -1.0f, 1.0f}},
+            {{+0.0f, -1.0f, +1.0f, 1.0f}},
+        },
+    },
+    {
+        .name = "hex x",
+        .motor_count = 6,
+        .mixer = {
+            {{+0.5f, +0.866025f, -1.0f, 1.0f}},
+            {{+0.5f, -0.866025f, -1.0f, 1.0f}},
+            {{-0.5f, +0.866025f, +1.0f, 1.0f}},
+            {{-0.5f, -0.866025f, +1.0f, 1.0f}},
+            {{-1.0f, +0.0f, -1.0f, 1.0f}},
+            {{+1.0f, +0.0f, +1.0f, 1.0f}},
+        },
+    },
+    {
+        .name = "octo flat x",
+        .motor_count = 8,
+        .mixer = {
+            {{+0.414214f, +1.0f, +1.0f, 1.0f}},
+            {{+0.414214f, -1.0f, -1.0f, 1.0f}},
+            {{-0.414214f, +1.0f, -1.0f, 1.0f}},
+            {{-0.414214f, -1.0f, +1.0f, 1.0f}},
+            {{-1.0f, -0.414214f, -1.0f, 1.0f}},
+            {{+1.0f, -0.414214f, +1.0f, 1.0f}},
+            {{-1.0f, +0.414214f, +1.0f, 1.0f}},
+            {{+1.0f, +0.414214f, -1.0f, 1.0f}},
+        },
+    },
+    {
+        .name = "octo x8",
+        .motor_count = 8,
+        .mixer = {
+            {{+1.0f, +1.0f, +1.0f, 1.0f}},
+            {{+1.0f, -1.0f, -1.0f, 1.0f}},
+            {{-1.0f, +1.0f, -1.0f, 1.0f}},
+            {{-1.0f, -1.0f, +1.0f, 1.0f}},
+            {{+1.0f, +1.0f, -1.0f, 1.0f}},
+            {{+1.0f, -1.0f, +1.0f, 1.0f}},
+            {{-1.0f, +1.0f, +1.0f, 1.0f}},
+            {{-1.0f, -1.0f, -1.0f, 1.0f}},
+        },
+    },
+};
+
+#define FRAME_COUNT (sizeof(frames) / sizeof(frames[0]))
+
+static void setup(const test_frame_t *frame) {
+  memset(&profile, 0, sizeof(profile));
+  memset(&state, 0, sizeof(state));
+  memset(&flags, 0, sizeof(flags));
+
+  target.brushless = 1;
+  profile.motor.motor_limit = 100;
+  profile.motor.motor_count = frame->motor_count;
+  memcpy(profile.motor.mixer, frame->mixer, sizeof(frame->mixer));
+
+  flags.arm_state = 1;
+  flags.in_air = 1;
+}
+
+static float pid_mix(const test_frame_t *frame, uint32_t i) {
+  const vec4_t *w = &frame->mixer[i];
+  return w->roll * state.pidoutput.roll + w->pitch * state.pidoutput.pitch + w->yaw * state.pidoutput.yaw;
+}
+
+// the result must be scale * pid mix + common throttle, ie the demanded ratios survive desaturation
+static void check_desaturated(const test_frame_t *frame, const float mix[MOTOR_PIN_MAX], float limit) {
+  float min = mix[0];
+  float max = mix[0];
+  uint32_t lo = 0;
+  uint32_t hi = 0;
+  for (uint32_t i = 0; i < frame->motor_count; i++) {
+    TEST_CHECK(mix[i] >= -1e-5f);
+    TEST_CHECK(mix[i] <= limit + 1e-5f);
+    if (mix[i] < min) {
+      min = mix[i];
+      lo = i;
+    }
+    if (mix[i] > max) {
+      max = mix[i];
+      hi = i;
+    }
+  }
+
+  const float demand = pid_mix(frame, hi) - pid_mix(frame, lo);
+  if (demand < 1e-6f) {
+    return;
+  }
+  const float scale = (max - min) / demand;
+  const float throttle = max - scale * pid_mix(frame, hi);
+  for (uint32_t i = 0; i < frame->motor_count; i++) {
+    TEST_CHECK_NEAR(mix[i], scale * pid_mix(frame, i) + throttle, 1e-4);
+  }
+}
+
+static void test_small_command_passes() {
+  for (uint32_t f = 0; f < FRAME_COUNT; f++) {
+    setup(&frames[f]);
+    state.throttle = 0.5f;
+    state.pidoutput = (vec3_t){{0.1f, -0.05f, 0.02f}};
+
+    float mix[MOTOR_PIN_MAX];
+    motor_mixer_calc(mix);
+    for (uint32_t i = 0; i < frames[f].motor_count; i++) {
+      TEST_CHECK_NEAR(mix[i], pid_mix(&frames[f], i) + 0.5f, 1e-5);
+    }
+    for (uint32_t i = frames[f].motor_count; i < MOTOR_PIN_MAX; i++) {
+      TEST_CHECK(mix[i] == 0.0f);
+    }
+  }
+}
+
+// a command wider than the output range is scaled down to fit exactly
+static void test_large_command_scaled() {
+  for (uint32_t f = 0; f < FRAME_COUNT; f++) {
+    setup(&frames[f]);
+    state.throttle = 0.5f;
+    state.pidoutput = (vec3_t){{1.5f, 0.7f, -0.4f}};
+
+    float mix[MOTOR_PIN_MAX];
+    motor_mixer_calc(mix);
+    check_desaturated(&frames[f], mix, 1.0f);
+
+    float min = 1, max = 0;
+    for (uint32_t i = 0; i < frames[f].motor_count; i++) {
+      min = fminf(min, mix[i]);
+      max = fmaxf(max, mix[i]);
+    }
+    TEST_CHECK_NEAR(max - min, 1.0, 1e-4);
+  }
+}
+
+// near full and zero throttle the throttle gives way, not the command
+static void test_throttle_gives_way() {
+  for (uint32_t f = 0; f < FRAME_COUNT; f++) {
+    const float throttles[] = {0.0f, 0.05f, 0.95f, 1.0f};
+    for (uint32_t t = 0; t < 4; t++) {
+      setup(&frames[f]);
+      state.throttle = throttles[t];
+      state.pidoutput = (vec3_t){{0.2f, -0.1f, 0.05f}};
+
+      float mix[MOTOR_PIN_MAX];
+      motor_mixer_calc(mix);
+      check_desaturated(&frames[f], mix, 1.0f);
+
+      // the full command survives, it fits the range
+      for (uint32_t i = 1; i < frames[f].motor_count; i++) {
+        TEST_CHECK_NEAR(mix[i] - mix[0], pid_mix(&frames[f], i) - pid_mix(&frames[f], 0), 1e-4);
+      }
+    }
+  }
+}
+
+// with a sagging pack the headroom left after compensation is what desaturation fills
+static void test_sag_headroom() {
+  const float linearization[] = {0.0f, 50.0f, 100.0f};
+  for (uint32_t l = 0; l < 3; l++) {
+    for (uint32_t f = 0; f < FRAME_COUNT; f++) {
+      setup(&frames[f]);
+      profile.motor.vbat_sag_compensation = 100;
+      profile.motor.thrust_linearization = linearization[l];
+      state.lipo_cell_count = 4;
+      state.vbat_filtered = 4 * 3.5f;
+      state.throttle = 0.9f;
+      state.pidoutput = (vec3_t){{0.6f, 0.3f, 0.1f}};
+
+      float mix[MOTOR_PIN_MAX];
+      motor_mixer_calc(mix);
+      motor_output_calc(mix);
+
+      // the top motor lands at full output without being clipped
+      float max = 0;
+      for (uint32_t i = 0; i < frames[f].motor_count; i++) {
+        TEST_CHECK(motor_outputs[i] <= 1.0f);
+        max = fmaxf(max, motor_outputs[i]);
+      }
+      TEST_CHECK(max > 0.98f);
+
+
+      // without linearization the outputs are the desaturated mix times the sag factor
+      if (linearization[l] == 0.0f) {
+        const float sag = 4.2f / 3.5f;
+        float unscaled[MOTOR_PIN_MAX];
+        for (uint32_t i = 0; i < frames[f].motor_count; i++) {
+          unscaled[i] = motor_outputs[i] / sag;
+        }
+        check_desaturated(&frames[f], unscaled, 1.0f / sag);
+      }
+    }
+  }
+}
+
+// uneven throttle weights, eg a frame with larger rear props, the throttle is bounded per motor
+static void test_throttle_weights() {
+  static const test_frame_t frame = {
+      .name = "quad x weighted",
+      .motor_count = 4,
+      .mixer = {
+          {{+1.0f, +1.0f, +1.0f, 1.2f}},
+          {{+1.0f, -1.0f, -1.0f, 0.8f}},
+          {{-1.0f, +1.0f, -1.0f, 1.2f}},
+          {{-1.0f, -1.0f, +1.0f, 0.8f}},
+      },
+  };
+
+  const float throttles[] = {0.05f, 0.5f, 0.9f};
+  const vec3_t commands[] = {
+      {{0.2f, -0.1f, 0.05f}},
+      {{1.5f, 0.7f, -0.4f}},
+  };
+  for (uint32_t c = 0; c < 2; c++) {
+    for (uint32_t t = 0; t < 3; t++) {
+      setup(&frame);
+      state.throttle = throttles[t];
+      state.pidoutput = commands[c];
+
+      float mix[MOTOR_PIN_MAX];
+      motor_mixer_calc(mix);
+
+      float min = 1, max = 0;
+      for (uint32_t i = 0; i < frame.motor_count; i++) {
+        TEST_CHECK(mix[i] >= -1e-5f);
+        TEST_CHECK(mix[i] <= 1.0f + 1e-5f);
+        min = fminf(min, mix[i]);
+        max = fmaxf(max, mix[i]);
+      }
+
+      // solve scale and throttle from the best conditioned pair of motors, the rest must agree
+      uint32_t a = 0, b = 1;
+      float det = 0;
+      for (uint32_t i = 0; i < frame.motor_count; i++) {
+        for (uint32_t j = i + 1; j < frame.motor_count; j++) {
+          const float d = pid_mix(&frame, i) * frame.mixer[j].throttle - pid_mix(&frame, j) * frame.mixer[i].throttle;
+          if (fabsf(d) > fabsf(det)) {
+            det = d;
+            a = i;
+            b = j;
+          }
+        }
+      }
+      const float scale = (mix[a] * frame.mixer[b].throttle - mix[b] * frame.mixer[a].throttle) / det;
+      const float throttle = (pid_mix(&frame, a) * mix[b] - pid_mix(&frame, b) * mix[a]) / det;
+      TEST_CHECK(scale > 0.0f && scale <= 1.0f + 1e-5f);
+      for (uint32_t i = 0; i < frame.motor_count; i++) {
+        TEST_CHECK_NEAR(mix[i], scale * pid_mix(&frame, i) + throttle * frame.mixer[i].throttle, 1e-4);
+      }
+
+      // a scaled command uses the full output range
+      if (scale < 1.0f - 1e-5f) {
+        TEST_CHECK_NEAR(min, 0.0, 1e-4);
+        TEST_CHECK_NEAR(max, 1.0, 1e-4);
+      }
+    }
+  }
+}
+
+int main() {
+  TEST_RUN(test_small_command_passes);
+  TEST_RUN(test_large_command_scaled);
+  TEST_RUN(test_throttle_gives_way);
+  TEST_RUN(test_sag_headroom);
+  TEST_RUN(test_throttle_weights);
+  TEST_EXIT();
+}